@@ -22,6 +22,8 @@ set(__PPG_COUNT_TYPE ${__PPG_SMALL_UNSIGNED_INT_TYPE})
 
 set(__PPG_ID_TYPE ${__PPG_MEDIUM_SIGNED_INT_TYPE})
 
+set(__PPG_TOKEN_ID_TYPE uint32_t)
+
 set(__PPG_ACTION_FLAGS_TYPE ${__PPG_SMALL_UNSIGNED_INT_TYPE})
 
 set(__PPG_LAYER_TYPE ${__PPG_SMALL_SIGNED_INT_TYPE})
@@ -30,7 +32,7 @@ set(__PPG_SLOT_ID_TYPE ${__PPG_SMALL_UNSIGNED_INT_TYPE})
 
 set(__PPG_TIME_COMPARISON_RESULT_TYPE ${__PPG_SMALL_SIGNED_INT_TYPE})
 
-set(__PPG_EVENT_BUFFER_INDEX_TYPE ${__PPG_SMALL_SIGNED_INT_TYPE})
+set(__PPG_EVENT_BUFFER_INDEX_TYPE uint16_t)
 
 set(__PPG_PROCESSING_STATE_TYPE ${__PPG_SMALL_UNSIGNED_INT_TYPE})
 
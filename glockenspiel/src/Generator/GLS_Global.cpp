@@ -26,6 +26,7 @@
 #include "GLS_Compiler.hpp"
 
 #include <ostream>
+#include <sstream>
 #include <fstream>
 #include <iomanip>
 
@@ -174,6 +175,9 @@ void generateFileHeader(std::ostream &out) {
    defaults.outputC(out);
    
    out <<
+"// The event queue is a ring buffer whose capacity must be\n"
+"// a power of two. Overrides must respect this.\n"
+"//\n"
 "#ifndef GLS_EVENT_QUEUE_SIZE\n"
 "#define GLS_EVENT_QUEUE_SIZE(S) (S)\n"
 "#endif\n"
@@ -637,6 +641,15 @@ void recursivelyOutputTokenForwardDeclaration(std::ostream &out, const ParserTre
    }
 }
 
+void recursivelyOutputTokenState(std::ostream &out, const ParserTree::Token &token)
+{
+   token.generateStateCode(out);
+
+   for(const auto &childTokenPtr: token.getChildren()) {
+      recursivelyOutputTokenState(out, *childTokenPtr);
+   }
+}
+
 void recursivelyGetMaxEvents(const ParserTree::Token &token, int curDepth, int &maxDepth, int curInputs, int &maxInputs)
 {
    curInputs += token.getNumInputs();
@@ -680,6 +693,27 @@ void generateGlobalContext(std::ostream &out)
    startExternC(out);
 
    globallyInitializeAllEntities(out);
+   
+   // The matching state of the tokens that require more 
+   // than their misc bits
+   //
+   std::ostringstream tokenState;
+   recursivelyOutputTokenState(tokenState, *root);
+   
+   bool haveTokenData = !tokenState.str().empty();
+   
+   if(haveTokenData) {
+      
+      caption(out, "Token data");
+      
+      out <<
+"typedef struct {\n"
+<< tokenState.str() <<
+"} " << SP << "Token_Data;\n"
+"\n"
+<< SP << "Token_Data " << SP << "token_data = GLS_ZERO_INIT;\n"
+"\n";
+   }
 
    caption(out, "Token tree forward declarations");
    
@@ -703,8 +737,17 @@ void generateGlobalContext(std::ostream &out)
    
    int maxEvents = 2*maxInputs + 1;
    
+   // The event ring always keeps one slot free and its capacity
+   // must be a power of two.
+   //
+   int eventQueueCapacity = 1;
+   while(eventQueueCapacity < maxEvents + 1) {
+      eventQueueCapacity *= 2;
+   }
+   
    out <<
-"PPG_Event_Queue_Entry " << SP << "event_buffer[GLS_EVENT_QUEUE_SIZE((" << maxEvents << "))] = GLS_ZERO_INIT;\n"
+"PPG_Event " << SP << "event_buffer[GLS_EVENT_QUEUE_SIZE((" << eventQueueCapacity << "))] = GLS_ZERO_INIT;\n"
+"PPG_Event_Queue_Entry " << SP << "event_queue_entries[GLS_EVENT_QUEUE_SIZE((" << eventQueueCapacity << "))] = GLS_ZERO_INIT;\n"
 //    for(int i = 0; i < 2*maxEvents; ++i) {
 //       out <<
 // "                     {{0, 0, 0}, 0, {0, 0}}";
@@ -750,11 +793,12 @@ void generateGlobalContext(std::ostream &out)
 "PPG_Context " << SP << "context = {\n"
 "   __GLS_DI__(event_buffer) {\n"
 "      __GLS_DI__(events) " << SP << "event_buffer,\n"
+"      __GLS_DI__(entries) " << SP << "event_queue_entries,\n"
 "      __GLS_DI__(start) 0,\n"
 "      __GLS_DI__(end) 0,\n"
 "      __GLS_DI__(cur) 0,\n"
 "      __GLS_DI__(size) 0,\n"
-"      __GLS_DI__(max_size) GLS_EVENT_QUEUE_SIZE((" << maxEvents << "))\n";
+"      __GLS_DI__(mask) GLS_EVENT_QUEUE_SIZE((" << eventQueueCapacity << ")) - 1\n";
    out <<
 "   },\n"
 "   __GLS_DI__(furcation_stack) {\n"
@@ -771,14 +815,22 @@ void generateGlobalContext(std::ostream &out)
    out <<
 "   },\n"
 "   __GLS_DI__(pattern_root) &" << SP << root->getId().getText() << ",\n"
-"   __GLS_DI__(current_token) NULL,\n"
+"   __GLS_DI__(current_token) NULL,\n";
+   if(haveTokenData) {
+      out <<
+"   __GLS_DI__(token_data) (char*)&" << SP << "token_data,\n"
+"   __GLS_DI__(token_data_size) sizeof(" << SP << "Token_Data),\n";
+   }
+   out <<
 "   __GLS_DI__(properties) {\n"
 "      __GLS_DI__(timeout_enabled) " << MP << "GLS_INITIAL_TIMEOUT_ENABLED,\n"
 "      __GLS_DI__(papageno_enabled) " << MP << "GLS_INITIAL_PAPAGENO_ENABLED,\n"
 "#     if PPG_HAVE_LOGGING\n"
 "      __GLS_DI__(logging_enabled) " << MP << "GLS_INITIAL_LOGGING_ENABLED,\n"
 "#     endif\n"
-"      __GLS_DI__(destruction_enabled) false\n"
+"      __GLS_DI__(destruction_enabled) false,\n"
+"      __GLS_DI__(tree_shared) false,\n"
+"      __GLS_DI__(event_time_enabled) " << MP << "GLS_INITIAL_EVENT_TIME_ENABLED\n"
 "    },\n"
 "   __GLS_DI__(tree_depth) " << maxDepth << ",\n"
 "   __GLS_DI__(layer) " << MP << "GLS_INITIAL_LAYER,\n"
@@ -786,6 +838,7 @@ void generateGlobalContext(std::ostream &out)
 "   __GLS_DI__(time_last_event) 0,\n"
 "   __GLS_DI__(event_timeout) " << MP << "GLS_INITIAL_EVENT_TIMEOUT,\n"
 "   __GLS_DI__(event_processor) " << MP << "GLS_INITIAL_EVENT_PROCESSOR,\n"
+"   __GLS_DI__(event_span_processor) NULL,\n"
 "   __GLS_DI__(time_manager) {\n"
 "      __GLS_DI__(time) &" << MP << "GLS_INITIAL_TIME_FUNCTION,\n"
 "      __GLS_DI__(time_difference) &" << MP << "GLS_INITIAL_TIME_DIFFERENCE_FUNCTION,\n"
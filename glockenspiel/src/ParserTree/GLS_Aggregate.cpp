@@ -57,12 +57,6 @@ void
    Aggregate
       ::generateDependencyCodeInternal(std::ostream &out) const
 {   
-   std::size_t n_bits = inputs_.size();
-   
-   out <<
-"PPG_Bitfield_Storage_Type " << SP << this->getId().getText() << "_member_active[(GLS_NUM_BITS_LEFT(" << n_bits << ") != 0) ? (GLS_NUM_BYTES(" << n_bits << ") + 1) : GLS_NUM_BYTES(" << n_bits << ")]\n"
-"   = GLS_ZERO_INIT;\n\n";
-
    out <<
 "PPG_Input_Id " << SP << this->getId().getText() << "_inputs[" << inputs_.size() << "] = {\n";
 
@@ -98,13 +92,22 @@ void
 "   },\n"
 "   __GLS_DI__(n_members) " << inputs_.size() << ",\n" <<
 "   __GLS_DI__(inputs) " << SP << this->getId().getText() << "_inputs,\n" <<
-"   __GLS_DI__(member_active) {\n"
-"      __GLS_DI__(bitarray) " << SP << this->getId().getText() << "_member_active,\n" <<
-"      __GLS_DI__(n_bits) " << this->inputs_.size() << "\n" <<
-"   },\n"
-"   __GLS_DI__(n_inputs_active) 0\n";
+"   __GLS_DI__(state_offset) offsetof(" << SP << "Token_Data, " << SP << this->getId().getText() << "_state)\n";
 }      
 
+void 
+   Aggregate
+      ::generateStateCode(std::ostream &out) const
+{   
+   std::size_t n_bits = inputs_.size();
+   
+   // The bitfields directly follow the state
+   //
+   out <<
+"   PPG_Aggregate_State " << SP << this->getId().getText() << "_state;\n"
+"   PPG_Bitfield_Storage_Type " << SP << this->getId().getText() << "_bitfields[" << this->getNumStateBitfields() << "*((GLS_NUM_BITS_LEFT(" << n_bits << ") != 0) ? (GLS_NUM_BYTES(" << n_bits << ") + 1) : GLS_NUM_BYTES(" << n_bits << "))];\n";
+}
+
 void  
    Aggregate
       ::collectInputAssignments(InputAssignmentsByTag &iabt) const
@@ -43,8 +43,12 @@ class Aggregate : public Token
       
       virtual std::string getInputs() const override;
       
+      virtual void generateStateCode(std::ostream &out) const override;
+      
    protected:
       
+      virtual int getNumStateBitfields() const { return 1; }
+      
       virtual void generateDependencyCodeInternal(std::ostream &out) const override;
       
       virtual void generateCCodeInternal(std::ostream &out) const override;
@@ -31,26 +31,7 @@ void
 
    this->Aggregate::generateCCodeInternal(out);
    out <<
-"   },\n"
-"   __GLS_DI__(member_active_lasting) {\n"
-"      __GLS_DI__(bitarray) " << this->getId().getText() << "_member_active_lasting,\n" <<
-"      __GLS_DI__(n_bits) " << this->inputs_.size() << "\n" <<
-"   },\n"
-"   __GLS_DI__(n_lasting) 0\n";
-}
-
-void 
-   Cluster
-      ::generateDependencyCodeInternal(std::ostream &out) const
-{ 
-   std::size_t n_bits = inputs_.size();
-   
-   out <<
-"PPG_Bitfield_Storage_Type " << this->getId().getText() << "_member_active_lasting[(GLS_NUM_BITS_LEFT(" << n_bits << ") != 0) ? (GLS_NUM_BYTES(" << n_bits << ") + 1) : GLS_NUM_BYTES(" << n_bits << ")]\n"
-"   = GLS_ZERO_INIT;\n"
-"\n";
-
-   this->Aggregate::generateDependencyCodeInternal(out);
+"   }\n";
 }
 
 } // namespace ParserTree
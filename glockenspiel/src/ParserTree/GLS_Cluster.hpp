@@ -41,7 +41,11 @@ class Cluster : public Aggregate
       virtual std::string getEntitiesPath() const override { return "aggregate.inputs"; }
       
       virtual void generateCCodeInternal(std::ostream &out) const override;
-      virtual void generateDependencyCodeInternal(std::ostream &out) const override;
+      
+      // Clusters additionally keep track of the members
+      // that were activated at least once
+      //
+      virtual int getNumStateBitfields() const override { return 2; }
 };
 
 } // namespace ParserTree
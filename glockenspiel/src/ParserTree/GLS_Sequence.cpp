@@ -27,8 +27,7 @@ void
 
    this->Aggregate::generateCCodeInternal(out);
    out <<
-"   },\n"
-"   __GLS_DI__(next_member) 0\n";
+"   }\n";
 }
 
 } // namespace ParserTree
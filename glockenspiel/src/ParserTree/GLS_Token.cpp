@@ -85,40 +85,25 @@ void
 "      __GLS_DI__(parent) NULL,\n";
    }
    
+   // The initializers follow the member order of PPG_Token__ as they 
+   // are positional in C++.
+   //
    if(!children_.empty()) {
       out <<
 "      __GLS_DI__(children) " << SP << this->getId().getText() << "_children,\n" <<
-"      __GLS_DI__(n_allocated_children) sizeof(" << SP << this->getId().getText() << "_children)/sizeof(PPG_Token__*),\n" <<
 "      __GLS_DI__(n_children) sizeof(" << SP << this->getId().getText() << "_children)/sizeof(PPG_Token__*),\n";
    }
    else {
       out <<
 "      __GLS_DI__(children) NULL,\n"
-"      __GLS_DI__(n_allocated_children) 0,\n"
 "      __GLS_DI__(n_children) 0,\n";
    }
    
-   if(!action_.getText().empty()) {
-      const auto &actionPtr = Action::lookup(action_.getText());
-      out <<
-"      __GLS_DI__(action) " << MP << "GLS_ACTION_INITIALIZE_GLOBAL___" << actionPtr->getType().getText() << "("
-      << actionPtr->getUniqueId() << ", " << actionPtr->getId().getText();
-      if(actionPtr->getParametersDefined()) {
-         out << ", " << actionPtr->getParameters().getText();
-      }
-      out << "), // " 
-         << actionPtr->getId().getText() << ": " << actionPtr->getLOD() << "\n";
-   }
-   else {
-      
-      out <<
-"      __GLS_DI__(action) { \n"
-"         __GLS_DI__(callback) {\n"
-"            __GLS_DI__(func) NULL,\n"
-"            __GLS_DI__(user_data) NULL\n"
-"         }\n"
-"      },\n";
-   }         
+   // The id is assigned when the pattern tree is compiled
+   //
+   out <<
+"      __GLS_DI__(id) 0,\n";
+   
    out <<
 "      __GLS_DI__(misc) {\n"
 "         __GLS_DI__(state) PPG_Token_Initialized,\n"
@@ -139,7 +124,38 @@ void
    out << "\n"
 "      },\n";
    out <<
-"      __GLS_DI__(layer) " << this->layer_.getText() << "\n";
+"      __GLS_DI__(layer) " << this->layer_.getText() << ",\n";
+   
+   if(!children_.empty()) {
+      out <<
+"      __GLS_DI__(n_allocated_children) sizeof(" << SP << this->getId().getText() << "_children)/sizeof(PPG_Token__*),\n";
+   }
+   else {
+      out <<
+"      __GLS_DI__(n_allocated_children) 0,\n";
+   }
+   
+   if(!action_.getText().empty()) {
+      const auto &actionPtr = Action::lookup(action_.getText());
+      out <<
+"      __GLS_DI__(action) " << MP << "GLS_ACTION_INITIALIZE_GLOBAL___" << actionPtr->getType().getText() << "("
+      << actionPtr->getUniqueId() << ", " << actionPtr->getId().getText();
+      if(actionPtr->getParametersDefined()) {
+         out << ", " << actionPtr->getParameters().getText();
+      }
+      out << ") // " 
+         << actionPtr->getId().getText() << ": " << actionPtr->getLOD() << "\n";
+   }
+   else {
+      
+      out <<
+"      __GLS_DI__(action) { \n"
+"         __GLS_DI__(callback) {\n"
+"            __GLS_DI__(func) NULL,\n"
+"            __GLS_DI__(user_data) NULL\n"
+"         }\n"
+"      }\n";
+   }
 }
       
 }
@@ -135,6 +135,11 @@ class Token : public Node
       
       void generateCCode(std::ostream &out) const;
       
+      // Outputs the members of the token data struct that hold 
+      // the token's matching state, if any
+      //
+      virtual void generateStateCode(std::ostream &out) const {}
+      
       virtual std::string getNodeType() const override { return "Token"; }
       
       virtual void collectInputAssignments(InputAssignmentsByTag &iabt) const {}
@@ -58,6 +58,7 @@ void
    DEFAULT("time_difference_function", "ppg_default_time_difference")
    DEFAULT("time_comparison_function", "ppg_default_time_comparison")
    DEFAULT("timeout_enabled", "true")
+   DEFAULT("event_time_enabled", "false")
    DEFAULT("event_timeout", "1")
    DEFAULT("papageno_enabled", "true")
    DEFAULT("logging_enabled", "true")
@@ -16,6 +16,7 @@
 
 #include "detail/ppg_active_tokens_detail.h"
 #include "detail/ppg_token_detail.h"
+#include "detail/ppg_token_dispatch_detail.h"
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_signal_detail.h"
 #include "detail/ppg_malloc_detail.h"
@@ -26,23 +27,19 @@
 #include <string.h>
 
 void ppg_active_tokens_resize(PPG_Active_Tokens *active_tokens,
-                              PPG_Count new_size)
+                              PPG_Count new_size,
+                              PPG_Allocator *allocator)
 {
    PPG_ASSERT(active_tokens);
    
    if(new_size <= active_tokens->max_tokens) { return; }
    
-   PPG_Token__ **new_tokens
-      = (PPG_Token__**)PPG_MALLOC(sizeof(PPG_Token__*)*new_size);
+   active_tokens->tokens
+      = (PPG_Token__**)ppg_allocator_realloc(allocator,
+                                 active_tokens->tokens,
+                                 sizeof(PPG_Token__*)*new_size);
       
    active_tokens->max_tokens = new_size;
-   
-   if(active_tokens->tokens && (active_tokens->n_tokens > 0)) {
-      memcpy(new_tokens, active_tokens->tokens, 
-             sizeof(PPG_Token__ *)*active_tokens->n_tokens);
-   }
-   
-   active_tokens->tokens = new_tokens;
 }
 
 PPG_Count ppg_active_tokens_get_size(void)
@@ -50,34 +47,37 @@ PPG_Count ppg_active_tokens_get_size(void)
    return PPG_GAT.n_tokens;
 }
 
-void ppg_active_tokens_init(PPG_Active_Tokens *active_tokens)
+void ppg_active_tokens_init(PPG_Active_Tokens *active_tokens,
+                            PPG_Allocator *allocator)
 {
    active_tokens->tokens = NULL;
    active_tokens->n_tokens = 0;
    active_tokens->max_tokens = 0;
    
-   ppg_active_tokens_resize(active_tokens, PPG_MAX_ACTIVE_TOKENS);
+   ppg_active_tokens_resize(active_tokens, PPG_MAX_ACTIVE_TOKENS, allocator);
    
    for(size_t i = 0; i < PPG_MAX_ACTIVE_TOKENS; ++i) {
       active_tokens->tokens[i] = NULL;
    }
 }
 
-void ppg_active_tokens_restore(PPG_Active_Tokens *active_tokens)
+void ppg_active_tokens_restore(PPG_Active_Tokens *active_tokens,
+                               PPG_Allocator *allocator)
 {
    PPG_Count saved_size = active_tokens->max_tokens;
    
    active_tokens->tokens = NULL;
    active_tokens->max_tokens = 0; // This forces resize 
    
-   ppg_active_tokens_resize(active_tokens, saved_size);
+   ppg_active_tokens_resize(active_tokens, saved_size, allocator);
 }
 
-void ppg_active_tokens_free(PPG_Active_Tokens *active_tokens)
+void ppg_active_tokens_free(PPG_Active_Tokens *active_tokens,
+                            PPG_Allocator *allocator)
 {
    if(!active_tokens->tokens) { return; }
    
-   free(active_tokens->tokens);
+   ppg_allocator_free(allocator, active_tokens->tokens);
    
    active_tokens->tokens = NULL;
 }
@@ -121,6 +121,14 @@ static void ppg_action_callback(PPG_Token__ *consumer,
 {
    ppg_signal(PPG_Before_Action);
    
+   if(ppg_context->action_dispatcher.func) {
+      ppg_context->action_dispatcher.func(
+                                  consumer->action.callback,
+                                  activation_flags,
+                                  ppg_context->action_dispatcher.user_data);
+      return;
+   }
+   
    consumer->action.callback.func(activation_flags, 
 //                                   consumer,
                                   consumer->action.callback.user_data);
@@ -137,7 +145,7 @@ static void ppg_active_tokens_on_deactivation(PPG_Token__ *consumer,
 
    if(!consumer) { return; }
       
-   if(consumer->misc.flags & PPG_Token_Flags_Pedantic) {
+   if(PPG_TOKEN_MISC(consumer).flags & PPG_Token_Flags_Pedantic) {
       
       if(   (state 
                      == PPG_Token_Matches) 
@@ -145,19 +153,19 @@ static void ppg_active_tokens_on_deactivation(PPG_Token__ *consumer,
             
 //             PPG_LOG("   Cs act & deact\n");
       
-         if(consumer->misc.action_state == PPG_Action_Enabled) {
+         if(PPG_TOKEN_MISC(consumer).action_state == PPG_Action_Enabled) {
                   
 //                PPG_LOG("      T.a.a.\n");
                   
             ppg_action_callback(consumer,
                                 PPG_Action_Activation_Flags_Active /* signal deactivation */);
             
-            consumer->misc.action_state = PPG_Action_Activation_Triggered;
+            PPG_TOKEN_MISC(consumer).action_state = PPG_Action_Activation_Triggered;
                   
             ppg_action_callback(consumer,
                                 PPG_Action_Activation_Flags_Empty /* signal deactivation */);
                   
-            consumer->misc.action_state = PPG_Action_Deactivation_Triggered;
+            PPG_TOKEN_MISC(consumer).action_state = PPG_Action_Deactivation_Triggered;
          }
          
          ppg_active_tokens_search_remove(consumer);
@@ -183,13 +191,13 @@ static void ppg_active_tokens_on_deactivation(PPG_Token__ *consumer,
          
          if(consumer->misc.action_flags & PPG_Action_Deactivate_On_Token_Unmatch) {
 
-            if(consumer->misc.action_state == PPG_Action_Enabled) {
+            if(PPG_TOKEN_MISC(consumer).action_state == PPG_Action_Enabled) {
                
 //                   PPG_LOG("      T.e.a.\n");
                ppg_action_callback(consumer,
                                    PPG_Action_Activation_Flags_Empty /* signal deactivation */);
                
-               consumer->misc.action_state = PPG_Action_Deactivation_Triggered;
+               PPG_TOKEN_MISC(consumer).action_state = PPG_Action_Deactivation_Triggered;
             }
          }
       }
@@ -202,22 +210,22 @@ static void ppg_active_tokens_on_deactivation(PPG_Token__ *consumer,
          // again.
          
          if(   ((consumer->misc.action_flags & PPG_Action_Deactivate_On_Token_Unmatch) == 0)
-            || (consumer->misc.action_state != PPG_Action_Deactivation_Triggered)) {
+            || (PPG_TOKEN_MISC(consumer).action_state != PPG_Action_Deactivation_Triggered)) {
             
-            if(consumer->misc.action_state == PPG_Action_Enabled) {
+            if(PPG_TOKEN_MISC(consumer).action_state == PPG_Action_Enabled) {
 //                   PPG_LOG("      T.a.a.\n");
                ppg_action_callback(consumer,
                                    PPG_Action_Activation_Flags_Active /* signal activation */);
                
-               consumer->misc.action_state = PPG_Action_Activation_Triggered;
+               PPG_TOKEN_MISC(consumer).action_state = PPG_Action_Activation_Triggered;
             }
             
-            if(consumer->misc.action_state == PPG_Action_Activation_Triggered) {
+            if(PPG_TOKEN_MISC(consumer).action_state == PPG_Action_Activation_Triggered) {
 //                   PPG_LOG("      T.d.a.\n");
                ppg_action_callback(consumer,
                                    PPG_Action_Activation_Flags_Empty /* signal deactivation */);
                
-               consumer->misc.action_state = PPG_Action_Deactivation_Triggered;
+               PPG_TOKEN_MISC(consumer).action_state = PPG_Action_Deactivation_Triggered;
             }
          }
          
@@ -258,12 +266,11 @@ bool ppg_active_tokens_check_consumption(
       consumer = PPG_GAT.tokens[i];
       
 //       PPG_LOG("   consumer: 0x%" PRIXPTR "\n", (uintptr_t)consumer);
-//       PPG_LOG("   consumer action state: %d\n", consumer->misc.action_state);
+//       PPG_LOG("   consumer action state: %d\n", PPG_TOKEN_MISC(consumer).action_state);
       
-      PPG_Count old_state = consumer->misc.state;
+      PPG_Count old_state = PPG_TOKEN_MISC(consumer).state;
       
-      event_consumed = consumer
-                              ->vtable->match_event(  
+      event_consumed = ppg_token_match_event(
                                        consumer, 
                                        event,
                                        true /*modify only if consuming*/
@@ -277,7 +284,7 @@ bool ppg_active_tokens_check_consumption(
          continue;
       }
       
-      new_state = consumer->misc.state;
+      new_state = PPG_TOKEN_MISC(consumer).state;
       
       if(old_state != new_state) {
          state_changed = true;
@@ -325,7 +332,7 @@ void ppg_active_tokens_repeat_actions(void)
       
       PPG_Token__ *consumer = PPG_GAT.tokens[i];
       
-      if(consumer->misc.action_state == PPG_Action_Activation_Triggered)
+      if(PPG_TOKEN_MISC(consumer).action_state == PPG_Action_Activation_Triggered)
       {
          ppg_action_callback(consumer,
                              PPG_Action_Activation_Flags_Active | PPG_Action_Activation_Flags_Repeated/* signal activation */);
@@ -334,6 +341,7 @@ void ppg_active_tokens_repeat_actions(void)
 }
 
 void ppg_active_tokens_update_single_token(
+                                    PPG_Event *event,
                                     void *event_queue_entry,
                                     void *user_data)
 {
@@ -342,24 +350,24 @@ void ppg_active_tokens_update_single_token(
    PPG_UNUSED(user_data);
    
 //    PPG_LOG("Event: Input 0x%d, active: %d\n",
-//            eqe->event.input,
-//            eqe->event.flags & PPG_Event_Active);
+//            event->input,
+//            event->flags & PPG_Event_Active);
    
    // Check if the event has already been considered 
    // This is the case for deactivation events that
    // have been consumed by unfinished tokens of a previous pattern match.
    //
-   if(eqe->event.flags & PPG_Event_Considered) {
+   if(event->flags & PPG_Event_Considered) {
       return;
    }
       
    if(eqe->consumer) {
 //       PPG_LOG("   consumer: 0x%" PRIXPTR "\n", (uintptr_t)eqe->consumer);
-//       PPG_LOG("   consumer action state: %d\n", eqe->consumer->misc.action_state);
+//       PPG_LOG("   consumer action state: %d\n", PPG_TOKEN_MISC(eqe->consumer).action_state);
       PPG_PRINT_TOKEN(eqe->consumer)
    }
   
-   if(eqe->event.flags & PPG_Event_Active) {
+   if(event->flags & PPG_Event_Active) {
       
       // The event activates an input
       
@@ -378,26 +386,26 @@ void ppg_active_tokens_update_single_token(
          // In pedantic tokens mode, tokens can only trigger actions 
          // when all their related inputs became inactive
          //
-         if((eqe->consumer->misc.flags & PPG_Token_Flags_Pedantic) == 0) {
+         if((PPG_TOKEN_MISC(eqe->consumer).flags & PPG_Token_Flags_Pedantic) == 0) {
             
             // As the token just matched. Lets check if
             // we are allowed to trigger the respective action.
             //
-            if(eqe->consumer->misc.action_state == PPG_Action_Enabled) {
+            if(PPG_TOKEN_MISC(eqe->consumer).action_state == PPG_Action_Enabled) {
                
 //                PPG_LOG("      Triggering activation action\n");
                
                ppg_action_callback(eqe->consumer,
                                    PPG_Action_Activation_Flags_Active /* signal activation */);
                
-               eqe->consumer->misc.action_state = PPG_Action_Activation_Triggered;
+               PPG_TOKEN_MISC(eqe->consumer).action_state = PPG_Action_Activation_Triggered;
             }
          }
       }
       
-      eqe->event.flags |= PPG_Event_Considered;
+      event->flags |= PPG_Event_Considered;
       
-      if(eqe->consumer->misc.flags & PPG_Token_Flags_Done) {
+      if(PPG_TOKEN_MISC(eqe->consumer).flags & PPG_Token_Flags_Done) {
          ppg_active_tokens_search_remove(eqe->consumer);
       }
    }
@@ -410,13 +418,13 @@ void ppg_active_tokens_update_single_token(
                                         eqe->token_state.state,
                                         eqe->token_state.changed);
 
-         eqe->event.flags |= PPG_Event_Considered;
+         event->flags |= PPG_Event_Considered;
       }
       else {
          
          PPG_LOG("   Not part of current match branch\n");
          
-         ppg_active_tokens_check_consumption(&eqe->event);
+         ppg_active_tokens_check_consumption(event);
       }
    }
 }
@@ -16,6 +16,7 @@
 #ifndef PPG_ACTIVE_TOKENS_DETAIL_HPP
 #define PPG_ACTIVE_TOKENS_DETAIL_HPP
 
+#include "ppg_allocator.h"
 #include "detail/ppg_token_detail.h"
 #include "ppg_settings.h"
 
@@ -30,17 +31,22 @@ typedef struct {
 PPG_Count ppg_active_tokens_get_size(void);
 
 void ppg_active_tokens_resize(PPG_Active_Tokens *active_tokens,
-                              PPG_Count new_size);
+                              PPG_Count new_size,
+                              PPG_Allocator *allocator);
 
-void ppg_active_tokens_restore(PPG_Active_Tokens *active_tokens);
+void ppg_active_tokens_restore(PPG_Active_Tokens *active_tokens,
+                               PPG_Allocator *allocator);
 
-void ppg_active_tokens_init(PPG_Active_Tokens *active_tokens);
+void ppg_active_tokens_init(PPG_Active_Tokens *active_tokens,
+                            PPG_Allocator *allocator);
 
-void ppg_active_tokens_free(PPG_Active_Tokens *active_tokens);
+void ppg_active_tokens_free(PPG_Active_Tokens *active_tokens,
+                            PPG_Allocator *allocator);
 
 void ppg_active_tokens_update(void);
 
 void ppg_active_tokens_update_single_token(
+                                    PPG_Event *event,
                                     void *event_queue_entry,
                                     void *user_data);
 
@@ -36,9 +36,7 @@ void *ppg_aggregate_new(void *aggregate__) {
    aggregate->n_members = 0;
    aggregate->inputs = NULL;
    
-   ppg_bitfield_init(&aggregate->member_active);
-
-   aggregate->n_inputs_active = 0;
+   aggregate->state_offset = (size_t)-1;
 
    return aggregate;
 }
@@ -47,28 +45,27 @@ void ppg_aggregate_reset(PPG_Aggregate *aggregate)
 {
    ppg_token_reset_control_state((PPG_Token__*)aggregate);
    
-   aggregate->n_inputs_active = 0;
+   PPG_Aggregate_State *state = ppg_aggregate_get_state(aggregate);
    
-   for(PPG_Count i = 0; i < aggregate->n_members; ++i) {
-      ppg_bitfield_set_bit(&aggregate->member_active,
-                           i,
-                           false);
-   }
+   state->n_inputs_active = 0;
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(aggregate, PPG_Aggregate_Member_Active);
+   
+   ppg_bitfield_clear(&member_active);
    
    // Clear the activation state
    //
-   aggregate->super.misc.flags 
+   PPG_TOKEN_MISC(aggregate).flags 
          &= (PPG_Count)~PPG_Aggregate_All_Active;
 }
 
 static void ppg_aggregate_deallocate_member_storage(PPG_Aggregate *aggregate) {  
    
    if(aggregate->inputs) {
-      free(aggregate->inputs);
+      ppg_tree_free(aggregate->inputs);
       aggregate->inputs = NULL;
    }
-   
-   ppg_bitfield_destroy(&aggregate->member_active);
 }
 
 static void ppg_aggregate_resize(PPG_Aggregate *aggregate, 
@@ -78,13 +75,7 @@ static void ppg_aggregate_resize(PPG_Aggregate *aggregate,
    
    aggregate->n_members = n_members;
    
-   aggregate->inputs = (PPG_Input_Id *)PPG_MALLOC(n_members*sizeof(PPG_Input_Id));
-	
-   ppg_bitfield_resize(&aggregate->member_active,
-                       n_members,
-                       false /*drop old bits*/);
-
-   aggregate->n_inputs_active = 0;
+   aggregate->inputs = (PPG_Input_Id *)ppg_tree_malloc(n_members*sizeof(PPG_Input_Id));
       
    for(PPG_Count i = 0; i < n_members; ++i) {
       ppg_global_init_input(&aggregate->inputs[i]);
@@ -101,7 +92,7 @@ PPG_Aggregate* ppg_aggregate_destroy(PPG_Aggregate *aggregate) {
 }
 
 PPG_Aggregate *ppg_aggregate_alloc(void) {
-    return (PPG_Aggregate*)PPG_MALLOC(sizeof(PPG_Aggregate));
+    return (PPG_Aggregate*)ppg_tree_malloc(sizeof(PPG_Aggregate));
 }
 
 bool ppg_aggregates_equal(PPG_Aggregate *c1, PPG_Aggregate *c2) 
@@ -141,9 +132,60 @@ PPG_Token ppg_global_initialize_aggregate(
 size_t ppg_aggregate_dynamic_member_size(PPG_Aggregate *aggregate)
 {
    return   ppg_token_dynamic_member_size((PPG_Token__*)aggregate)
-         +  aggregate->n_members*sizeof(PPG_Input_Id)
-         +  ppg_bitfield_get_num_cells(&aggregate->member_active)
-               *sizeof(PPG_Bitfield_Storage_Type);
+         +  aggregate->n_members*sizeof(PPG_Input_Id);
+}
+
+PPG_Bitfield ppg_aggregate_get_bitfield(PPG_Aggregate *aggregate, 
+                                        PPG_Count bitfield_id)
+{
+   PPG_Bitfield bitfield;
+   
+   bitfield.n_bits = aggregate->n_members;
+   bitfield.bitarray 
+      = (PPG_Bitfield_Storage_Type *)(ppg_aggregate_get_state(aggregate) + 1)
+            + bitfield_id*ppg_bitfield_get_num_cells_from_bits(aggregate->n_members);
+   
+   return bitfield;
+}
+
+size_t ppg_aggregate_layout_state_bitfields(PPG_Aggregate *aggregate, 
+                                            size_t offset,
+                                            PPG_Count n_bitfields)
+{
+   aggregate->state_offset = offset;
+   
+   size_t n_bytes 
+      =  sizeof(PPG_Aggregate_State)
+       + n_bitfields*ppg_bitfield_get_num_cells_from_bits(aggregate->n_members)
+            *sizeof(PPG_Bitfield_Storage_Type);
+   
+   // Keep the states of subsequent tokens aligned
+   //
+   return (n_bytes + sizeof(PPG_Count) - 1)
+            /sizeof(PPG_Count)*sizeof(PPG_Count);
+}
+
+size_t ppg_aggregate_layout_state(PPG_Aggregate *aggregate, size_t offset)
+{
+   return ppg_aggregate_layout_state_bitfields(aggregate, offset, 1);
+}
+
+PPG_Input_Id *ppg_aggregate_entry_inputs(PPG_Aggregate *aggregate, 
+                                         PPG_Count *n_inputs)
+{
+   // Aggregates can be entered through any of their members
+   //
+   *n_inputs = aggregate->n_members;
+   
+   return aggregate->inputs;
+}
+
+PPG_Input_Id *ppg_aggregate_inputs(PPG_Aggregate *aggregate, 
+                                   PPG_Count *n_inputs)
+{
+   *n_inputs = aggregate->n_members;
+   
+   return aggregate->inputs;
 }
 
 char *ppg_aggregate_copy_dynamic_members(PPG_Token__ *source, 
@@ -162,15 +204,6 @@ char *ppg_aggregate_copy_dynamic_members(PPG_Token__ *source,
    
    copy_of_aggregate->inputs = (PPG_Input_Id *)buffer;
    
-   buffer += n_bytes;
-   
-   n_bytes = ppg_bitfield_get_num_cells(&aggregate->member_active)
-               *sizeof(PPG_Bitfield_Storage_Type);
-   
-   memcpy(buffer, (void*)aggregate->member_active.bitarray, n_bytes);
-   
-   copy_of_aggregate->member_active.bitarray = (PPG_Bitfield_Storage_Type *)buffer;
-   
    return buffer + n_bytes;
 }
 
@@ -184,10 +217,6 @@ void ppg_aggregate_addresses_to_relative(  PPG_Token__ *token,
    
    aggregate->inputs = (PPG_Input_Id *)((char*)aggregate->inputs
                                  - (char*)begin_of_buffer);
-   
-   aggregate->member_active.bitarray = (PPG_Bitfield_Storage_Type *)
-                        ((char*)aggregate->member_active.bitarray
-                                 - (char*)begin_of_buffer);
 }
 
 void ppg_aggregate_addresses_to_absolute(  PPG_Token__ *token,
@@ -200,10 +229,6 @@ void ppg_aggregate_addresses_to_absolute(  PPG_Token__ *token,
    
    aggregate->inputs = (PPG_Input_Id *)((char*)begin_of_buffer
                               + (size_t)aggregate->inputs);
-   
-   aggregate->member_active.bitarray = (PPG_Bitfield_Storage_Type *)
-         ((char*)begin_of_buffer
-               + (size_t)aggregate->member_active.bitarray);
 }
 
 #if PPG_HAVE_DEBUGGING
@@ -215,13 +240,16 @@ bool ppg_aggregate_check_initialized(PPG_Token__ *token)
    
    assertion_failed |= ppg_token_check_initialized(token);
    
-   PPG_ASSERT_WARN((aggregate->super.misc.flags 
+   PPG_ASSERT_WARN((PPG_TOKEN_MISC(aggregate).flags 
          & PPG_Aggregate_All_Active) == 0);
    
-   PPG_ASSERT_WARN(aggregate->n_inputs_active == 0);
+   PPG_ASSERT_WARN(ppg_aggregate_get_state(aggregate)->n_inputs_active == 0);
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(aggregate, PPG_Aggregate_Member_Active);
    
    for(PPG_Count i = 0; i < aggregate->n_members; ++i) {
-      PPG_ASSERT_WARN(ppg_bitfield_get_bit(&aggregate->member_active,
+      PPG_ASSERT_WARN(ppg_bitfield_get_bit(&member_active,
                            i) == false);
    }
    
@@ -21,6 +21,7 @@
 #include "ppg_input.h"
 #include "ppg_settings.h"
 #include "ppg_bitfield.h"
+#include "detail/ppg_context_detail.h"
 
 typedef struct {
    
@@ -29,12 +30,31 @@ typedef struct {
    PPG_Count n_members;
    PPG_Input_Id *inputs;
    
-   PPG_Bitfield member_active;
-   
-   PPG_Count n_inputs_active;
+   // The offset of the aggregate's matching state 
+   // in the token data block of a context, assigned 
+   // during compilation of the pattern tree
+   //
+   size_t state_offset;
     
 } PPG_Aggregate;
 
+// The matching state of an aggregate. It is stored in the token data
+// block of the context and is followed by one or more 
+// bitfields of n_members bits.
+//
+typedef struct {
+   
+   PPG_Count n_inputs_active;
+   PPG_Count n_lasting; // Clusters only
+   PPG_Count next_member; // Sequences only
+   
+} PPG_Aggregate_State;
+
+enum {
+   PPG_Aggregate_Member_Active = 0,
+   PPG_Aggregate_Member_Active_Lasting // Clusters only
+};
+
 // Careful: Keep this in sync with flags for chords or clusters
 //
 enum {
@@ -50,7 +70,43 @@ void *ppg_aggregate_new(void *aggregate__);
 
 void ppg_aggregate_reset(PPG_Aggregate *aggregate);
 
+// Returns the matching state of an aggregate
+// with respect to the current context
+//
+inline
+static PPG_Aggregate_State *ppg_aggregate_get_state(PPG_Aggregate *aggregate)
+{
+   // The state is only available after the pattern tree
+   // has been compiled
+   //
+   PPG_ASSERT(aggregate->state_offset < ppg_context->token_data_size);
+   
+   return (PPG_Aggregate_State *)(ppg_context->token_data 
+                                    + aggregate->state_offset);
+}
+
+// Returns a view of a bitfield that is part of the matching state
+// of an aggregate
+//
+PPG_Bitfield ppg_aggregate_get_bitfield(PPG_Aggregate *aggregate, 
+                                        PPG_Count bitfield_id);
+
+// Lays out the state of an aggregate with the given number of 
+// bitfields and returns the number of bytes required
+//
+size_t ppg_aggregate_layout_state_bitfields(PPG_Aggregate *aggregate, 
+                                            size_t offset,
+                                            PPG_Count n_bitfields);
+
+size_t ppg_aggregate_layout_state(PPG_Aggregate *aggregate, size_t offset);
+
 size_t ppg_aggregate_dynamic_member_size(PPG_Aggregate *aggregate);
+
+PPG_Input_Id *ppg_aggregate_entry_inputs(PPG_Aggregate *aggregate, 
+                                         PPG_Count *n_inputs);
+
+PPG_Input_Id *ppg_aggregate_inputs(PPG_Aggregate *aggregate, 
+                                   PPG_Count *n_inputs);
   
 #if PPG_HAVE_DEBUGGING
 bool ppg_aggregate_check_initialized(PPG_Token__ *token);
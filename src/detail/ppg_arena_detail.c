@@ -0,0 +1,145 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "detail/ppg_arena_detail.h"
+#include "detail/ppg_malloc_detail.h"
+#include "ppg_debug.h"
+
+#include <stdlib.h>
+
+void ppg_arena_init(PPG_Arena *arena, PPG_Allocator *allocator)
+{
+   arena->chunks = NULL;
+   arena->storage = (PPG_Arena_Storage) { 
+      .allocate = NULL, 
+      .release = NULL, 
+      .user_data = NULL 
+   };
+   arena->allocator = allocator;
+   arena->n_reserved = 0;
+}
+
+static PPG_Arena_Chunk *ppg_arena_add_chunk(PPG_Arena *arena, size_t n_bytes)
+{
+   // Chunk sizes grow geometrically to keep the number of 
+   // chunks logarithmic in the size of the tree
+   //
+   size_t size = arena->n_reserved;
+   
+   if(size < PPG_Arena_Min_Chunk_Size) {
+      size = PPG_Arena_Min_Chunk_Size;
+   }
+   
+   if(size < n_bytes) {
+      size = n_bytes;
+   }
+   
+   size_t header_size = ppg_align_size(sizeof(PPG_Arena_Chunk));
+   
+   PPG_Arena_Storage storage = arena->storage;
+   
+   // Without a storage, chunks are obtained from the allocator
+   //
+   if(!storage.allocate && arena->allocator) {
+      storage = (PPG_Arena_Storage) {
+         .allocate = arena->allocator->alloc,
+         .release = arena->allocator->free,
+         .user_data = arena->allocator->user_data
+      };
+   }
+   
+   char *memory = NULL;
+   
+   if(storage.allocate) {
+      
+      memory = (char*)storage.allocate(header_size + size,
+                                       storage.user_data);
+      if(!memory) {
+         PPG_ERROR("Arena storage exhausted (%lu bytes)\n",
+                   (unsigned long)(header_size + size));
+         abort();
+      }
+   }
+   else {
+      memory = (char*)PPG_MALLOC(header_size + size);
+   }
+   
+   PPG_Arena_Chunk *chunk = (PPG_Arena_Chunk *)memory;
+   
+   chunk->storage = storage;
+   chunk->begin = memory + header_size;
+   chunk->size = size;
+   chunk->n_used = 0;
+   
+   chunk->next = arena->chunks;
+   arena->chunks = chunk;
+   
+   arena->n_reserved += size;
+   
+   return chunk;
+}
+
+void *ppg_arena_allocate(PPG_Arena *arena, size_t n_bytes)
+{
+   n_bytes = ppg_align_size(n_bytes);
+   
+   PPG_Arena_Chunk *chunk = arena->chunks;
+   
+   if(!chunk || (chunk->size - chunk->n_used < n_bytes)) {
+      chunk = ppg_arena_add_chunk(arena, n_bytes);
+   }
+   
+   void *memory = chunk->begin + chunk->n_used;
+   
+   chunk->n_used += n_bytes;
+   
+   return memory;
+}
+
+size_t ppg_arena_get_n_used(PPG_Arena *arena)
+{
+   size_t n_used = 0;
+   
+   for(PPG_Arena_Chunk *chunk = arena->chunks; chunk; chunk = chunk->next) {
+      n_used += chunk->n_used;
+   }
+   
+   return n_used;
+}
+
+void ppg_arena_free(PPG_Arena *arena)
+{
+   PPG_Arena_Chunk *chunk = arena->chunks;
+   
+   while(chunk) {
+      
+      PPG_Arena_Chunk *next = chunk->next;
+      
+      if(chunk->storage.allocate) {
+         if(chunk->storage.release) {
+            chunk->storage.release((void*)chunk, chunk->storage.user_data);
+         }
+      }
+      else {
+         free(chunk);
+      }
+      
+      chunk = next;
+   }
+   
+   arena->chunks = NULL;
+   arena->n_reserved = 0;
+}
@@ -0,0 +1,72 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_ARENA_DETAIL_H
+#define PPG_ARENA_DETAIL_H
+
+#include "ppg_arena.h"
+#include "ppg_allocator.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum { PPG_Arena_Min_Chunk_Size = 1024 };
+
+typedef struct PPG_Arena_Chunk_Struct {
+   
+   struct PPG_Arena_Chunk_Struct *next;
+   
+   // The storage the chunk was obtained from
+   //
+   PPG_Arena_Storage storage;
+   
+   char *begin;
+   size_t size;
+   size_t n_used;
+   
+} PPG_Arena_Chunk;
+
+typedef struct {
+   
+   // The most recently obtained chunk comes first. Only this
+   // one is used to serve requests.
+   //
+   PPG_Arena_Chunk *chunks;
+   
+   PPG_Arena_Storage storage;
+   
+   // The allocator that provides chunks if no storage is set
+   // (NULL means the heap)
+   //
+   PPG_Allocator *allocator;
+   
+   size_t n_reserved;
+   
+} PPG_Arena;
+
+void ppg_arena_init(PPG_Arena *arena, PPG_Allocator *allocator);
+
+// Returns memory that is aligned suitably for any token type
+//
+void *ppg_arena_allocate(PPG_Arena *arena, size_t n_bytes);
+
+size_t ppg_arena_get_n_used(PPG_Arena *arena);
+
+// Returns all chunks to their storage
+//
+void ppg_arena_free(PPG_Arena *arena);
+
+#endif
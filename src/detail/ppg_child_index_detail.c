@@ -0,0 +1,357 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "detail/ppg_child_index_detail.h"
+#include "detail/ppg_malloc_detail.h"
+#include "detail/ppg_token_dispatch_detail.h"
+#include "ppg_debug.h"
+
+#include <stdlib.h>
+
+void ppg_child_index_init(PPG_Child_Index *child_index)
+{
+   child_index->nodes = NULL;
+   child_index->entries = NULL;
+   child_index->dispatch = NULL;
+   child_index->n_nodes = 0;
+   child_index->n_entries = 0;
+   child_index->n_dispatch = 0;
+}
+
+void ppg_child_index_free(PPG_Child_Index *child_index,
+                          PPG_Allocator *allocator)
+{
+   ppg_allocator_free(allocator, child_index->nodes);
+   ppg_allocator_free(allocator, child_index->entries);
+   ppg_allocator_free(allocator, child_index->dispatch);
+
+   ppg_child_index_init(child_index);
+}
+
+static void ppg_child_index_count_token(PPG_Token__ *token, size_t *n_tokens)
+{
+   PPG_UNUSED(token);
+
+   ++(*n_tokens);
+}
+
+static bool ppg_child_index_children_have_entry_inputs(PPG_Token__ *token)
+{
+   for(PPG_Count i = 0; i < token->n_children; ++i) {
+      if(!token->children[i]->vtable->entry_inputs) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static bool ppg_child_index_entry_less(PPG_Child_Index_Entry *e1,
+                                       PPG_Child_Index_Entry *e2)
+{
+   if(e1->input != e2->input) {
+      return e1->input < e2->input;
+   }
+
+   return e1->child < e2->child;
+}
+
+static PPG_Token_Id ppg_child_index_add_entries(PPG_Child_Index *child_index,
+                                                PPG_Token__ *token,
+                                                PPG_Token_Id first_entry)
+{
+   PPG_Token_Id n_entries = 0;
+
+   for(PPG_Count i = 0; i < token->n_children; ++i) {
+
+      PPG_Count n_inputs = 0;
+      PPG_Input_Id *inputs
+         = token->children[i]->vtable->entry_inputs(token->children[i],
+                                                    &n_inputs);
+
+      for(PPG_Count j = 0; j < n_inputs; ++j) {
+
+         // Aggregates might list an input more than once
+         //
+         bool duplicate = false;
+         for(PPG_Count k = 0; k < j; ++k) {
+            if(inputs[k] == inputs[j]) {
+               duplicate = true;
+               break;
+            }
+         }
+
+         if(duplicate) { continue; }
+
+         if(child_index->entries) {
+
+            PPG_Child_Index_Entry entry
+               = (PPG_Child_Index_Entry) {
+                  .input = inputs[j],
+                  .child = i
+               };
+
+            // Insertion sort, the entries of a node are
+            // usually few
+            //
+            PPG_Child_Index_Entry *run
+                  = &child_index->entries[first_entry];
+            PPG_Token_Id pos = n_entries;
+
+            while(   (pos > 0)
+                  && ppg_child_index_entry_less(&entry, &run[pos - 1])) {
+               run[pos] = run[pos - 1];
+               --pos;
+            }
+
+            run[pos] = entry;
+         }
+
+         ++n_entries;
+      }
+   }
+
+   return n_entries;
+}
+
+static bool ppg_child_index_node_needs_dispatch(PPG_Child_Index_Node *node)
+{
+   return node->n_entries >= PPG_CHILD_INDEX_DISPATCH_MIN_ENTRIES;
+}
+
+static void ppg_child_index_add_dispatch(PPG_Child_Index *child_index,
+                                         PPG_Child_Index_Node *node)
+{
+   PPG_Child_Index_Entry *run
+         = &child_index->entries[node->first_entry];
+   PPG_Token_Id *dispatch = &child_index->dispatch[node->first_dispatch];
+
+   PPG_Token_Id pos = 0;
+
+   for(PPG_Token_Id i = 0; i <= (PPG_Token_Id)(node->max_input - node->min_input); ++i) {
+
+      while(   (pos < node->n_entries)
+            && (run[pos].input < node->min_input + i)) {
+         ++pos;
+      }
+
+      dispatch[i] = pos;
+   }
+
+   dispatch[node->max_input - node->min_input + 1] = node->n_entries;
+}
+
+void ppg_child_index_build(PPG_Child_Index *child_index, 
+                           PPG_Token__ *root,
+                           PPG_Allocator *allocator)
+{
+   ppg_child_index_free(child_index, allocator);
+
+   size_t n_nodes = 0;
+
+   ppg_token_traverse_tree(root,
+                           (PPG_Token_Tree_Visitor)ppg_child_index_count_token,
+                           NULL,
+                           (void*)&n_nodes);
+   
+   if(n_nodes >= (size_t)PPG_TOKEN_ID_INVALID) {
+      PPG_ERROR("Pattern tree with %lu tokens exceeds the range of "
+                "PPG_Token_Id\n", (unsigned long)n_nodes);
+      abort();
+   }
+
+   child_index->nodes
+      = (PPG_Child_Index_Node *)ppg_allocator_malloc(allocator, n_nodes*sizeof(PPG_Child_Index_Node));
+   child_index->n_nodes = (PPG_Token_Id)n_nodes;
+
+   // Store the nodes in breadth first order
+   //
+   child_index->nodes[0].token = root;
+   root->id = 0;
+
+   size_t n_assigned = 1;
+
+   for(size_t s = 0; s < n_nodes; ++s) {
+
+      PPG_Child_Index_Node *node = &child_index->nodes[s];
+      PPG_Token__ *token = node->token;
+
+      node->first_child = (PPG_Token_Id)n_assigned;
+      node->precedence = ppg_token_precedence(token);
+      node->layer = token->layer;
+
+      for(PPG_Count i = 0; i < token->n_children; ++i) {
+         token->children[i]->id = (PPG_Token_Id)n_assigned;
+         child_index->nodes[n_assigned].token = token->children[i];
+         ++n_assigned;
+      }
+   }
+
+   PPG_ASSERT(n_assigned == n_nodes);
+
+   // Count the entries first, then allocate and
+   // sort them into place.
+   //
+   size_t n_entries = 0;
+
+   for(size_t s = 0; s < n_nodes; ++s) {
+
+      PPG_Token__ *token = child_index->nodes[s].token;
+
+      if(ppg_child_index_children_have_entry_inputs(token)) {
+         n_entries += ppg_child_index_add_entries(child_index, token, 0);
+      }
+   }
+
+   child_index->entries
+      = (PPG_Child_Index_Entry *)ppg_allocator_malloc(allocator, 
+            (n_entries > 0 ? n_entries : 1)*sizeof(PPG_Child_Index_Entry));
+   child_index->n_entries = (PPG_Token_Id)n_entries;
+
+   PPG_Token_Id first_entry = 0;
+
+   for(size_t s = 0; s < n_nodes; ++s) {
+
+      PPG_Child_Index_Node *node = &child_index->nodes[s];
+
+      node->first_entry = first_entry;
+
+      if(!ppg_child_index_children_have_entry_inputs(node->token)) {
+         node->n_entries = PPG_CHILD_INDEX_QUERY_CHILDREN;
+         continue;
+      }
+
+      node->n_entries
+         = ppg_child_index_add_entries(child_index,
+                                       node->token,
+                                       first_entry);
+
+      first_entry += node->n_entries;
+   }
+
+   // Generate dispatch tables for nodes with many entries
+   //
+   size_t n_dispatch = 0;
+
+   for(size_t s = 0; s < n_nodes; ++s) {
+
+      PPG_Child_Index_Node *node = &child_index->nodes[s];
+
+      node->first_dispatch = PPG_CHILD_INDEX_NO_DISPATCH;
+      node->min_input = 0;
+      node->max_input = 0;
+
+      if(   (node->n_entries == 0)
+         || (node->n_entries == PPG_CHILD_INDEX_QUERY_CHILDREN)) { 
+         continue; 
+      }
+
+      PPG_Child_Index_Entry *run
+            = &child_index->entries[node->first_entry];
+
+      node->min_input = run[0].input;
+      node->max_input = run[node->n_entries - 1].input;
+
+      if(!ppg_child_index_node_needs_dispatch(node)) { continue; }
+
+      node->first_dispatch = (PPG_Token_Id)n_dispatch;
+      n_dispatch += node->max_input - node->min_input + 2;
+   }
+
+   if(n_dispatch > 0) {
+
+      child_index->dispatch
+         = (PPG_Token_Id *)ppg_allocator_malloc(allocator, 
+                                          n_dispatch*sizeof(PPG_Token_Id));
+      child_index->n_dispatch = (PPG_Token_Id)n_dispatch;
+
+      for(size_t s = 0; s < n_nodes; ++s) {
+         if(child_index->nodes[s].first_dispatch != PPG_CHILD_INDEX_NO_DISPATCH) {
+            ppg_child_index_add_dispatch(child_index, &child_index->nodes[s]);
+         }
+      }
+   }
+
+   PPG_LOG("Child index: %lu nodes, %lu entries, %lu dispatch slots\n",
+           (unsigned long)n_nodes, (unsigned long)n_entries, 
+           (unsigned long)n_dispatch);
+}
+
+PPG_Child_Index_Node *ppg_child_index_get_node(PPG_Child_Index *child_index,
+                                               PPG_Token__ *token)
+{
+   // Tokens that were added after the child index was built
+   // are unknown
+   //
+   if(   (token->id >= child_index->n_nodes)
+      || (child_index->nodes[token->id].token != token)) {
+      return NULL;
+   }
+
+   return &child_index->nodes[token->id];
+}
+
+PPG_Child_Index_Entry *ppg_child_index_get_entries(
+                                          PPG_Child_Index *child_index,
+                                          PPG_Child_Index_Node *node,
+                                          PPG_Input_Id input,
+                                          PPG_Token_Id *n_entries)
+{
+   PPG_Child_Index_Entry *run
+            = &child_index->entries[node->first_entry];
+
+   if(node->first_dispatch != PPG_CHILD_INDEX_NO_DISPATCH) {
+
+      if((input < node->min_input) || (input > node->max_input)) {
+         *n_entries = 0;
+         return NULL;
+      }
+
+      PPG_Token_Id *dispatch
+         = &child_index->dispatch[node->first_dispatch + input - node->min_input];
+
+      *n_entries = dispatch[1] - dispatch[0];
+
+      return (*n_entries > 0) ? &run[dispatch[0]] : NULL;
+   }
+
+   // Binary search for the first entry with the given input
+   //
+   PPG_Token_Id lower = 0;
+   PPG_Token_Id upper = node->n_entries;
+
+   while(lower < upper) {
+
+      PPG_Token_Id middle = lower + (upper - lower)/2;
+
+      if(run[middle].input < input) {
+         lower = middle + 1;
+      }
+      else {
+         upper = middle;
+      }
+   }
+
+   PPG_Token_Id end = lower;
+
+   while((end < node->n_entries) && (run[end].input == input)) {
+      ++end;
+   }
+
+   *n_entries = end - lower;
+
+   return (*n_entries > 0) ? &run[lower] : NULL;
+}
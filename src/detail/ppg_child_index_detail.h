@@ -0,0 +1,154 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_CHILD_INDEX_DETAIL_H
+#define PPG_CHILD_INDEX_DETAIL_H
+
+#include "ppg_allocator.h"
+#include "detail/ppg_token_detail.h"
+#include "ppg_input.h"
+#include "ppg_settings.h"
+
+/** @brief The minimum number of entries of a node that
+ *         causes a dispatch table to be generated for the node
+ *
+ * Entries of nodes with a dispatch table are looked up
+ * in constant time, those of all other nodes by binary search.
+ * A dispatch table requires one slot per input between the
+ * lowest and the highest input of the node's entries.
+ */
+#ifndef PPG_CHILD_INDEX_DISPATCH_MIN_ENTRIES
+#define PPG_CHILD_INDEX_DISPATCH_MIN_ENTRIES 8
+#endif
+
+/** @brief The entry count of nodes whose children may consume
+ * any input and whose tokens must thus be queried one by one
+ */
+#define PPG_CHILD_INDEX_QUERY_CHILDREN PPG_TOKEN_ID_INVALID
+
+/** @brief The dispatch table index of nodes without dispatch table
+ */
+#define PPG_CHILD_INDEX_NO_DISPATCH PPG_TOKEN_ID_INVALID
+
+/** @brief A node of the child index
+ *
+ * Every node represents a token of the pattern tree. Nodes are
+ * stored in breadth first order. Thus, the nodes of all children
+ * of a token are adjacent and the node index equals the token id.
+ */
+typedef struct {
+
+   PPG_Token__ *token; ///< The token that is represented by the node
+
+   PPG_Token_Id first_child; ///< The node index of the first child
+
+   PPG_Token_Id first_entry; ///< The index of the node's first entry
+
+   /** The number of entries or PPG_CHILD_INDEX_QUERY_CHILDREN
+    * if the node has children that may consume any input and
+    * their tokens must be queried one by one.
+    */
+   PPG_Token_Id n_entries;
+
+   /** The index of the first dispatch table slot or 
+    * PPG_CHILD_INDEX_NO_DISPATCH if the node has no dispatch table.
+    */
+   PPG_Token_Id first_dispatch;
+
+   PPG_Input_Id min_input; ///< The lowest input of all entries
+
+   PPG_Input_Id max_input; ///< The highest input of all entries
+
+   PPG_Count precedence; ///< The token precedence
+
+   PPG_Layer layer; ///< The token layer
+
+} PPG_Child_Index_Node;
+
+/** @brief An entry that names a child of a node that can be entered
+ *         when an input is activated
+ */
+typedef struct {
+
+   PPG_Input_Id input; ///< The input whose activation can enter the child
+
+   PPG_Count child; ///< The child's index relative to the first child
+
+} PPG_Child_Index_Entry;
+
+/** @brief An index of the children of all tokens of the pattern 
+ *         tree, keyed by the inputs the children can be entered with
+ *
+ * The child index is no state machine. It only speeds up 
+ * ppg_token_get_most_appropriate_branch by narrowing the children of a 
+ * furcation down to those that can consume an activated input, instead 
+ * of asking every child. Matching itself is still done by the tokens' 
+ * match_event functions, on the pattern tree, and with the tree 
+ * engine's reversion to previous furcations. Children that do not
+ * report their entry inputs, as well as deactivation events, are 
+ * still processed by scanning all children.
+ *
+ * The entries of every node are stored contiguously, sorted
+ * with respect to their input. Entries with equal inputs keep
+ * the order of the children in the pattern tree.
+ *
+ * Nodes with many entries own a run of dispatch table slots,
+ * one for every input between their lowest and highest input plus
+ * a final one. Slot i is the offset of the first entry
+ * for input min_input + i, relative to the node's first entry.
+ */
+typedef struct {
+
+   PPG_Child_Index_Node *nodes;
+   PPG_Child_Index_Entry *entries;
+   PPG_Token_Id *dispatch;
+
+   PPG_Token_Id n_nodes;
+   PPG_Token_Id n_entries;
+   PPG_Token_Id n_dispatch;
+
+} PPG_Child_Index;
+
+void ppg_child_index_init(PPG_Child_Index *child_index);
+
+void ppg_child_index_build(PPG_Child_Index *child_index, 
+                           PPG_Token__ *root,
+                           PPG_Allocator *allocator);
+
+void ppg_child_index_free(PPG_Child_Index *child_index,
+                          PPG_Allocator *allocator);
+
+/** @brief Retreives the node that represents a token
+ *
+ * @returns The node or NULL if the token was not part of the
+ *          pattern tree when the child index was built.
+ */
+PPG_Child_Index_Node *ppg_child_index_get_node(PPG_Child_Index *child_index,
+                                               PPG_Token__ *token);
+
+/** @brief Determines the children of a node that can be entered
+ *         upon activation of an input
+ *
+ * @returns A pointer to the first entry or NULL if there is none.
+ *          The number of entries is returned via n_entries.
+ */
+PPG_Child_Index_Entry *ppg_child_index_get_entries(
+                                          PPG_Child_Index *child_index,
+                                          PPG_Child_Index_Node *node,
+                                          PPG_Input_Id input,
+                                          PPG_Token_Id *n_entries);
+
+#endif
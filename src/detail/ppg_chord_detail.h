@@ -24,4 +24,8 @@ typedef PPG_Aggregate PPG_Chord;
 
 extern PPG_Token_Vtable ppg_chord_vtable;
 
+bool ppg_chord_match_event(PPG_Chord *chord,
+                           PPG_Event *event,
+                           bool modify_only_if_consuming);
+
 #endif
@@ -22,10 +22,14 @@
 
 typedef struct {
    PPG_Aggregate aggregate;
-   PPG_Bitfield member_active_lasting;
-   PPG_Count n_lasting;
 } PPG_Cluster;
 
 extern PPG_Token_Vtable ppg_cluster_vtable;
 
+bool ppg_cluster_match_event(PPG_Cluster *cluster,
+                             PPG_Event *event,
+                             bool modify_only_if_consuming);
+                             
+void ppg_cluster_reset(PPG_Cluster *cluster);
+
 #endif
@@ -17,11 +17,16 @@
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_input_detail.h"
 #include "ppg_statistics.h"
+#include "ppg_global.h"
 #include "ppg_debug.h"
+#include "detail/ppg_malloc_detail.h"
+#include "ppg_timer_wheel.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
-PPG_Context *ppg_context = NULL;
+PPG_THREAD_LOCAL PPG_Context *ppg_context = NULL;
 
 /** @brief This function initializes a signal callback
  *
@@ -48,34 +53,75 @@ void ppg_global_initialize_context_static(PPG_Context *context) {
    #endif
    
    context->properties.destruction_enabled = false;
+   context->properties.tree_shared = false;
+   context->properties.event_time_enabled = false;
    
    context->layer = 0;
    ppg_global_init_input(&context->abort_trigger_input);
    context->time_last_event = 0;
    context->event_timeout = 0;
    context->event_processor = NULL;
+   context->event_span_processor = NULL;
    
    ppg_time_manager_init(&context->time_manager);
    
    ppg_signal_callback_init(&context->signal_callback);
+   
+   context->action_dispatcher 
+      = (PPG_Action_Dispatcher) { .func = NULL, .user_data = NULL };
  
+   ppg_arena_init(&context->tree_arena, &context->allocator);
+   
+   context->children_block = NULL;
+   
    context->current_token = NULL;
    
+   context->engine = PPG_Engine_Tree;
+   
+   ppg_child_index_init(&context->child_index);
+   
+   ppg_parallel_matcher_init(&context->parallel_matcher);
+   
+   ppg_work_budget_init(&context->work_budget);
+   
+   ppg_input_masks_init(&context->input_masks);
+   
+   ppg_token_completion_marks_init(&context->completion_marks);
+   
+   context->token_states = NULL;
+   context->token_epochs = NULL;
+   context->epoch = 0;
+   context->n_tokens = 0;
+   context->token_data = NULL;
+   context->token_data_size = 0;
+   
+   #if !PPG_DISABLE_CONTEXT_SWITCHING
+   context->timer_wheel_entry = NULL;
+   #endif
+   
    #if PPG_HAVE_STATISTICS
    ppg_statistics_clear(&context->statistics);
    #endif
 };
 
-void ppg_global_initialize_context(PPG_Context *context) {
+void ppg_global_initialize_context(PPG_Context *context,
+                                   PPG_Allocator allocator) {
   
-   ppg_event_buffer_init(&context->event_buffer);
+   context->allocator = allocator;
+   
+   ppg_event_buffer_init(&context->event_buffer, &context->allocator);
    ppg_furcation_stack_init(&context->furcation_stack);
-   ppg_active_tokens_init(&context->active_tokens);
+   ppg_active_tokens_init(&context->active_tokens, &context->allocator);
    
    ppg_global_initialize_context_static(context);
    
    context->properties.destruction_enabled = true;
-   context->pattern_root = ppg_token_alloc();
+   // Allocate the root directly from the context's arena as 
+   // the context is not yet the current context
+   //
+   context->pattern_root 
+      = (PPG_Token__ *)ppg_arena_allocate(&context->tree_arena, 
+                                          sizeof(PPG_Token__));
    context->tree_depth = 0;
 
    /* Initialize the pattern root
@@ -101,6 +147,45 @@ char *ppg_context_copy(PPG_Context *context, void *target__)
    
    *target_context = *ppg_context;
    
+   // The child index, the input masks, the completion marks and 
+   // the token states are rebuilt when the context is restored
+   //
+   ppg_child_index_init(&target_context->child_index);
+   
+   ppg_parallel_matcher_init(&target_context->parallel_matcher);
+   
+   ppg_work_budget_init(&target_context->work_budget);
+   
+   target_context->action_dispatcher 
+      = (PPG_Action_Dispatcher) { .func = NULL, .user_data = NULL };
+   
+   ppg_input_masks_init(&target_context->input_masks);
+   
+   ppg_token_completion_marks_init(&target_context->completion_marks);
+   
+   // A restored context uses the heap as function pointers 
+   // of allocators cannot be stored
+   //
+   target_context->allocator = (PPG_Allocator) { 
+      .alloc = NULL, .realloc = NULL, .free = NULL, .user_data = NULL 
+   };
+   
+   // The copied tree is stored in the target buffer
+   //
+   ppg_arena_init(&target_context->tree_arena, &target_context->allocator);
+   target_context->children_block = NULL;
+   
+   target_context->token_states = NULL;
+   target_context->token_epochs = NULL;
+   target_context->epoch = 0;
+   target_context->n_tokens = 0;
+   target_context->token_data = NULL;
+   target_context->token_data_size = 0;
+   
+   #if !PPG_DISABLE_CONTEXT_SWITCHING
+   target_context->timer_wheel_entry = NULL;
+   #endif
+   
    target += sizeof(PPG_Context);
    
    return target;
@@ -114,15 +199,255 @@ void ppg_restore_context(PPG_Context *context)
    // Restore the members buffer, which means to let them allocated their
    // dynamically allocated data structures
 
-   ppg_event_buffer_restore(&context->event_buffer);
+   ppg_event_buffer_restore(&context->event_buffer, &context->allocator);
 
-   ppg_furcation_stack_restore(&context->furcation_stack);
+   ppg_furcation_stack_restore(&context->furcation_stack, &context->allocator);
    
-   ppg_active_tokens_restore(&context->active_tokens);
+   ppg_active_tokens_restore(&context->active_tokens, &context->allocator);
    
    ppg_print_context(context);
 }
 
+static void ppg_context_layout_token_state(PPG_Token__ *token, 
+                                           size_t *offset)
+{
+   if(!token->vtable->layout_state) { return; }
+   
+   *offset += token->vtable->layout_state(token, *offset);
+}
+
+void ppg_context_compile_token_states(PPG_Context *context)
+{
+   context->n_tokens = ppg_token_assign_ids(context->pattern_root,
+                                            &context->allocator);
+   
+   size_t offset = 0;
+   
+   ppg_token_traverse_tree(context->pattern_root,
+                           (PPG_Token_Tree_Visitor)ppg_context_layout_token_state,
+                           NULL,
+                           (void*)&offset);
+   
+   context->token_data_size = offset;
+   
+   ppg_context_alloc_token_states(context);
+}
+
+static void ppg_context_init_token_state(PPG_Token__ *token, 
+                                         PPG_Context *context)
+{
+   context->token_states[token->id] = token->misc;
+}
+
+void ppg_context_alloc_token_states(PPG_Context *context)
+{
+   PPG_Token_Id n_tokens = context->n_tokens;
+   size_t token_data_size = context->token_data_size;
+   
+   ppg_context_free_token_states(context);
+   
+   context->n_tokens = n_tokens;
+   context->token_data_size = token_data_size;
+   
+   context->token_states 
+      = (PPG_Misc_Bits *)ppg_allocator_malloc(&context->allocator,
+                                       (size_t)n_tokens*sizeof(PPG_Misc_Bits));
+   
+   context->token_epochs 
+      = (PPG_Token_Epochs *)ppg_allocator_malloc(&context->allocator,
+                                       (size_t)n_tokens*sizeof(PPG_Token_Epochs));
+      
+   memset(context->token_epochs, 0, (size_t)n_tokens*sizeof(PPG_Token_Epochs));
+   
+   context->epoch = 0;
+      
+   ppg_token_traverse_tree(context->pattern_root,
+                           (PPG_Token_Tree_Visitor)ppg_context_init_token_state,
+                           NULL,
+                           (void*)context);
+   
+   if(token_data_size > 0) {
+      
+      context->token_data 
+         = (char *)ppg_allocator_malloc(&context->allocator, token_data_size);
+      
+      memset(context->token_data, 0, token_data_size);
+   }
+}
+
+void ppg_context_free_token_states(PPG_Context *context)
+{
+   ppg_allocator_free(&context->allocator, context->token_states);
+   ppg_allocator_free(&context->allocator, context->token_epochs);
+   ppg_allocator_free(&context->allocator, context->token_data);
+   
+   context->token_states = NULL;
+   context->token_epochs = NULL;
+   context->epoch = 0;
+   context->n_tokens = 0;
+   context->token_data = NULL;
+   context->token_data_size = 0;
+}
+
+// Makes all stale control states explicit to allow for restarting
+// the epoch count
+//
+static void ppg_context_renew_token_epoch(PPG_Token__ *token, 
+                                          PPG_Context *context)
+{
+   PPG_UNUSED(context);
+   
+   // Resets the token state if stale
+   //
+   ppg_token_get_misc(token);
+}
+
+static void ppg_context_restart_epochs(void)
+{
+   ppg_token_traverse_tree(ppg_context->pattern_root,
+                           (PPG_Token_Tree_Visitor)ppg_context_renew_token_epoch,
+                           NULL,
+                           (void*)ppg_context);
+   
+   memset(ppg_context->token_epochs, 0, 
+          (size_t)ppg_context->n_tokens*sizeof(PPG_Token_Epochs));
+   
+   ppg_context->epoch = 0;
+}
+
+void ppg_context_reset_children_control_state(PPG_Token__ *token)
+{
+   if(token->id >= ppg_context->n_tokens) {
+      
+      // Without token epochs we reset the children one by one
+      //
+      for(PPG_Count i = 0; i < token->n_children; ++i) {
+         ppg_token_reset_control_state(token->children[i]);
+      }
+      
+      return;
+   }
+   
+   if(ppg_context->epoch == (PPG_Epoch)-1) {
+      ppg_context_restart_epochs();
+   }
+   
+   ++ppg_context->epoch;
+   
+   ppg_context->token_epochs[token->id].children = ppg_context->epoch;
+}
+
+// Serves tokens that are created while no context is current.
+// Like the arenas of contexts, it is zero initialized, i.e. it 
+// obtains its chunks from the heap. It is never released.
+// Every thread that has its own current context also 
+// has its own orphan arena.
+//
+static PPG_THREAD_LOCAL PPG_Arena ppg_orphan_tree_arena;
+
+void *ppg_tree_malloc(size_t n_bytes)
+{
+   if(!ppg_context) {
+      return ppg_arena_allocate(&ppg_orphan_tree_arena, n_bytes);
+   }
+   
+   return ppg_arena_allocate(&ppg_context->tree_arena, n_bytes);
+}
+
+void ppg_tree_free(void *memory)
+{
+   // All tree memory stems from an arena. The arena is not necessarily
+   // the one of the current context, e.g. if tokens were created 
+   // while another context was current. Thus, memory is only 
+   // reclaimed when its arena is released as a whole.
+   //
+   (void)memory;
+}
+
+void ppg_context_initialize_shared(PPG_Context *shared, 
+                                   PPG_Context *source)
+{
+   PPG_ASSERT(source->token_states);
+   
+   shared->allocator = source->allocator;
+   
+   ppg_event_buffer_init(&shared->event_buffer, &shared->allocator);
+   ppg_furcation_stack_init(&shared->furcation_stack);
+   ppg_active_tokens_init(&shared->active_tokens, &shared->allocator);
+   
+   ppg_global_initialize_context_static(shared);
+   
+   shared->properties = source->properties;
+   shared->properties.destruction_enabled = true;
+   shared->properties.tree_shared = true;
+   
+   // The pattern tree and all data that is derived from it 
+   // is immutable during pattern matching and thus shared
+   //
+   shared->pattern_root = source->pattern_root;
+   shared->child_index = source->child_index;
+   shared->input_masks = source->input_masks;
+   shared->completion_marks = source->completion_marks;
+   shared->tree_depth = source->tree_depth;
+   
+   shared->engine = source->engine;
+   shared->layer = source->layer;
+   shared->abort_trigger_input = source->abort_trigger_input;
+   shared->event_timeout = source->event_timeout;
+   shared->event_processor = source->event_processor;
+   shared->event_span_processor = source->event_span_processor;
+   shared->time_manager = source->time_manager;
+   shared->signal_callback = source->signal_callback;
+   shared->action_dispatcher = source->action_dispatcher;
+   
+   ppg_furcation_stack_resize(&shared->furcation_stack, 
+                              shared->tree_depth,
+                              &shared->allocator);
+   
+   if(source->work_budget.deferred) {
+      ppg_work_budget_set_deferred_capacity(&shared->work_budget,
+                  ppg_work_budget_get_deferred_capacity(&source->work_budget),
+                  &shared->allocator);
+   }
+   
+   ppg_work_budget_set(&shared->work_budget, 
+                       source->work_budget.n_steps,
+                       &shared->allocator);
+   
+   if(shared->engine == PPG_Engine_Parallel) {
+      ppg_parallel_matcher_reserve(&shared->parallel_matcher,
+                     source->n_tokens,
+                     ppg_event_buffer_get_capacity(&shared->event_buffer),
+                     &shared->allocator);
+   }
+   
+   shared->n_tokens = source->n_tokens;
+   shared->token_data_size = source->token_data_size;
+   
+   ppg_context_alloc_token_states(shared);
+}
+
+void ppg_context_finalize_shared(PPG_Context *shared)
+{
+   PPG_ASSERT(shared->properties.tree_shared);
+   
+   #if !PPG_DISABLE_CONTEXT_SWITCHING
+   ppg_timer_wheel_unregister_context(shared);
+   #endif
+   
+   // The pattern tree, the child index, the input masks and 
+   // the completion marks are owned by the source context
+   //
+   ppg_parallel_matcher_free(&shared->parallel_matcher, &shared->allocator);
+   ppg_work_budget_free(&shared->work_budget, &shared->allocator);
+   ppg_context_free_token_states(shared);
+   ppg_arena_free(&shared->tree_arena);
+   
+   ppg_event_buffer_free(&shared->event_buffer, &shared->allocator);
+   ppg_furcation_stack_free(&shared->furcation_stack, &shared->allocator);
+   ppg_active_tokens_free(&shared->active_tokens, &shared->allocator);
+}
+
 void ppg_print_context(PPG_Context *context)
 {
    // The following is necessary as the PPG_LOG macros might be
@@ -22,10 +22,28 @@
 #include "detail/ppg_token_detail.h"
 #include "detail/ppg_event_buffer_detail.h"
 #include "detail/ppg_active_tokens_detail.h"
+#include "detail/ppg_child_index_detail.h"
+#include "detail/ppg_parallel_matching_detail.h"
+#include "detail/ppg_arena_detail.h"
+#include "detail/ppg_work_budget_detail.h"
 #include "ppg_signal_callback.h"
 #include "ppg_statistics.h"
+#include "detail/ppg_input_detail.h"
+#include "ppg_bitfield.h"
 
 #include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t PPG_Epoch;
+
+// Resetting the control state of all children of a token is done
+// by assigning a new epoch to the parent. The state of a child is
+// stale if its epoch is older than that of its parent's children.
+//
+typedef struct {
+   PPG_Epoch state; ///< The epoch at which the token state was last valid
+   PPG_Epoch children; ///< The epoch at which the children were reset
+} PPG_Token_Epochs;
 
 typedef struct {
    unsigned int timeout_enabled    : 1;
@@ -34,20 +52,71 @@ typedef struct {
    unsigned int logging_enabled   : 1;
    #endif
    unsigned int destruction_enabled : 1;
+   unsigned int tree_shared : 1;
+   unsigned int event_time_enabled : 1;
 } PPG_Context_Properties;
 
 typedef struct PPG_Context_Struct
 {
+   // Provides all dynamic memory of the context. Assigned 
+   // when the context is created.
+   //
+   PPG_Allocator allocator;
+   
    PPG_Event_Buffer event_buffer;
    PPG_Furcation_Stack furcation_stack;
    PPG_Active_Tokens active_tokens;
    
    PPG_Token__ *pattern_root;
+   
+   // All memory of the pattern tree is taken from the tree arena
+   //
+   PPG_Arena tree_arena;
+   
+   // The children pointer arrays of all tokens of the pattern tree,
+   // stored contiguously in breadth first order 
+   // (see ppg_token_compact_children)
+   //
+   PPG_Token__ **children_block;
 
    PPG_Token__ *current_token;
    
+   PPG_Child_Index child_index;
+   
+   PPG_Parallel_Matcher parallel_matcher;
+   
+   // Bounds the pattern matching work per call and keeps 
+   // track of work that is to be resumed
+   //
+   PPG_Work_Budget work_budget;
+   
+   // The inputs that are used by the subtrees of the tokens
+   // of the pattern tree, indexed by token id
+   //
+   PPG_Input_Masks input_masks;
+   
+   // Tell which tokens complete a pattern when they match,
+   // indexed by token id
+   //
+   PPG_Completion_Marks completion_marks;
+   
+   // The matching state of the tokens of the pattern tree. 
+   // The misc bits of every token are indexed by token id. 
+   // Tokens that require further state (e.g. aggregates) store it 
+   // in the token data block.
+   //
+   PPG_Misc_Bits *token_states;
+   PPG_Token_Epochs *token_epochs;
+   PPG_Epoch epoch;
+   PPG_Token_Id n_tokens;
+   
+   char *token_data;
+   size_t token_data_size;
+   
    PPG_Context_Properties properties;
    
+   PPG_Count engine;
+   
    PPG_Count tree_depth;
    
    PPG_Layer layer;
@@ -60,23 +129,94 @@ typedef struct PPG_Context_Struct
    
    PPG_Event_Processor_Fun event_processor;
    
+   PPG_Event_Span_Processor_Fun event_span_processor;
+   
    PPG_Time_Manager time_manager;
    
    PPG_Signal_Callback signal_callback;
    
+   PPG_Action_Dispatcher action_dispatcher;
+   
+   #if !PPG_DISABLE_CONTEXT_SWITCHING
+   // Non-NULL if the context is registered with a timer wheel
+   //
+   struct PPG_Timer_Wheel_Entry_Struct *timer_wheel_entry;
+   #endif
+   
    #if PPG_HAVE_STATISTICS
    PPG_Statistics statistics;
    #endif
   
 } PPG_Context;
 
-#ifdef __cplusplus
-extern
+// If PPG_THREAD_LOCAL_CONTEXT is set (the default), every thread has 
+// its own current context. This allows for contexts being used 
+// concurrently by different threads, e.g. through the ppg_ctx_... 
+// functions. Platforms without thread local storage, as well as builds 
+// that disable the option, fall back to a plain global current context 
+// that is shared by all threads.
+//
+#ifndef PPG_THREAD_LOCAL
+#if    !PPG_THREAD_LOCAL_CONTEXT \
+    || PPG_DISABLE_CONTEXT_SWITCHING \
+    || defined(__AVR__)
+#define PPG_THREAD_LOCAL
+#define PPG_HAVE_THREAD_LOCAL_CONTEXT 0
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) \
+      && !defined(__STDC_NO_THREADS__)
+#define PPG_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define PPG_THREAD_LOCAL __thread
+#else
+#define PPG_THREAD_LOCAL
+#define PPG_HAVE_THREAD_LOCAL_CONTEXT 0
+#endif
+#endif
+
+#ifndef PPG_HAVE_THREAD_LOCAL_CONTEXT
+#define PPG_HAVE_THREAD_LOCAL_CONTEXT 1
 #endif
-PPG_Context *ppg_context;
+
+extern PPG_THREAD_LOCAL PPG_Context *ppg_context;
+
+// Returns the misc bits of a token that are associated with 
+// the current context. Tokens that have not been compiled 
+// yet fall back to their template. Stale control states
+// are reset lazily.
+//
+inline
+static PPG_Misc_Bits *ppg_token_get_misc(PPG_Token__ *token)
+{
+   if(token->id < ppg_context->n_tokens) {
+      
+      PPG_Misc_Bits *misc = &ppg_context->token_states[token->id];
+      
+      if(token->parent) {
+         
+         PPG_Epoch children_epoch 
+            = ppg_context->token_epochs[token->parent->id].children;
+            
+         PPG_Epoch *state_epoch 
+            = &ppg_context->token_epochs[token->id].state;
+         
+         if(*state_epoch < children_epoch) {
+            misc->state = PPG_Token_Initialized;
+            misc->action_state = PPG_Action_Disabled;
+            *state_epoch = children_epoch;
+         }
+      }
+      
+      return misc;
+   }
+   
+   return &token->misc;
+}
+
+#define PPG_TOKEN_MISC(TOKEN) (*ppg_token_get_misc((PPG_Token__*)(TOKEN)))
 
 void ppg_global_initialize_context_static(PPG_Context *context);
-void ppg_global_initialize_context(PPG_Context *context);
+void ppg_global_initialize_context(PPG_Context *context,
+                                   PPG_Allocator allocator);
 
 size_t ppg_context_get_size_requirements(PPG_Context *context);
 
@@ -84,6 +224,44 @@ char *ppg_context_copy(PPG_Context *context, void *target__);
 
 void ppg_restore_context(PPG_Context *context);
 
+// Assigns token ids and lays out the token data block. 
+// Afterwards the token states of the context are allocated.
+//
+void ppg_context_compile_token_states(PPG_Context *context);
+
+// Allocates and initializes the token states of a context
+// whose pattern tree has already been compiled
+//
+void ppg_context_alloc_token_states(PPG_Context *context);
+
+void ppg_context_free_token_states(PPG_Context *context);
+
+// Resets the control state of all children of a token of the
+// current context
+//
+void ppg_context_reset_children_control_state(PPG_Token__ *token);
+
+// Initializes a context that shares the compiled pattern tree
+// of a source context, see ppg_context_create_shared
+//
+// Allocates memory for the pattern tree of the current context
+//
+void *ppg_tree_malloc(size_t n_bytes);
+
+// Releases memory of the pattern tree. This is a no-op. All tree memory 
+// stems from an arena and is only reclaimed when the context that owns 
+// the arena is destroyed.
+//
+void ppg_tree_free(void *memory);
+
+void ppg_context_initialize_shared(PPG_Context *shared, 
+                                   PPG_Context *source);
+
+// Frees all resources that are owned by a shared context,
+// except for the context itself
+//
+void ppg_context_finalize_shared(PPG_Context *shared);
+
 void ppg_print_context(PPG_Context *context);
 
 /* The following macros influence the build
@@ -91,6 +269,16 @@ void ppg_print_context(PPG_Context *context);
 PPG_DISABLE_CONTEXT_SWITCHING 
       Disables the capability to switch contexts 
 
+PPG_THREAD_LOCAL
+      The storage class specifier of the current context. Defaults 
+      to a thread local storage class if PPG_THREAD_LOCAL_CONTEXT is 
+      set and is empty otherwise.
+
+PPG_HAVE_THREAD_LOCAL_CONTEXT
+      Whether PPG_THREAD_LOCAL actually is a thread local storage class.
+      Must be defined alongside PPG_THREAD_LOCAL if that is set 
+      from outside and is empty.
+
 */
 
 #define PPG_EB ppg_context->event_buffer
@@ -18,6 +18,7 @@
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_global_detail.h"
 #include "detail/ppg_malloc_detail.h"
+#include "detail/ppg_signal_detail.h"
 #include "ppg_debug.h"
 #include "ppg_settings.h"
 
@@ -27,57 +28,98 @@
 
 #define PPG_EB ppg_context->event_buffer
 
-PPG_Count ppg_event_buffer_size(void)
+PPG_Event_Buffer_Index_Type ppg_event_buffer_size(void)
 {
    return PPG_EB.size;
 }
 
 void ppg_event_buffer_resize(PPG_Event_Buffer *event_buffer,
-                             PPG_Count new_size)
+                             size_t n_slots,
+                             PPG_Allocator *allocator)
 {
    PPG_ASSERT(event_buffer);
    
-   if(new_size <= event_buffer->max_size) { return; }
+   size_t old_capacity = ppg_event_buffer_get_capacity(event_buffer);
    
-   PPG_Event_Queue_Entry *new_events
-      = (PPG_Event_Queue_Entry*)PPG_MALLOC(sizeof(PPG_Event_Queue_Entry)*new_size);
-      
-   event_buffer->max_size = new_size;
+   if(n_slots <= old_capacity) { return; }
+   
+   size_t new_capacity = (old_capacity > 0) ? old_capacity : 1;
    
-   if(event_buffer->events && (event_buffer->size > 0)) {
-      memcpy(new_events, event_buffer->events, 
-             sizeof(PPG_Event_Queue_Entry)*event_buffer->size);
+   while(new_capacity < n_slots) {
+      new_capacity *= 2;
    }
    
-   event_buffer->events = new_events;
+   PPG_ASSERT(new_capacity <= PPG_EVENT_BUFFER_MAX_CAPACITY);
+   
+   event_buffer->events
+      = (PPG_Event*)ppg_allocator_realloc(allocator,
+                              event_buffer->events,
+                              sizeof(PPG_Event)*new_capacity);
+   event_buffer->entries
+      = (PPG_Event_Queue_Entry*)ppg_allocator_realloc(allocator,
+                              event_buffer->entries,
+                              sizeof(PPG_Event_Queue_Entry)*new_capacity);
+   
+   event_buffer->mask = (PPG_Event_Buffer_Index_Type)(new_capacity - 1);
+   
+   if(old_capacity == 0) { return; }
+   
+   // The storage index of a stored event either stays the same or it
+   // moves to the newly added part of the storage. As stored events 
+   // span less than the old capacity, no event is overwritten.
+   //
+   for(PPG_Event_Buffer_Index_Type pos = event_buffer->start; 
+       pos != event_buffer->end; ++pos) {
+      
+      size_t old_index = pos & (old_capacity - 1);
+      size_t new_index = pos & event_buffer->mask;
+      
+      if(new_index != old_index) {
+         event_buffer->events[new_index] = event_buffer->events[old_index];
+         event_buffer->entries[new_index] = event_buffer->entries[old_index];
+      }
+   }
 }
 
-// Returns an in place version of the event
+// Returns an in place version of the event or NULL if the 
+// event was dropped
 //
 PPG_Event * ppg_event_buffer_store_event(PPG_Event *event)
 {
-   #if PPG_HAVE_ASSERTIONS
-   if(PPG_EB.start > PPG_EB.end) {
-      PPG_Count n_events = PPG_EB.max_size + PPG_EB.end - PPG_EB.start;
-      PPG_ASSERT(n_events < PPG_EB.max_size - 1); // At least one left!
-   }
-   else {
-      PPG_Count n_events = PPG_EB.end - PPG_EB.start;
-      PPG_ASSERT(n_events <= PPG_EB.max_size - 1); // At least one left!
+   // One slot is always kept free. Thus, the buffer must grow if
+   // there is only one left.
+   //
+   if(PPG_EB.size == PPG_EB.mask) {
+      
+      size_t capacity = ppg_event_buffer_get_capacity(&PPG_EB);
+      
+      // The storage of contexts that are not dynamically allocated 
+      // stems from static arrays. Contexts that live in a fixed 
+      // buffer keep the capacity that was reserved up front.
+      //
+      if(   !ppg_context->properties.destruction_enabled
+         || ppg_allocator_is_fixed_buffer(&ppg_context->allocator)
+         || (capacity == PPG_EVENT_BUFFER_MAX_CAPACITY)) {
+         
+         PPG_LOG("Event buffer full, dropping event\n");
+         
+         ppg_signal(PPG_On_Event_Dropped);
+         
+         return NULL;
+      }
+      
+      PPG_LOG("Growing event buffer\n");
+      
+      ppg_event_buffer_resize(&PPG_EB, 2*capacity, &ppg_context->allocator);
    }
-   #endif
    
    PPG_Event_Buffer_Index_Type new_pos = PPG_EB.end;
    
-   if(PPG_EB.end == PPG_EB.max_size - 1) {
-      PPG_EB.end = 0;
-   }
-   else {
-      ++PPG_EB.end;
-   }
+   ++PPG_EB.end;
+   
+   PPG_EB_EVENT(new_pos) = *event;
    
-   PPG_EB.events[new_pos] = (PPG_Event_Queue_Entry) {
-      .event = *event,
+   PPG_EB_ENTRY(new_pos) = (PPG_Event_Queue_Entry) {
       .consumer = NULL,
       .token_state = (PPG_Token_State) {
          .state = 0,
@@ -91,7 +133,7 @@ PPG_Event * ppg_event_buffer_store_event(PPG_Event *event)
    PPG_LOG("   start: %u, cur: %u, end: %u, size: %u\n", 
               PPG_EB.start, PPG_EB.cur, PPG_EB.end, PPG_EB.size);
    
-   return &PPG_EB.events[new_pos].event;
+   return &PPG_EB_EVENT(new_pos);
 }
 
 void ppg_event_buffer_reset(PPG_Event_Buffer *eb)
@@ -107,33 +149,39 @@ void ppg_event_buffer_reset(PPG_Event_Buffer *eb)
               eb->start, eb->cur, eb->end, eb->size);
 }
 
-void ppg_event_buffer_init(PPG_Event_Buffer *eb)
+void ppg_event_buffer_init(PPG_Event_Buffer *eb,
+                           PPG_Allocator *allocator)
 {
    ppg_event_buffer_reset(eb);
    
-   eb->max_size = 0;
+   eb->mask = 0;
    eb->events = NULL;
+   eb->entries = NULL;
    
-   ppg_event_buffer_resize(eb, PPG_MAX_EVENTS);
+   ppg_event_buffer_resize(eb, PPG_MAX_EVENTS, allocator);
 }
 
-void ppg_event_buffer_restore(PPG_Event_Buffer *eb)
+void ppg_event_buffer_restore(PPG_Event_Buffer *eb,
+                              PPG_Allocator *allocator)
 {
-   PPG_Count safed_size = eb->max_size;
+   size_t safed_capacity = (size_t)eb->mask + 1;
    
-   eb->events = NULL; 
-   eb->max_size = 0; // This forces resize 
+   eb->events = NULL; // This forces resize 
+   eb->entries = NULL;
    
-   ppg_event_buffer_resize(eb, safed_size);
+   ppg_event_buffer_resize(eb, safed_capacity, allocator);
 }
 
-void ppg_event_buffer_free(PPG_Event_Buffer *event_buffer)
+void ppg_event_buffer_free(PPG_Event_Buffer *event_buffer,
+                           PPG_Allocator *allocator)
 {
    if(!event_buffer->events) { return; }
    
-   free(event_buffer->events);
+   ppg_allocator_free(allocator, event_buffer->events);
+   ppg_allocator_free(allocator, event_buffer->entries);
    
    event_buffer->events = NULL;
+   event_buffer->entries = NULL;
 }
 
 bool ppg_event_buffer_events_left(void)
@@ -147,12 +195,7 @@ void ppg_event_buffer_advance(void)
 {
    if(PPG_EB.size == 0) { return; }
    
-   if(PPG_EB.cur == PPG_EB.max_size - 1) {
-      PPG_EB.cur = 0;
-   }
-   else {
-      ++PPG_EB.cur;
-   }
+   ++PPG_EB.cur;
    
    #if PPG_HAVE_ASSERTIONS
    ppg_check_event_buffer_validity();
@@ -166,51 +209,36 @@ void ppg_event_buffer_advance(void)
 #if PPG_HAVE_ASSERTIONS
 void ppg_check_event_buffer_validity(void)
 {
-   if(PPG_EB.end > PPG_EB.start) {
-      PPG_ASSERT(PPG_EB.cur >= PPG_EB.start);
-      PPG_ASSERT(PPG_EB.cur <= PPG_EB.end);
-   }
-   else if(PPG_EB.end == PPG_EB.start) {
-      // The event buffer might be either full (wrapped around)
-      // or empty.
-      //
-      PPG_ASSERT((PPG_EB.size == 0) | (PPG_EB.size == PPG_EB.max_size));
-//       PPG_ASSERT(PPG_EB.end == PPG_EB.cur);
-   }
-   else {
-      PPG_ASSERT( !(    (PPG_EB.cur > PPG_EB.end)
-                     && (PPG_EB.cur < PPG_EB.start)));
-   }
+   PPG_Event_Buffer_Index_Type n_events 
+      = (PPG_Event_Buffer_Index_Type)(PPG_EB.end - PPG_EB.start);
+   PPG_Event_Buffer_Index_Type n_processed 
+      = (PPG_Event_Buffer_Index_Type)(PPG_EB.cur - PPG_EB.start);
+   
+   PPG_ASSERT(n_events == PPG_EB.size);
+   PPG_ASSERT(n_events <= PPG_EB.mask);
+   PPG_ASSERT(n_processed <= n_events);
 }
 #endif
 
 static void ppg_even_buffer_recompute_size(void)
 {
-   if(PPG_EB.end > PPG_EB.start) {
-      
-      PPG_EB.size = PPG_EB.end - PPG_EB.start;
-   }
-   else if(PPG_EB.end == PPG_EB.start) {
-      PPG_EB.size = 0;
-   }
-   else {
-      
-      PPG_EB.size = PPG_EB.max_size + PPG_EB.end - PPG_EB.start;
-   }
+   PPG_EB.size = (PPG_Event_Buffer_Index_Type)(PPG_EB.end - PPG_EB.start);
 }
 
-static void ppg_flush_non_considered_events(PPG_Event_Queue_Entry *eqe, 
+static void ppg_flush_non_considered_events(PPG_Event *event,
+                                            PPG_Event_Queue_Entry *eqe, 
                                             void *user_data)
 {
+   PPG_UNUSED(eqe);
    PPG_UNUSED(user_data);
    
-   if(!(eqe->event.flags & PPG_Event_Considered)) {
+   if(!(event->flags & PPG_Event_Considered)) {
 
       // Events that were not considered and are 
       // not control tags such as those used for 
       // abort input events are flushed
       //
-      ppg_context->event_processor(&eqe->event, NULL);
+      ppg_context->event_processor(event, NULL);
    }
 }
 
@@ -230,7 +258,7 @@ void ppg_event_buffer_truncate_at_front(void)
       // Temporarily reset the end of the event buffer to
       // simplify flushing
       //
-      PPG_Count old_end = PPG_EB.end;
+      PPG_Event_Buffer_Index_Type old_end = PPG_EB.end;
       PPG_EB.end = PPG_EB.cur;
       
       PPG_LOG("Truncating event buffer at front\n")
@@ -259,12 +287,7 @@ void ppg_event_buffer_remove_first_event(void)
 {
    if(PPG_EB.size == 0) { return; }
    
-   if(PPG_EB.start < PPG_EB.max_size - 1) {
-      ++PPG_EB.start;
-   }
-   else {
-      PPG_EB.start = 0;
-   }
+   ++PPG_EB.start;
    
    --PPG_EB.size;
    
@@ -274,39 +297,88 @@ void ppg_event_buffer_remove_first_event(void)
    
 }
 
-void ppg_even_buffer_flush_and_remove_first_event(bool on_success)
+uint8_t ppg_event_buffer_get_spans(PPG_Event_Buffer *eb,
+                                   PPG_Event_Buffer_Index_Type first_pos,
+                                   size_t n_events,
+                                   PPG_Event_Span *spans)
 {
-   PPG_UNUSED(on_success);
+   if(n_events == 0) { return 0; }
    
-//    PPG_LOG("Flushing and removing first event\n");
+   size_t first = first_pos & eb->mask;
+   size_t n_head = ppg_event_buffer_get_capacity(eb) - first;
    
-   ppg_context->event_processor(&PPG_EB.events[PPG_EB.start].event, NULL);
+   uint8_t n_spans = 1;
    
-   if(PPG_EB.size > 1) {
-      ppg_event_buffer_remove_first_event();
+   // The tail part wraps around to the start of the storage
+   //
+   if(n_events > n_head) {
+      spans[1] = (PPG_Event_Span) {
+         .events = eb->events,
+         .n_events = n_events - n_head
+      };
+      n_spans = 2;
    }
    else {
-      ppg_event_buffer_reset(&PPG_EB);
+      n_head = n_events;
    }
+   
+   spans[0] = (PPG_Event_Span) {
+      .events = &eb->events[first],
+      .n_events = n_head
+   };
+   
+   for(uint8_t i = 0; i < n_spans; ++i) {
+      
+      spans[i].n_considered = 0;
+      
+      for(size_t e = 0; e < spans[i].n_events; ++e) {
+         if(spans[i].events[e].flags & PPG_Event_Considered) {
+            ++spans[i].n_considered;
+         }
+      }
+   }
+   
+   return n_spans;
 }
 
-void ppg_event_buffer_flush_and_remove_non_processable_deactivation_events(void)
+void ppg_event_buffer_flush_failed_front(void)
 {
-   // Remove events...
+   // The first event cannot be part of a match any more. The 
+   // same holds for the deactivation events that directly follow it 
+   // as they cannot be fed to any active tokens.
    //
-   while(
+   size_t n_events = 1;
+   
+   while(   (n_events < PPG_EB.size)
+         && !(PPG_EB_EVENT(PPG_EB.start + n_events).flags & PPG_Event_Active)) {
+      ++n_events;
+   }
+   
+   PPG_LOG("Flushing %lu events at front\n", (unsigned long)n_events);
+   
+   if(ppg_context->event_span_processor) {
       
-      // While there are any
+      // Pass all events with a single call
       //
-      (PPG_EB.size > 0) 
+      PPG_Event_Span spans[2];
       
-      // And if those events are deactivation events and cannot be fed to
-      // any active tokens
-      //
-      && !(PPG_EB.events[PPG_EB.start].event.flags & PPG_Event_Active)
-   )
-   {
-      ppg_even_buffer_flush_and_remove_first_event(false);
+      uint8_t n_spans 
+         = ppg_event_buffer_get_spans(&PPG_EB, PPG_EB.start, n_events, spans);
+      
+      ppg_context->event_span_processor(spans, n_spans, NULL);
+   }
+   else {
+      for(size_t i = 0; i < n_events; ++i) {
+         ppg_context->event_processor(&PPG_EB_EVENT(PPG_EB.start + i), NULL);
+      }
+   }
+   
+   if(n_events < PPG_EB.size) {
+      PPG_EB.start += (PPG_Event_Buffer_Index_Type)n_events;
+      PPG_EB.size -= (PPG_Event_Buffer_Index_Type)n_events;
+   }
+   else {
+      ppg_event_buffer_reset(&PPG_EB);
    }
 }
 
@@ -336,38 +408,13 @@ uint8_t ppg_event_buffer_iterate2(
    
    uint8_t nEventsProcessed = 0;
    
-//    PPG_SERIAL_PRINT("start: %d, end: %d, size: %d, max_size: %d\n",
-//  (int)PPG_EB.start, (int)PPG_EB.end, (int)PPG_EB.size, (int)PPG_EB.max_size);
+   PPG_LOG("Processing %d events\n", PPG_EB.size);
    
-   if(PPG_EB.start >= PPG_EB.end) {
-      
-//       nEventsProcessed = PPG_EB.max_size - PPG_EB.start + PPG_EB.end;
-      
-      PPG_LOG("Event buffer wrapps around\n")
-      PPG_LOG("Processing %d events\n", PPG_EB.size);
-      
-      for(PPG_Count i = PPG_EB.start; i < PPG_EB.max_size; ++i) {
+   for(PPG_Event_Buffer_Index_Type pos = PPG_EB.start; 
+       pos != PPG_EB.end; ++pos) {
       
-         PPG_LOG("   event %d\n", i)
-         visitor(&PPG_EB.events[i], user_data);
-      }
-      for(PPG_Count i = 0; i < PPG_EB.end; ++i) {
-         
-         PPG_LOG("   event %d\n", i)
-         visitor(&PPG_EB.events[i], user_data);
-      }
-   }
-   else {
-      
-//       nEventsProcessed = PPG_EB.end - PPG_EB.start;
-      
-      PPG_LOG("Processing %d events\n", PPG_EB.size);
-      
-      for(PPG_Count i = PPG_EB.start; i < PPG_EB.end; ++i) {
-      
-         PPG_LOG("   event %d\n", i)
-         visitor(&PPG_EB.events[i], user_data);
-      }
+      PPG_LOG("   event %d\n", pos)
+      visitor(&PPG_EB_EVENT(pos), &PPG_EB_ENTRY(pos), user_data);
    }
    
    return nEventsProcessed;
@@ -17,53 +17,95 @@
 #ifndef PPG_EVENT_BUFFER_DETAIL_H
 #define PPG_EVENT_BUFFER_DETAIL_H
 
+#include "ppg_allocator.h"
 #include "ppg_event.h"
+#include "ppg_event_buffer.h"
 #include "ppg_settings.h"
 #include "ppg_bitfield.h"
 #include "detail/ppg_token_detail.h"
 
+#include <stddef.h>
+
 typedef struct {
    unsigned char state         : PPG_Token_N_State_Bits;
    unsigned int changed       : 1;
 } PPG_Token_State;
 
+// The matching state of a stored event
+//
 typedef struct {
-   PPG_Event      event;
    PPG_Token__    *consumer;
    PPG_Token_State      token_state;
 } PPG_Event_Queue_Entry;
 
-// The event buffer is a ring buffer
-//
+// The event buffer is a ring buffer whose capacity is a power of two.
+// Positions (start, end, cur) are not wrapped explicitly. They 
+// run freely and wrap around modulo the range of 
+// PPG_Event_Buffer_Index_Type. The storage index of a position
+// is obtained by masking.
+// 
+// Events and their matching state are stored in separate arrays.
+// This keeps the events contiguous to allow them to be passed
+// to the user in spans.
+// 
 typedef struct {
    
-//    PPG_Event_Queue_Entry events[PPG_MAX_EVENTS];
-   PPG_Event_Queue_Entry *events;
+   PPG_Event *events;
+   PPG_Event_Queue_Entry *entries;
    
    PPG_Event_Buffer_Index_Type start;
    PPG_Event_Buffer_Index_Type end;
    PPG_Event_Buffer_Index_Type cur;
    
-   PPG_Count size;
+   PPG_Event_Buffer_Index_Type size;
    
-   PPG_Count max_size;
+   PPG_Event_Buffer_Index_Type mask; ///< The capacity minus one
    
 } PPG_Event_Buffer;
 
+// The maximum capacity of an event buffer is the range 
+// of the position type
+//
+#define PPG_EVENT_BUFFER_MAX_CAPACITY \
+   ((size_t)(PPG_Event_Buffer_Index_Type)-1 + 1)
+
+#define PPG_EB_INDEX(POS) \
+   ((PPG_Event_Buffer_Index_Type)(POS) & PPG_EB.mask)
+   
+#define PPG_EB_EVENT(POS) PPG_EB.events[PPG_EB_INDEX(POS)]
+#define PPG_EB_ENTRY(POS) PPG_EB.entries[PPG_EB_INDEX(POS)]
+
+// Returns the number of storage slots. One of them is always 
+// kept free.
+//
+inline
+static size_t ppg_event_buffer_get_capacity(PPG_Event_Buffer *eb)
+{
+   return (eb->events) ? (size_t)eb->mask + 1 : 0;
+}
+
+// Grows the event buffer to hold at least the given number of slots.
+// The capacity is rounded up to the next power of two. 
+// Stored events keep their positions.
+//
 void ppg_event_buffer_resize(PPG_Event_Buffer *event_buffer,
-                             PPG_Count new_size);
+                             size_t n_slots,
+                             PPG_Allocator *allocator);
 
-PPG_Count ppg_event_buffer_size(void);
+PPG_Event_Buffer_Index_Type ppg_event_buffer_size(void);
 
-void ppg_event_buffer_restore(PPG_Event_Buffer *eb);
+void ppg_event_buffer_restore(PPG_Event_Buffer *eb,
+                              PPG_Allocator *allocator);
 
 PPG_Event * ppg_event_buffer_store_event(PPG_Event *event);
 
-void ppg_event_buffer_init(PPG_Event_Buffer *eb);
+void ppg_event_buffer_init(PPG_Event_Buffer *eb,
+                           PPG_Allocator *allocator);
 
 void ppg_event_buffer_reset(PPG_Event_Buffer *eb);
 
-void ppg_event_buffer_free(PPG_Event_Buffer *event_buffer);
+void ppg_event_buffer_free(PPG_Event_Buffer *event_buffer,
+                           PPG_Allocator *allocator);
 
 bool ppg_event_buffer_events_left(void);
 
@@ -73,11 +115,22 @@ void ppg_event_buffer_truncate_at_front(void);
 
 void ppg_event_buffer_remove_first_event(void);
 
-void ppg_even_buffer_flush_and_remove_first_event(bool on_success);
-
-void ppg_event_buffer_flush_and_remove_non_processable_deactivation_events(void);
+// Splits a run of stored events into at most two contiguous spans
+// and returns their number
+//
+uint8_t ppg_event_buffer_get_spans(PPG_Event_Buffer *eb,
+                                   PPG_Event_Buffer_Index_Type first_pos,
+                                   size_t n_events,
+                                   PPG_Event_Span *spans);
+
+// Flushes and removes the first event after a failed match along with
+// the deactivation events that directly follow it. If a default span 
+// processor is set, the events are passed with a single call.
+//
+void ppg_event_buffer_flush_failed_front(void);
 
-typedef void (*PPG_Event_Processor_Visitor)(PPG_Event_Queue_Entry *eqe,
+typedef void (*PPG_Event_Processor_Visitor)(PPG_Event *event,
+                        PPG_Event_Queue_Entry *eqe,
                         void *user_data);
 
 uint8_t ppg_event_buffer_iterate2(
@@ -0,0 +1,40 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PPG_EVENT_DETAIL_H
+#define PPG_EVENT_DETAIL_H
+
+#include "ppg_event.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Resumes pending work and processes deferred events of the current 
+// context within the remaining work budget. Returns true if the 
+// work budget was exhausted before all work was done.
+//
+bool ppg_event_resume_work(void);
+
+// Processes events that carry their time of arrival, see 
+// ppg_event_process_batch, until the work budget of the current 
+// context is exhausted. The work budget is not refilled. Returns 
+// the number of events that were consumed. The remaining events 
+// have not been touched.
+//
+size_t ppg_event_process_until_busy(PPG_Event *events, size_t n_events);
+
+#endif
@@ -33,26 +33,23 @@ void ppg_furcation_stack_init(PPG_Furcation_Stack *stack)
 }
 
 void ppg_furcation_stack_resize(PPG_Furcation_Stack *stack, 
-                                PPG_Count new_size)
+                                PPG_Count new_size,
+                                PPG_Allocator *allocator)
 {
    PPG_ASSERT(stack);
    
    if(new_size <= stack->max_furcations) { return; }
    
-   PPG_Furcation *new_furcations
-      = (PPG_Furcation*)PPG_MALLOC(sizeof(PPG_Furcation)*new_size);
+   stack->furcations
+      = (PPG_Furcation*)ppg_allocator_realloc(allocator,
+                                 stack->furcations,
+                                 sizeof(PPG_Furcation)*new_size);
       
    stack->max_furcations = new_size;
-   
-   if(stack->furcations && (stack->max_furcations > 0)) {
-      memcpy(new_furcations, stack->furcations, 
-             sizeof(PPG_Furcation)*stack->max_furcations);
-   }
-   
-   stack->furcations = new_furcations;
 }
 
-void ppg_furcation_stack_restore(PPG_Furcation_Stack *stack)
+void ppg_furcation_stack_restore(PPG_Furcation_Stack *stack,
+                                 PPG_Allocator *allocator)
 {
    PPG_ASSERT(stack);
    
@@ -68,14 +65,15 @@ void ppg_furcation_stack_restore(PPG_Furcation_Stack *stack)
    stack->furcations = NULL;
    stack->max_furcations = 0;
    
-   ppg_furcation_stack_resize(stack, saved_size);
+   ppg_furcation_stack_resize(stack, saved_size, allocator);
 }
 
-void ppg_furcation_stack_free(PPG_Furcation_Stack *stack)
+void ppg_furcation_stack_free(PPG_Furcation_Stack *stack,
+                              PPG_Allocator *allocator)
 {
    if(!stack->furcations) { return; }
    
-   free(stack->furcations);
+   ppg_allocator_free(allocator, stack->furcations);
    
    stack->furcations = NULL;
 }
@@ -17,6 +17,7 @@
 #ifndef PPG_FURCATION_DETAIL_H
 #define PPG_FURCATION_DETAIL_H
 
+#include "ppg_allocator.h"
 #include "ppg_settings.h"
 #include "detail/ppg_token_detail.h"
 #include "ppg_bitfield.h"
@@ -25,7 +26,7 @@ typedef struct {
    PPG_Count n_branch_candidates; ///< The number of remaining
                      // branches that have not been checked yet
                      
-   PPG_Count event_id; ///< The index of the first event 
+   PPG_Event_Buffer_Index_Type event_id; ///< The position of the first event 
                      //   in the event buffer that is fed to 
                      // one of the tokens in the branch
    PPG_Token__ *token;
@@ -47,11 +48,14 @@ typedef struct {
 void ppg_furcation_stack_init(PPG_Furcation_Stack *stack);
 
 void ppg_furcation_stack_resize(PPG_Furcation_Stack *stack, 
-                                PPG_Count new_size);
+                                PPG_Count new_size,
+                                PPG_Allocator *allocator);
 
-void ppg_furcation_stack_restore(PPG_Furcation_Stack *stack);
+void ppg_furcation_stack_restore(PPG_Furcation_Stack *stack,
+                                 PPG_Allocator *allocator);
 
-void ppg_furcation_stack_free(PPG_Furcation_Stack *stack);
+void ppg_furcation_stack_free(PPG_Furcation_Stack *stack,
+                              PPG_Allocator *allocator);
 
 #ifndef NDEBUG
 PPG_Furcation *ppg_furcation_checked_access(PPG_Count pos);
@@ -17,6 +17,7 @@
 #include "detail/ppg_global_detail.h"
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_pattern_matching_detail.h"
+#include "detail/ppg_parallel_matching_detail.h"
 #include "detail/ppg_signal_detail.h"
 #include "ppg_debug.h"
 
@@ -34,8 +35,8 @@ bool ppg_recurse_and_process_actions(PPG_Token__ *cur_token)
    // finished. Then we go back to the parent token, that
    // was the last registered match.
    //
-   if(   (cur_token->misc.state != PPG_Token_Matches)
-      && (cur_token->misc.state != PPG_Token_Finalized) 
+   if(   (PPG_TOKEN_MISC(cur_token).state != PPG_Token_Matches)
+      && (PPG_TOKEN_MISC(cur_token).state != PPG_Token_Finalized) 
    ) {
       cur_token = cur_token->parent;
    }
@@ -46,7 +47,7 @@ bool ppg_recurse_and_process_actions(PPG_Token__ *cur_token)
          
          // Store the tokens that carry actions in reversed order
          //
-         cur_token->misc.action_state = PPG_Action_Enabled;
+         PPG_TOKEN_MISC(cur_token).action_state = PPG_Action_Enabled;
          ++n_actions;
          
          if(cur_token->misc.action_flags & PPG_Action_Fallback) {
@@ -72,6 +73,10 @@ bool ppg_recurse_and_process_actions(PPG_Token__ *cur_token)
 void ppg_delete_stored_events(void)
 {
    ppg_event_buffer_reset(&ppg_context->event_buffer); 
+   
+   if(ppg_context->engine == PPG_Engine_Parallel) {
+      ppg_parallel_matching_on_events_deleted();
+   }
 }
 
 void ppg_reset_pattern_matching_engine(void)
@@ -80,10 +85,12 @@ void ppg_reset_pattern_matching_engine(void)
             
    PPG_FB.cur_furcation = -1;
    
+   ppg_parallel_matcher_reset(&ppg_context->parallel_matcher);
+   
    // The token root's state has been reset to PPG_Token_Initialized 
    // during cleanup.
    //
-   ppg_context->pattern_root->misc.state
+   PPG_TOKEN_MISC(ppg_context->pattern_root).state
          = PPG_Token_Initialized;
    
    // Start with the first token in the queue
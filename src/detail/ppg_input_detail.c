@@ -15,12 +15,176 @@
  */
 
 #include "detail/ppg_input_detail.h"
+#include "detail/ppg_malloc_detail.h"
 #include "ppg_settings.h"
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 void ppg_global_init_input(PPG_Input_Id *input)
 {
    *input = (PPG_Input_Id)((uintptr_t)-1);
 }
+
+typedef struct {
+   PPG_Input_Masks *input_masks;
+   PPG_Count n_bits;
+   bool all_relevant;
+} PPG_Input_Collection;
+
+void ppg_input_masks_init(PPG_Input_Masks *input_masks)
+{
+   input_masks->masks = NULL;
+   input_masks->n_bits = 0;
+   input_masks->n_cells = 0;
+   input_masks->n_tokens = 0;
+}
+
+static void ppg_input_count_relevant(PPG_Token__ *token,
+                                     PPG_Input_Collection *collection)
+{
+   // The root does not consume inputs
+   //
+   if(!token->parent) { return; }
+   
+   if(!token->vtable->inputs) {
+      collection->all_relevant = true;
+      return;
+   }
+   
+   PPG_Count n_inputs = 0;
+   PPG_Input_Id *inputs = token->vtable->inputs(token, &n_inputs);
+   
+   for(PPG_Count i = 0; i < n_inputs; ++i) {
+      
+      // The masks can store at most PPG_MAX_INPUTS bits
+      //
+      if(inputs[i] >= PPG_MAX_INPUTS) {
+         collection->all_relevant = true;
+      }
+      else if(inputs[i] >= collection->n_bits) {
+         collection->n_bits = inputs[i] + 1;
+      }
+   }
+}
+
+static PPG_Bitfield ppg_input_mask_of(PPG_Input_Masks *input_masks,
+                                      PPG_Token_Id id)
+{
+   return (PPG_Bitfield) {
+      .bitarray = input_masks->masks + id*input_masks->n_cells,
+      .n_bits = (uint8_t)input_masks->n_bits
+   };
+}
+
+// Called after the token's children were visited. Thus, the 
+// masks of the children are complete and are merged into 
+// the mask of the parent.
+//
+static void ppg_input_mark_subtree(PPG_Token__ *token,
+                                   PPG_Input_Collection *collection)
+{
+   if(!token->parent) { return; }
+   
+   PPG_Input_Masks *input_masks = collection->input_masks;
+   
+   PPG_Bitfield mask = ppg_input_mask_of(input_masks, token->id);
+   
+   PPG_Count n_inputs = 0;
+   PPG_Input_Id *inputs = token->vtable->inputs(token, &n_inputs);
+   
+   for(PPG_Count i = 0; i < n_inputs; ++i) {
+      ppg_bitfield_set_bit(&mask, inputs[i], true);
+   }
+   
+   PPG_Bitfield parent_mask = ppg_input_mask_of(input_masks, token->parent->id);
+   
+   for(PPG_Count cell = 0; cell < input_masks->n_cells; ++cell) {
+      parent_mask.bitarray[cell] |= mask.bitarray[cell];
+   }
+}
+
+void ppg_input_collect_masks(PPG_Input_Masks *input_masks, 
+                             PPG_Token__ *root,
+                             PPG_Token_Id n_tokens,
+                             PPG_Allocator *allocator)
+{
+   ppg_input_free_masks(input_masks, allocator);
+   
+   PPG_Input_Collection collection = {
+      .input_masks = input_masks,
+      .n_bits = 0,
+      .all_relevant = false
+   };
+   
+   ppg_token_traverse_tree(root,
+                           (PPG_Token_Tree_Visitor)ppg_input_count_relevant,
+                           NULL,
+                           (void*)&collection);
+   
+   if(   collection.all_relevant 
+      || (collection.n_bits == 0)
+      || (n_tokens == 0)) { 
+      return; 
+   }
+   
+   input_masks->n_bits = collection.n_bits;
+   input_masks->n_cells 
+      = ppg_bitfield_get_num_cells_from_bits((uint8_t)collection.n_bits);
+   input_masks->n_tokens = n_tokens;
+   
+   size_t n_bytes = (size_t)n_tokens*input_masks->n_cells
+                        *sizeof(PPG_Bitfield_Storage_Type);
+   
+   input_masks->masks 
+      = (PPG_Bitfield_Storage_Type *)ppg_allocator_malloc(allocator, n_bytes);
+   
+   memset(input_masks->masks, 0, n_bytes);
+   
+   ppg_token_traverse_tree(root,
+                           NULL,
+                           (PPG_Token_Tree_Visitor)ppg_input_mark_subtree,
+                           (void*)&collection);
+}
+
+void ppg_input_free_masks(PPG_Input_Masks *input_masks,
+                          PPG_Allocator *allocator)
+{
+   ppg_allocator_free(allocator, input_masks->masks);
+   
+   ppg_input_masks_init(input_masks);
+}
+
+bool ppg_input_used_by_subtree(PPG_Input_Masks *input_masks, 
+                               PPG_Token__ *token,
+                               PPG_Input_Id input)
+{
+   // Without information about the inputs used, 
+   // we must assume that every input is relevant
+   //
+   if(   !input_masks->masks 
+      || (token->id >= input_masks->n_tokens)) { 
+      return true; 
+   }
+   
+   if(input >= input_masks->n_bits) { return false; }
+   
+   PPG_Bitfield mask = ppg_input_mask_of(input_masks, token->id);
+   
+   return ppg_bitfield_get_bit(&mask, input);
+}
+
+bool ppg_input_is_relevant(PPG_Input_Masks *input_masks, 
+                           PPG_Input_Id input)
+{
+   // The mask of the root node comprises the inputs of all patterns
+   //
+   if(!input_masks->masks) { return true; }
+   
+   if(input >= input_masks->n_bits) { return false; }
+   
+   PPG_Bitfield mask = ppg_input_mask_of(input_masks, 0);
+   
+   return ppg_bitfield_get_bit(&mask, input);
+}
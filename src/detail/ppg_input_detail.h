@@ -17,7 +17,10 @@
 #ifndef PPG_INPUT_DETAIL_H
 #define PPG_INPUT_DETAIL_H
 
+#include "ppg_allocator.h"
 #include "ppg_input.h"
+#include "ppg_bitfield.h"
+#include "detail/ppg_token_detail.h"
 
 /** @brief Initializes an input
  * 
@@ -25,4 +28,65 @@
  */
 void ppg_global_init_input(PPG_Input_Id *input);
 
+// The inputs that are used by the subtrees of the tokens of a pattern tree. 
+// Every token owns a row of bits that is indexed by its token id. 
+// The row of the root node comprises all inputs used by any pattern.
+//
+typedef struct {
+   PPG_Bitfield_Storage_Type *masks; ///< The rows of all tokens
+   PPG_Count n_bits; ///< The number of bits of every row
+   PPG_Count n_cells; ///< The number of cells of every row
+   PPG_Token_Id n_tokens; ///< The number of rows
+} PPG_Input_Masks;
+
+/** @brief Initializes an empty set of input masks
+ * 
+ * @param input_masks The input masks
+ */
+void ppg_input_masks_init(PPG_Input_Masks *input_masks);
+
+/** @brief Collects the inputs that are used by the subtree of every 
+ *         token of a pattern tree
+ * 
+ * The token ids must have been assigned before. 
+ * If any token does not report its inputs, the masks are left empty
+ * which means that all inputs are considered as relevant for all subtrees.
+ * 
+ * @param input_masks The input masks
+ * @param root The root of the pattern tree
+ * @param n_tokens The number of tokens of the pattern tree
+ * @param allocator The allocator that provides the masks' storage
+ */
+void ppg_input_collect_masks(PPG_Input_Masks *input_masks, 
+                             PPG_Token__ *root,
+                             PPG_Token_Id n_tokens,
+                             PPG_Allocator *allocator);
+
+/** @brief Frees input masks that were set up by ppg_input_collect_masks
+ * 
+ * @param input_masks The input masks
+ * @param allocator The allocator that was passed to ppg_input_collect_masks
+ */
+void ppg_input_free_masks(PPG_Input_Masks *input_masks,
+                          PPG_Allocator *allocator);
+
+/** @brief Checks if an input is used by any token of the subtree 
+ *         that is rooted at a given token
+ * 
+ * @param input_masks The input masks that were set up by ppg_input_collect_masks
+ * @param token The root of the subtree
+ * @param input The input to check
+ */
+bool ppg_input_used_by_subtree(PPG_Input_Masks *input_masks, 
+                               PPG_Token__ *token,
+                               PPG_Input_Id input);
+
+/** @brief Checks if an input is used by any pattern
+ * 
+ * @param input_masks The input masks that were set up by ppg_input_collect_masks
+ * @param input The input to check
+ */
+bool ppg_input_is_relevant(PPG_Input_Masks *input_masks, 
+                           PPG_Input_Id input);
+
 #endif
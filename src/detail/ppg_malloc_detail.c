@@ -61,3 +61,54 @@ void *ppg_safe_malloc(size_t n_bytes)
 }
 
 #endif
+
+void *ppg_allocator_malloc(PPG_Allocator *allocator, size_t n_bytes)
+{
+   if(!allocator->alloc) {
+      return PPG_MALLOC(n_bytes);
+   }
+   
+   void *p = allocator->alloc(n_bytes, allocator->user_data);
+   
+   if(!p) {
+      PPG_ERROR("Allocator exhausted (%lu bytes)\n",
+                (unsigned long)n_bytes);
+      abort();
+   }
+   
+   return p;
+}
+
+void *ppg_allocator_realloc(PPG_Allocator *allocator, 
+                            void *memory, 
+                            size_t n_bytes)
+{
+   void *p = NULL;
+   
+   if(!allocator->alloc) {
+      p = realloc(memory, n_bytes);
+   }
+   else {
+      p = allocator->realloc(memory, n_bytes, allocator->user_data);
+   }
+   
+   if(!p) {
+      PPG_ERROR("Out of memory while resizing (%lu bytes)\n",
+                (unsigned long)n_bytes);
+      abort();
+   }
+   
+   return p;
+}
+
+void ppg_allocator_free(PPG_Allocator *allocator, void *memory)
+{
+   if(!memory) { return; }
+   
+   if(!allocator->alloc) {
+      free(memory);
+      return;
+   }
+   
+   allocator->free(memory, allocator->user_data);
+}
@@ -18,6 +18,10 @@
 #define PPG_MALLOC_DETAIL_H
 
 #include "ppg_debug.h"
+#include "ppg_allocator.h"
+
+#include <stddef.h>
+#include <stdbool.h>
 
 #if PPG_HAVE_ASSERTIONS
 
@@ -37,4 +41,47 @@ void *ppg_safe_malloc(size_t n_bytes);
    
 #endif
 
+// Memory that is handed out by the allocators of the library
+// is aligned suitably for any of the following types
+//
+typedef union {
+   void *pointer;
+   long long integer;
+   double floating_point;
+   void (*function)(void);
+} PPG_Max_Align;
+
+enum { PPG_Max_Align_Bytes = sizeof(PPG_Max_Align) };
+
+inline
+static size_t ppg_align_size(size_t n_bytes)
+{
+   return   (n_bytes + PPG_Max_Align_Bytes - 1) 
+          / PPG_Max_Align_Bytes * PPG_Max_Align_Bytes;
+}
+
+// The following functions operate on an allocator. An allocator 
+// whose alloc function is NULL uses the heap. 
+// Running out of memory is fatal.
+//
+void *ppg_allocator_malloc(PPG_Allocator *allocator, size_t n_bytes);
+
+void *ppg_allocator_realloc(PPG_Allocator *allocator, 
+                            void *memory, 
+                            size_t n_bytes);
+
+void ppg_allocator_free(PPG_Allocator *allocator, void *memory);
+
+// Checks if an allocator was created by ppg_fixed_buffer_allocator. 
+// Its user data is the buffer then.
+//
+bool ppg_allocator_is_fixed_buffer(PPG_Allocator *allocator);
+
+// Creates an allocator that obtains memory from the heap but accounts
+// for it exactly like an allocator created by ppg_fixed_buffer_allocator. 
+// The number of bytes a fixed buffer would use, including its 
+// bookkeeping, is maintained in *n_used.
+//
+PPG_Allocator ppg_measuring_allocator(size_t *n_used);
+
 #endif
@@ -24,7 +24,7 @@
 
 #include <stdlib.h>
 
-static bool ppg_note_match_event(   
+bool ppg_note_match_event(   
                                  PPG_Note *note,
                                  PPG_Event *event,
                                  bool modify_only_if_consuming
@@ -33,7 +33,7 @@ static bool ppg_note_match_event(
 //    PPG_LOG("Note 0x%" PRIXPTR ", input 0x%d, ppg_note_match_event\n", (uintptr_t)note, note->input);
    
    PPG_Count note_flags 
-      = note->super.misc.flags;
+      = PPG_TOKEN_MISC(note).flags;
    
    // Assert that the note requires either activation or deactivation
    //
@@ -51,7 +51,7 @@ static bool ppg_note_match_event(
                   
 //                   PPG_LOG("modify_only_if_consuming = %d\n",  modify_only_if_consuming);
                   if(!modify_only_if_consuming) {
-                     note->super.misc.state = PPG_Token_Invalid;
+                     PPG_TOKEN_MISC(note).state = PPG_Token_Invalid;
                   }
                }
 
@@ -64,17 +64,17 @@ static bool ppg_note_match_event(
                
                // Mark the note as active
                //
-               note->super.misc.flags |= PPG_Note_Type_Active;
+               PPG_TOKEN_MISC(note).flags |= PPG_Note_Type_Active;
                
                if(note_flags & PPG_Token_Flags_Pedantic) {
                
                   PPG_LOG("Note 0x%" PRIXPTR " activation inprogress\n", (uintptr_t)note);
-                  note->super.misc.state = PPG_Token_Activation_In_Progress;
+                  PPG_TOKEN_MISC(note).state = PPG_Token_Activation_In_Progress;
                }
                else {
                
                   PPG_LOG("Note 0x%" PRIXPTR " match\n", (uintptr_t)note);
-                  note->super.misc.state = PPG_Token_Matches;
+                  PPG_TOKEN_MISC(note).state = PPG_Token_Matches;
                }
             }
             else {
@@ -85,11 +85,11 @@ static bool ppg_note_match_event(
                
                   if(note_flags & PPG_Token_Flags_Pedantic) {
                      PPG_LOG("Note 0x%" PRIXPTR " pedantic match\n", (uintptr_t)note);
-                     note->super.misc.state = PPG_Token_Matches;
+                     PPG_TOKEN_MISC(note).state = PPG_Token_Matches;
                   }
                   else {
                      PPG_LOG("Note 0x%" PRIXPTR " finalized\n", (uintptr_t)note);
-                     note->super.misc.state = PPG_Token_Finalized;
+                     PPG_TOKEN_MISC(note).state = PPG_Token_Finalized;
                   }
                }
                else {
@@ -112,14 +112,14 @@ static bool ppg_note_match_event(
          if(   (note->input == event->input)
             && (event->flags & PPG_Event_Active)) {
             PPG_LOG("I mtch\n");
-            note->super.misc.state = PPG_Token_Matches;
-            note->super.misc.flags |= PPG_Token_Flags_Done;
+            PPG_TOKEN_MISC(note).state = PPG_Token_Matches;
+            PPG_TOKEN_MISC(note).flags |= PPG_Token_Flags_Done;
             return true;
          }
          
          PPG_LOG("I inact\n");
          if(!modify_only_if_consuming) {
-            note->super.misc.state = PPG_Token_Invalid;
+            PPG_TOKEN_MISC(note).state = PPG_Token_Invalid;
          }
          
          return false;
@@ -128,14 +128,14 @@ static bool ppg_note_match_event(
       
          if(   (note->input == event->input)
             && ((event->flags & PPG_Event_Active) == 0)) {
-            note->super.misc.state = PPG_Token_Finalized;
+            PPG_TOKEN_MISC(note).state = PPG_Token_Finalized;
             
-            note->super.misc.flags |= PPG_Token_Flags_Done;
+            PPG_TOKEN_MISC(note).flags |= PPG_Token_Flags_Done;
             return true;
          }
          
          if(!modify_only_if_consuming) {
-            note->super.misc.state = PPG_Token_Invalid;
+            PPG_TOKEN_MISC(note).state = PPG_Token_Invalid;
          }
          
          return false;
@@ -144,20 +144,20 @@ static bool ppg_note_match_event(
    return true;
 }
 
-static void ppg_note_reset(PPG_Note *note) 
+void ppg_note_reset(PPG_Note *note) 
 {
    ppg_token_reset_control_state((PPG_Token__*)note);
    
    // Notes that only match deactivation start in matching state
    //
-   if((note->super.misc.flags 
+   if((PPG_TOKEN_MISC(note).flags 
                      & PPG_Note_Flag_Match_Activation) == 0) {
-      note->super.misc.state = PPG_Token_Matches;
+      PPG_TOKEN_MISC(note).state = PPG_Token_Matches;
    }
    
    // Clear the activation state
    //
-   note->super.misc.flags 
+   PPG_TOKEN_MISC(note).flags 
          &= (PPG_Count)~PPG_Note_Type_Active;
 }
 
@@ -166,7 +166,7 @@ static bool ppg_note_equals(PPG_Note *n1, PPG_Note *n2)
    return n1->input == n2->input;
 }
 
-static PPG_Count ppg_note_token_precedence(PPG_Token__ *token)
+PPG_Count ppg_note_token_precedence(PPG_Token__ *token)
 {
    PPG_Note *note = (PPG_Note *)token;
    
@@ -180,6 +180,23 @@ static PPG_Count ppg_note_token_precedence(PPG_Token__ *token)
    return PPG_Token_Precedence_Explicit_Note;
 }
 
+static PPG_Input_Id *ppg_note_entry_inputs(PPG_Note *note, PPG_Count *n_inputs)
+{
+   // Notes that only match deactivation can never consume
+   // an activation event
+   //
+   *n_inputs = (note->super.misc.flags & PPG_Note_Flag_Match_Activation) ? 1 : 0;
+   
+   return &note->input;
+}
+
+static PPG_Input_Id *ppg_note_inputs(PPG_Note *note, PPG_Count *n_inputs)
+{
+   *n_inputs = 1;
+   
+   return &note->input;
+}
+
 static size_t ppg_note_dynamic_size(PPG_Token__ *token)
 {
    return   sizeof(PPG_Note)
@@ -207,9 +224,9 @@ static void ppg_note_print_self(PPG_Note *p, PPG_Count indent, bool recurse)
    PPG_I PPG_LOG("<*** nt (0x%" PRIXPTR ") ***>\n", (uintptr_t)p);
    ppg_token_print_self_start((PPG_Token__*)p, indent);
    PPG_I PPG_LOG("\tI: 0x%" PRIXPTR "\n", (uintptr_t)p->input);
-   PPG_I PPG_LOG("\tA: %d\n", (p->super.misc.flags & PPG_Note_Type_Active));
-   PPG_I PPG_LOG("\tm a: %d\n", (bool)(p->super.misc.flags & PPG_Note_Flag_Match_Activation));
-   PPG_I PPG_LOG("\tm d: %d\n", (bool)(p->super.misc.flags & PPG_Note_Flag_Match_Deactivation));
+   PPG_I PPG_LOG("\tA: %d\n", (PPG_TOKEN_MISC(p).flags & PPG_Note_Type_Active));
+   PPG_I PPG_LOG("\tm a: %d\n", (bool)(PPG_TOKEN_MISC(p).flags & PPG_Note_Flag_Match_Activation));
+   PPG_I PPG_LOG("\tm d: %d\n", (bool)(PPG_TOKEN_MISC(p).flags & PPG_Note_Flag_Match_Deactivation));
    ppg_token_print_self_end((PPG_Token__*)p, indent, recurse);
 }
 #endif
@@ -224,18 +241,18 @@ static bool ppg_note_check_initialized(PPG_Token__ *token)
    // Skip the parent call as we need a specialized check
 //    assertion_failed |= ppg_token_check_initialized(token);
    
-   if((note->super.misc.flags 
+   if((PPG_TOKEN_MISC(note).flags 
                      & PPG_Note_Flag_Match_Activation) == 0) {
-      PPG_ASSERT_WARN(note->super.misc.state == PPG_Token_Matches);
+      PPG_ASSERT_WARN(PPG_TOKEN_MISC(note).state == PPG_Token_Matches);
    }
    else {
-      PPG_ASSERT_WARN(note->super.misc.state == PPG_Token_Initialized);
+      PPG_ASSERT_WARN(PPG_TOKEN_MISC(note).state == PPG_Token_Initialized);
    }
    
-   PPG_ASSERT_WARN(token->misc.action_state == PPG_Action_Disabled);
+   PPG_ASSERT_WARN(PPG_TOKEN_MISC(token).action_state == PPG_Action_Disabled);
    
    PPG_ASSERT_WARN(
-      (note->super.misc.flags 
+      (PPG_TOKEN_MISC(note).flags 
          & PPG_Note_Type_Active) == 0);
    
    return assertion_failed;
@@ -254,6 +271,10 @@ PPG_Token_Vtable ppg_note_vtable =
       = (PPG_Token_Equals_Fun) ppg_note_equals,
    .token_precedence
       = (PPG_Token_Precedence_Fun)ppg_note_token_precedence,
+   .entry_inputs
+      = (PPG_Token_Entry_Inputs_Fun)ppg_note_entry_inputs,
+   .inputs
+      = (PPG_Token_Inputs_Fun)ppg_note_inputs,
    .dynamic_size 
       = (PPG_Token_Dynamic_Size_Requirement_Fun)ppg_note_dynamic_size,
    .placement_clone
@@ -293,5 +314,5 @@ PPG_Note *ppg_note_new(PPG_Note *note)
 }
 
 PPG_Note *ppg_note_alloc(void) {
-    return (PPG_Note*)PPG_MALLOC(sizeof(PPG_Note));
+    return (PPG_Note*)ppg_tree_malloc(sizeof(PPG_Note));
 }
@@ -38,4 +38,15 @@ PPG_Note *ppg_note_alloc(void);
 
 extern PPG_Token_Vtable ppg_note_vtable;
 
+// The following methods are exported to allow for calling them
+// directly, see detail/ppg_token_dispatch_detail.h
+//
+bool ppg_note_match_event(PPG_Note *note,
+                          PPG_Event *event,
+                          bool modify_only_if_consuming);
+                          
+void ppg_note_reset(PPG_Note *note);
+
+PPG_Count ppg_note_token_precedence(PPG_Token__ *token);
+
 #endif
@@ -0,0 +1,682 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "detail/ppg_parallel_matching_detail.h"
+#include "detail/ppg_pattern_matching_detail.h"
+#include "detail/ppg_token_dispatch_detail.h"
+#include "detail/ppg_context_detail.h"
+#include "detail/ppg_global_detail.h"
+#include "detail/ppg_malloc_detail.h"
+#include "ppg_global.h"
+#include "ppg_debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PPG_PM ppg_context->parallel_matcher
+
+enum {
+   PPG_Thread_Alive = 0,
+   PPG_Thread_Expanded,
+   PPG_Thread_Completed,
+   PPG_Thread_Dead,
+   PPG_Thread_Terminated
+};
+
+enum {
+   PPG_Parallel_Record_State = (1 << PPG_Token_N_State_Bits) - 1,
+   PPG_Parallel_Record_Changed = 1 << PPG_Token_N_State_Bits,
+   PPG_Parallel_Record_Consumed = PPG_Parallel_Record_Changed << 1
+};
+
+void ppg_parallel_matcher_init(PPG_Parallel_Matcher *matcher)
+{
+   matcher->threads = NULL;
+   matcher->records = NULL;
+   matcher->n_allocated_threads = 0;
+   matcher->n_records_per_thread = 0;
+   
+   ppg_parallel_matcher_reset(matcher);
+}
+
+void ppg_parallel_matcher_free(PPG_Parallel_Matcher *matcher,
+                               PPG_Allocator *allocator)
+{
+   ppg_allocator_free(allocator, matcher->threads);
+   ppg_allocator_free(allocator, matcher->records);
+   
+   ppg_parallel_matcher_init(matcher);
+}
+
+void ppg_parallel_matcher_reserve(PPG_Parallel_Matcher *matcher,
+                                  size_t n_threads,
+                                  size_t n_events,
+                                  PPG_Allocator *allocator)
+{
+   size_t n_old_threads = matcher->n_allocated_threads;
+   size_t n_old_events = matcher->n_records_per_thread;
+   
+   if(n_threads < n_old_threads) { n_threads = n_old_threads; }
+   if(n_events < n_old_events) { n_events = n_old_events; }
+   
+   if(n_threads > n_old_threads) {
+      matcher->threads 
+         = (PPG_Parallel_Thread *)ppg_allocator_realloc(allocator,
+                                    matcher->threads,
+                                    n_threads*sizeof(PPG_Parallel_Thread));
+      matcher->n_allocated_threads = n_threads;
+   }
+   
+   if(n_threads*n_events > n_old_threads*n_old_events) {
+      matcher->records 
+         = (PPG_Parallel_Record *)ppg_allocator_realloc(allocator,
+                                    matcher->records,
+                                    n_threads*n_events*sizeof(PPG_Parallel_Record));
+      
+      // Move the records of existing threads to their new locations.
+      // Going backwards, no records are overwritten before they are moved.
+      //
+      for(size_t i = matcher->n_threads; i-- > 1;) {
+         memmove(&matcher->records[i*n_events],
+                 &matcher->records[i*n_old_events],
+                 matcher->threads[i].n_records*sizeof(PPG_Parallel_Record));
+      }
+      
+      matcher->n_records_per_thread = n_events;
+   }
+}
+
+void ppg_parallel_matcher_reset(PPG_Parallel_Matcher *matcher)
+{
+   matcher->n_threads = 0;
+   matcher->alive = PPG_PARALLEL_NONE;
+   matcher->current = PPG_PARALLEL_NONE;
+}
+
+static size_t ppg_parallel_thread_new(PPG_Token__ *token,
+                                      size_t parent,
+                                      PPG_Event_Buffer_Index_Type event_id)
+{
+   // Every token is visited at most once while matching a pattern.
+   // Thus, the threads that were reserved for the tokens of the compiled
+   // pattern tree suffice.
+   //
+   if(PPG_PM.n_threads == PPG_PM.n_allocated_threads) {
+      PPG_ERROR("Parallel matching requires the pattern tree "
+                "to be compiled\n");
+      abort();
+   }
+   
+   size_t thread_id = PPG_PM.n_threads;
+   
+   ++PPG_PM.n_threads;
+   
+   PPG_PM.threads[thread_id] = (PPG_Parallel_Thread) {
+      .token = token,
+      .parent = parent,
+      .first_child = PPG_PARALLEL_NONE,
+      .n_children = 0,
+      .next_alive = PPG_PARALLEL_NONE,
+      .first_event = event_id,
+      .end_event = event_id,
+      .n_records = 0,
+      .state = PPG_Thread_Alive
+   };
+   
+   #if PPG_HAVE_STATISTICS
+   ++ppg_context->statistics.n_nodes_visited;
+   #endif
+   
+   return thread_id;
+}
+
+static void ppg_parallel_thread_record(size_t thread_id,
+                                       bool consumed,
+                                       PPG_Count state,
+                                       bool changed)
+{
+   PPG_Parallel_Thread *thread = &PPG_PM.threads[thread_id];
+   
+   PPG_Parallel_Record record = (PPG_Parallel_Record)state;
+   
+   if(changed) { record |= PPG_Parallel_Record_Changed; }
+   if(consumed) { record |= PPG_Parallel_Record_Consumed; }
+   
+   PPG_PM.records[thread_id*PPG_PM.n_records_per_thread + thread->n_records]
+      = record;
+   
+   ++thread->n_records;
+}
+
+static void ppg_parallel_thread_feed(size_t thread_id,
+                                     PPG_Event_Buffer_Index_Type event_id)
+{
+   PPG_Token__ *token = PPG_PM.threads[thread_id].token;
+   
+   PPG_Count state_before = PPG_TOKEN_MISC(token).state;
+   
+   bool event_consumed = ppg_branch_match_event(token, &PPG_EB_EVENT(event_id));
+   
+   ppg_parallel_thread_record(thread_id,
+                              event_consumed,
+                              PPG_TOKEN_MISC(token).state,
+                              state_before != PPG_TOKEN_MISC(token).state);
+   
+   PPG_Parallel_Thread *thread = &PPG_PM.threads[thread_id];
+   
+   switch(PPG_TOKEN_MISC(token).state) {
+      
+      case PPG_Token_Matches:
+      case PPG_Token_Finalized:
+         if(ppg_token_completes_pattern(token)) {
+            thread->state = PPG_Thread_Completed;
+            thread->end_event = event_id;
+         }
+         break;
+      case PPG_Token_Invalid:
+         thread->state = PPG_Thread_Dead;
+         thread->end_event = event_id;
+         break;
+   }
+}
+
+static void ppg_parallel_thread_expand(size_t thread_id,
+                                       PPG_Event_Buffer_Index_Type event_id)
+{
+   PPG_Token__ *token = PPG_PM.threads[thread_id].token;
+   
+   size_t first_child = PPG_PM.n_threads;
+   
+   if(token->n_children == 1) {
+      
+      if(!ppg_branch_is_candidate(token->children[0])) {
+         PPG_PM.threads[thread_id].state = PPG_Thread_Dead;
+         PPG_PM.threads[thread_id].end_event = event_id;
+         return;
+      }
+      
+      size_t child_id 
+         = ppg_parallel_thread_new(token->children[0], thread_id, event_id);
+      PPG_PM.threads[child_id].state = PPG_TOKEN_MISC(token->children[0]).state;
+   }
+   else {
+      
+      // Determine the branches in the order the tree engine would
+      // try them. Branches are temporarily marked invalid to exclude them
+      // from the search for the next one. The original token states
+      // are meanwhile kept in the thread states.
+      //
+      PPG_Count n_branch_candidates = 0;
+      
+      PPG_Token__ *branch 
+         = ppg_token_get_most_appropriate_branch(token, &n_branch_candidates);
+         
+      while(branch) {
+         
+         size_t child_id = ppg_parallel_thread_new(branch, thread_id, event_id);
+         PPG_PM.threads[child_id].state = PPG_TOKEN_MISC(branch).state;
+         
+         if(n_branch_candidates <= 1) { break; }
+         
+         PPG_TOKEN_MISC(branch).state = PPG_Token_Invalid;
+         
+         branch = ppg_token_get_most_appropriate_branch(token, 
+                                                        &n_branch_candidates);
+      }
+   }
+   
+   size_t n_children = PPG_PM.n_threads - first_child;
+   
+   if(n_children == 0) {
+      
+      // No branch can be followed. This renders the
+      // overall pattern invalid.
+      //
+      PPG_PM.threads[thread_id].state = PPG_Thread_Terminated;
+      PPG_PM.threads[thread_id].end_event = event_id;
+      return;
+   }
+   
+   for(size_t i = 0; i < n_children; ++i) {
+      
+      size_t child_id = first_child + i;
+      PPG_Parallel_Thread *child = &PPG_PM.threads[child_id];
+      
+      PPG_TOKEN_MISC(child->token).state = child->state;
+      
+      ppg_branch_prepare(child->token);
+      child->state = PPG_Thread_Alive;
+   }
+   
+   PPG_Parallel_Thread *thread = &PPG_PM.threads[thread_id];
+   
+   thread->first_child = first_child;
+   thread->n_children = n_children;
+   thread->state = PPG_Thread_Expanded;
+}
+
+static void ppg_parallel_thread_process_event(
+                                 size_t thread_id,
+                                 PPG_Event_Buffer_Index_Type event_id)
+{
+   PPG_Token__ *token = PPG_PM.threads[thread_id].token;
+   
+   PPG_Count state = PPG_TOKEN_MISC(token).state;
+   
+   // Pretend a match for the root token
+   //
+   if(!token->parent) {
+      state = PPG_Token_Matches;
+   }
+   
+   switch(state) {
+      
+      case PPG_Token_Initialized:
+      case PPG_Token_Activation_In_Progress:
+         
+         ppg_parallel_thread_feed(thread_id, event_id);
+         
+         break;
+         
+      case PPG_Token_Matches:
+      case PPG_Token_Finalized:
+         
+         // The token matched while the previous event was processed. 
+         // Its children continue with the current event.
+         //
+         ppg_parallel_thread_expand(thread_id, event_id);
+         
+         if(PPG_PM.threads[thread_id].state != PPG_Thread_Expanded) { break; }
+         
+         for(size_t i = 0; i < PPG_PM.threads[thread_id].n_children; ++i) {
+            
+            size_t child_id = PPG_PM.threads[thread_id].first_child + i;
+            
+            if(PPG_PM.threads[child_id].state == PPG_Thread_Alive) {
+               ppg_parallel_thread_feed(child_id, event_id);
+            }
+         }
+         
+         break;
+         
+      default:
+         
+         PPG_PM.threads[thread_id].state = PPG_Thread_Terminated;
+         PPG_PM.threads[thread_id].end_event = event_id;
+         
+         break;
+   }
+}
+
+static void ppg_parallel_alive_append(size_t *first, 
+                                      size_t *last,
+                                      size_t thread_id)
+{
+   PPG_PM.threads[thread_id].next_alive = PPG_PARALLEL_NONE;
+   
+   if(*last == PPG_PARALLEL_NONE) {
+      *first = thread_id;
+   }
+   else {
+      PPG_PM.threads[*last].next_alive = thread_id;
+   }
+   
+   *last = thread_id;
+}
+
+// Passes an event to all threads of a list of live threads.
+// Returns the list of threads that are still alive afterwards.
+//
+static size_t ppg_parallel_process_event(size_t alive,
+                                         PPG_Event_Buffer_Index_Type event_id)
+{
+   size_t first = PPG_PARALLEL_NONE;
+   size_t last = PPG_PARALLEL_NONE;
+   
+   size_t thread_id = alive;
+   
+   while(thread_id != PPG_PARALLEL_NONE) {
+      
+      size_t next_alive = PPG_PM.threads[thread_id].next_alive;
+      
+      if(PPG_PM.threads[thread_id].state == PPG_Thread_Alive) {
+         
+         ppg_parallel_thread_process_event(thread_id, event_id);
+         
+         PPG_Parallel_Thread *thread = &PPG_PM.threads[thread_id];
+         
+         if(thread->state == PPG_Thread_Alive) {
+            ppg_parallel_alive_append(&first, &last, thread_id);
+         }
+         else if(thread->state == PPG_Thread_Expanded) {
+            
+            for(size_t i = 0; i < thread->n_children; ++i) {
+               
+               size_t child_id = thread->first_child + i;
+               
+               if(PPG_PM.threads[child_id].state == PPG_Thread_Alive) {
+                  ppg_parallel_alive_append(&first, &last, child_id);
+               }
+            }
+         }
+      }
+      
+      thread_id = next_alive;
+   }
+   
+   return first;
+}
+
+// Determines the thread that the tree engine would process 
+// after the given thread failed. This also applies the 
+// modifications of token states that happen when the tree
+// engine reverts to a previous furcation.
+//
+static size_t ppg_parallel_thread_revert(size_t thread_id)
+{
+   size_t branch = thread_id;
+   size_t parent = PPG_PM.threads[thread_id].parent;
+   
+   while(parent != PPG_PARALLEL_NONE) {
+      
+      PPG_Parallel_Thread *furcation = &PPG_PM.threads[parent];
+      
+      if(furcation->token->n_children > 1) {
+         
+         if(branch < furcation->first_child + furcation->n_children - 1) {
+            
+            PPG_TOKEN_MISC(PPG_PM.threads[branch].token).state = PPG_Token_Invalid;
+            
+            return branch + 1;
+         }
+         
+         ppg_context_reset_children_control_state(furcation->token);
+      }
+      
+      branch = parent;
+      parent = furcation->parent;
+   }
+   
+   return PPG_PARALLEL_NONE;
+}
+
+// Returns the thread that the tree engine processes after
+// the given one if the given thread fails
+//
+static size_t ppg_parallel_thread_successor(size_t thread_id)
+{
+   if(PPG_PM.threads[thread_id].state == PPG_Thread_Expanded) {
+      return PPG_PM.threads[thread_id].first_child;
+   }
+   
+   size_t parent = PPG_PM.threads[thread_id].parent;
+   
+   while(parent != PPG_PARALLEL_NONE) {
+      
+      if(thread_id <   PPG_PM.threads[parent].first_child 
+                     + PPG_PM.threads[parent].n_children - 1) {
+         return thread_id + 1;
+      }
+      
+      thread_id = parent;
+      parent = PPG_PM.threads[parent].parent;
+   }
+   
+   return PPG_PARALLEL_NONE;
+}
+
+// Writes the records of all threads up to the given one 
+// to the event buffer in the order the tree engine would
+// have processed them.
+//
+static void ppg_parallel_matching_apply_records(size_t last_thread)
+{
+   size_t thread_id = 0;
+   
+   while(thread_id != PPG_PARALLEL_NONE) {
+      
+      PPG_Parallel_Thread *thread = &PPG_PM.threads[thread_id];
+      
+      PPG_Parallel_Record *records 
+         = &PPG_PM.records[thread_id*PPG_PM.n_records_per_thread];
+      
+      for(PPG_Event_Buffer_Index_Type i = 0; i < thread->n_records; ++i) {
+         
+         PPG_Event_Queue_Entry *eqe 
+            = &PPG_EB_ENTRY(thread->first_event + i);
+         
+         eqe->consumer = (records[i] & PPG_Parallel_Record_Consumed) ?
+                              thread->token : NULL;
+         eqe->token_state.state = records[i] & PPG_Parallel_Record_State;
+         eqe->token_state.changed 
+            = (records[i] & PPG_Parallel_Record_Changed) != 0;
+      }
+      
+      if(thread_id == last_thread) { break; }
+      
+      thread_id = ppg_parallel_thread_successor(thread_id);
+   }
+}
+
+static PPG_Count ppg_parallel_matching_finish(size_t thread_id,
+                                              PPG_Count result)
+{
+   ppg_parallel_matching_apply_records(thread_id);
+   
+   ppg_context->current_token = PPG_PM.threads[thread_id].token;
+   
+   PPG_EB.cur = PPG_PM.threads[thread_id].end_event;
+   
+   return result;
+}
+
+// Follows the threads in the order the tree engine would process them
+// until a thread is found that is still alive or that decides about
+// the outcome of pattern matching.
+//
+static PPG_Count ppg_parallel_matching_resolve(void)
+{
+   while(1) {
+      
+      size_t thread_id = PPG_PM.current;
+      
+      switch(PPG_PM.threads[thread_id].state) {
+         
+         case PPG_Thread_Alive:
+            
+            ppg_context->current_token = PPG_PM.threads[thread_id].token;
+            
+            return PPG_Pattern_In_Progress;
+            
+         case PPG_Thread_Expanded:
+            
+            PPG_PM.current = PPG_PM.threads[thread_id].first_child;
+            
+            break;
+            
+         case PPG_Thread_Completed:
+            
+            PPG_LOG_TOKEN_LOOKUP("p match\n");
+            
+            return ppg_parallel_matching_finish(thread_id, 
+                                                PPG_Pattern_Matches);
+            
+         case PPG_Thread_Terminated:
+            
+            return ppg_parallel_matching_finish(thread_id, 
+                                                PPG_Pattern_Invalid);
+            
+         case PPG_Thread_Dead:
+         {
+            size_t next = ppg_parallel_thread_revert(thread_id);
+            
+            if(next == PPG_PARALLEL_NONE) {
+               
+               // All branches failed
+               //
+               return ppg_parallel_matching_finish(thread_id, 
+                                                   PPG_Pattern_Invalid);
+            }
+            
+            PPG_PM.current = next;
+         }
+            break;
+      }
+   }
+   
+   return PPG_Pattern_State_Undefined;
+}
+
+PPG_Count ppg_parallel_matching_process_next_event(void)
+{
+   PPG_LOG_TOKEN_LOOKUP("Processing next event (parallel)\n");
+   
+   // If the event is a deactivation event that was obviously
+   // not matched and it is the first in the queue, 
+   // we flush.
+   //
+   if(   (ppg_event_buffer_size() == 1)
+      && !(PPG_EB_EVENT(PPG_EB.cur).flags & PPG_Event_Active)
+   ) {
+      return PPG_Pattern_Orphaned_Deactivation;
+   }
+   
+   PPG_Event_Buffer_Index_Type event_id = PPG_EB.cur;
+   
+   // The event buffer of dynamically allocated contexts grows when it 
+   // runs full. Every thread must be able to record all stored events.
+   //
+   if(ppg_event_buffer_get_capacity(&PPG_EB) > PPG_PM.n_records_per_thread) {
+      ppg_parallel_matcher_reserve(&PPG_PM,
+                                   PPG_PM.n_allocated_threads,
+                                   ppg_event_buffer_get_capacity(&PPG_EB),
+                                   &ppg_context->allocator);
+   }
+   
+   if(PPG_PM.n_threads == 0) {
+      
+      ppg_context->current_token = ppg_context->pattern_root;
+      
+      if(ppg_pattern_matching_event_is_irrelevant()) {
+         return PPG_Pattern_Invalid;
+      }
+      
+      // The root node must be reset explicitly
+      //
+      ppg_token_reset(ppg_context->pattern_root);
+      
+      ppg_branch_prepare(ppg_context->pattern_root);
+      
+      PPG_PM.alive 
+         = ppg_parallel_thread_new(ppg_context->pattern_root, 
+                                   PPG_PARALLEL_NONE, 
+                                   event_id);
+      PPG_PM.current = PPG_PM.alive;
+   }
+   
+   PPG_PM.alive = ppg_parallel_process_event(PPG_PM.alive, event_id);
+   
+   return ppg_parallel_matching_resolve();
+}
+
+bool ppg_parallel_matching_process_remaining_branch_options(void)
+{
+   bool pattern_matched = false;
+   
+   // Continue processing until all possible branches for the
+   // given event queue have been processed.
+   //
+   while(ppg_context->current_token) {
+      
+      if(!ppg_work_budget_consume(&ppg_context->work_budget)) { break; }
+      
+      size_t thread_id = PPG_PM.current;
+      
+      PPG_TOKEN_MISC(PPG_PM.threads[thread_id].token).state = PPG_Token_Invalid;
+      PPG_PM.threads[thread_id].state = PPG_Thread_Dead;
+      
+      size_t next = ppg_parallel_thread_revert(thread_id);
+      
+      if(next == PPG_PARALLEL_NONE) {
+         ppg_context->current_token = NULL;
+         break;
+      }
+      
+      PPG_PM.current = next;
+      
+      // All live threads already processed all events
+      //
+      PPG_Count result = ppg_parallel_matching_resolve();
+      
+      if(result == PPG_Pattern_In_Progress) { continue; }
+      
+      pattern_matched |= ppg_pattern_matching_conclude(result);
+      
+      ppg_reset_pattern_matching_engine();
+      
+      pattern_matched |= ppg_pattern_matching_run();
+      
+      if(ppg_context->work_budget.pending) { break; }
+   }
+   
+   return pattern_matched;
+}
+
+void ppg_parallel_matching_synchronize(void)
+{
+   if(PPG_PM.current == PPG_PARALLEL_NONE) { return; }
+   
+   ppg_parallel_matching_apply_records(PPG_PM.current);
+}
+
+void ppg_parallel_matching_on_events_deleted(void)
+{
+   if(PPG_PM.current == PPG_PARALLEL_NONE) { return; }
+   
+   // When stored events are deleted while a pattern is in progress, 
+   // e.g. because a token that is still active from a previous match 
+   // consumed an event, the tree engine continues with the current branch 
+   // and later reverts to event positions that then refer 
+   // to other events. We rather let all live threads continue 
+   // with the events that are stored next. Threads that ended 
+   // on the deleted events are abandoned.
+   //
+   PPG_LOG_TOKEN_LOOKUP("Stored events deleted\n");
+   
+   for(size_t i = 0; i < PPG_PM.n_threads; ++i) {
+      
+      PPG_Parallel_Thread *thread = &PPG_PM.threads[i];
+      
+      switch(thread->state) {
+         case PPG_Thread_Completed:
+         case PPG_Thread_Terminated:
+            thread->state = PPG_Thread_Dead;
+            break;
+      }
+      
+      thread->first_event = PPG_EB.start;
+      thread->end_event = PPG_EB.start;
+      thread->n_records = 0;
+   }
+}
+
+bool ppg_parallel_matching_in_charge(void)
+{
+   return    (ppg_context->engine == PPG_Engine_Parallel)
+          && (   !ppg_context->current_token
+              || (PPG_PM.current != PPG_PARALLEL_NONE));
+}
@@ -0,0 +1,140 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_PARALLEL_MATCHING_DETAIL_H
+#define PPG_PARALLEL_MATCHING_DETAIL_H
+
+#include "ppg_allocator.h"
+#include "detail/ppg_token_detail.h"
+#include "detail/ppg_event_buffer_detail.h"
+#include "ppg_settings.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief The thread index that refers to no thread
+ */
+#define PPG_PARALLEL_NONE ((size_t)-1)
+
+/** @brief A branch of the pattern tree that is followed 
+ *         during pattern matching
+ * 
+ * Threads are created when their parent thread's token 
+ * matches. All threads that are alive receive every event 
+ * in lockstep. Thus, no event is processed twice.
+ * 
+ * As every token is entered at most once while a pattern 
+ * is matched, the number of threads is bounded by the number of tokens.
+ */
+typedef struct {
+   
+   PPG_Token__ *token; ///< The token that is matched by the thread
+   
+   size_t parent; ///< The index of the parent thread (PPG_PARALLEL_NONE for the root thread)
+   
+   size_t first_child; ///< The index of the first child thread
+   
+   size_t n_children; ///< The number of child threads
+   
+   size_t next_alive; ///< The next thread in the list of live threads
+   
+   PPG_Event_Buffer_Index_Type first_event; ///< The event the thread started with
+   
+   PPG_Event_Buffer_Index_Type end_event; ///< The event that terminated the thread
+   
+   PPG_Event_Buffer_Index_Type n_records; ///< The number of events that were processed
+   
+   uint8_t state; ///< The thread state
+   
+} PPG_Parallel_Thread;
+
+/** @brief The result of a token processing an event
+ * 
+ * The lower bits hold the token state after processing, followed 
+ * by a bit that signals a change of state and a bit that signals
+ * that the event was consumed. Records are applied to the event 
+ * buffer in the order the tree engine would have traversed the 
+ * threads, once the outcome of pattern matching is known.
+ */
+typedef uint8_t PPG_Parallel_Record;
+
+typedef struct {
+   
+   PPG_Parallel_Thread *threads;
+   
+   /* The records of a thread are stored contiguously, one per event 
+    * starting with the thread's first event. As a thread processes 
+    * at most all stored events, each thread owns as many records 
+    * as the event buffer has slots.
+    */
+   PPG_Parallel_Record *records;
+   
+   size_t n_threads;
+   size_t n_allocated_threads;
+   
+   size_t n_records_per_thread;
+   
+   size_t alive; ///< The first thread of the list of live threads
+   
+   size_t current; ///< The thread that the tree engine would currently process
+   
+} PPG_Parallel_Matcher;
+
+void ppg_parallel_matcher_init(PPG_Parallel_Matcher *matcher);
+
+void ppg_parallel_matcher_free(PPG_Parallel_Matcher *matcher,
+                               PPG_Allocator *allocator);
+
+// Allocates storage for the given number of threads, each of which 
+// can record the given number of events. This is done when the 
+// pattern tree is compiled. The records of existing threads are preserved.
+//
+void ppg_parallel_matcher_reserve(PPG_Parallel_Matcher *matcher,
+                                  size_t n_threads,
+                                  size_t n_events,
+                                  PPG_Allocator *allocator);
+
+// Forgets about all threads, e.g. when the pattern matching
+// engine is reset
+//
+void ppg_parallel_matcher_reset(PPG_Parallel_Matcher *matcher);
+
+// Passes the current event to all live threads. 
+// Returns one of the PPG_Pattern_... results.
+//
+PPG_Count ppg_parallel_matching_process_next_event(void);
+
+// Returns true if a match occurred
+//
+bool ppg_parallel_matching_process_remaining_branch_options(void);
+
+// Writes the results of all threads that the tree engine
+// would have processed so far to the event buffer
+//
+void ppg_parallel_matching_synchronize(void);
+
+// Must be called when the stored events are deleted
+// while pattern matching is in progress. Live threads 
+// continue with the events that are stored afterwards.
+//
+void ppg_parallel_matching_on_events_deleted(void);
+
+// Returns true if the parallel engine is selected and 
+// processes the current pattern
+//
+bool ppg_parallel_matching_in_charge(void);
+
+#endif
@@ -14,33 +14,26 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "ppg_event.h"
+#include "detail/ppg_pattern_matching_detail.h"
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_global_detail.h"
 #include "detail/ppg_furcation_detail.h"
+#include "detail/ppg_token_dispatch_detail.h"
 #include "detail/ppg_event_buffer_detail.h"
 #include "detail/ppg_signal_detail.h"
+#include "detail/ppg_parallel_matching_detail.h"
+#include "detail/ppg_input_detail.h"
 #include "ppg_debug.h"
 #include "ppg_bitfield.h"
 
-enum {
-   PPG_Pattern_State_Undefined = 0,
-   PPG_Pattern_Matches,
-   PPG_Pattern_Invalid,
-   PPG_Pattern_Orphaned_Deactivation,
-   PPG_Pattern_In_Progress,
-   PPG_Pattern_Branch_Reversion
-};
-
-static void ppg_branch_prepare(PPG_Token__ *branch_token)
+void ppg_branch_prepare(PPG_Token__ *branch_token)
 {
    PPG_LOG_TOKEN_LOOKUP("Preparing branch token 0x%" PRIXPTR "\n", 
             (uintptr_t)branch_token);
    
-   PPG_CALL_VIRT_METHOD(branch_token, reset);
+   ppg_token_reset(branch_token);
    
-   for(PPG_Count i = 0; i < branch_token->n_children; ++i) {
-      ppg_token_reset_control_state(branch_token->children[i]);
-   }
+   ppg_context_reset_children_control_state(branch_token);
 }
 
 PPG_Token__ * ppg_branch_find_root(
@@ -102,11 +95,7 @@ static PPG_Token__ *ppg_furcation_revert(void)
          
          // ... we mark all children as initialized. 
          
-         for(PPG_Count i = 0; i < furcation_token->n_children; ++i) {
-            ppg_token_reset_control_state(furcation_token->children[i]);
-            
-            PPG_PRINT_TOKEN(furcation_token->children[i])
-         }
+         ppg_context_reset_children_control_state(furcation_token);
          
          // Replace the current furcation with the previous one (if possible)
          //
@@ -116,7 +105,7 @@ static PPG_Token__ *ppg_furcation_revert(void)
       
          // Mark the current branch (i.e. the branch's root node) as invalid
          //
-         PPG_CUR_FUR.branch->misc.state = PPG_Token_Invalid;
+         PPG_TOKEN_MISC(PPG_CUR_FUR.branch).state = PPG_Token_Invalid;
       
          --PPG_CUR_FUR.n_branch_candidates;
          
@@ -140,93 +129,223 @@ static PPG_Token__ *ppg_furcation_revert(void)
    return PPG_CUR_FUR.token;
 }
 
-static PPG_Token__ *ppg_token_get_most_appropriate_branch(
+bool ppg_branch_is_candidate(PPG_Token__ *token)
+{
+   if(PPG_TOKEN_MISC(token).state == PPG_Token_Invalid) {
+      return false;
+   }
+   
+   /* Accept only paths through the search tree whose
+   * nodes' ppg_context->layer tags are lower or equal the current ppg_context->layer
+   */
+   /* Note: Positive layer values are interpreted as lower boundaries,
+    *       negative layer values are interpreted as upper boundaries by taking the
+    *       negative and subtracting one.
+    */
+   if(token->layer < 0) {
+      
+      if(ppg_context->layer > (-token->layer - 1)) {
+         PPG_LOG_TOKEN_LOOKUP("   Ignoring 0x%" PRIXPTR " due to insuitably low layer\n",
+         (uintptr_t)token);
+         
+         PPG_TOKEN_MISC(token).state = PPG_Token_Invalid;
+         return false; 
+      }
+   }
+   else if(token->layer > ppg_context->layer) { 
+      
+      PPG_LOG_TOKEN_LOOKUP("   Ignoring 0x%" PRIXPTR " due to insuitably high layer\n",
+        (uintptr_t)token);
+      
+      PPG_TOKEN_MISC(token).state = PPG_Token_Invalid;
+      return false; 
+   }
+   
+   return true;
+}
+
+// Returns false if the current event is the activation of an input
+// that no token of the subtree of the given token uses
+//
+static bool ppg_branch_uses_current_input(PPG_Token__ *token)
+{
+   if(PPG_EB.cur == PPG_EB.end) { return true; }
+   
+   PPG_Event *event = &PPG_EB_EVENT(PPG_EB.cur);
+   
+   if(!(event->flags & PPG_Event_Active)) { return true; }
+   
+   return ppg_input_used_by_subtree(&ppg_context->input_masks, 
+                                    token, 
+                                    event->input);
+}
+
+static void ppg_branch_consider(PPG_Token__ *token,
+                                PPG_Count cur_precedence,
+                                PPG_Count *precedence,
+                                PPG_Layer *highest_layer,
+                                PPG_Token__ **branch_token)
+{
+   if(cur_precedence > *precedence) {
+      *precedence = cur_precedence;
+      *highest_layer = token->layer;
+      
+      *branch_token = token;
+   }
+   else {
+      
+      if(token->layer > *highest_layer) {
+         *highest_layer = token->layer;
+         *branch_token = token;
+      }
+   }
+}
+
+static bool ppg_child_index_get_most_appropriate_branch(
+                        PPG_Token__ *parent_token,
+                        PPG_Count *n_branch_candidates,
+                        PPG_Token__ **branch_token)
+{
+   // The child index only knows about children that are entered 
+   // by input activation. Deactivation events as well as
+   // children that do not supply information about the inputs
+   // they can be entered with are processed by scanning the children.
+   //
+   if(   !ppg_context->child_index.nodes
+      || (PPG_EB.cur == PPG_EB.end)) {
+      return false;
+   }
+   
+   PPG_Event *event = &PPG_EB_EVENT(PPG_EB.cur);
+   
+   if(!(event->flags & PPG_Event_Active)) {
+      return false;
+   }
+   
+   PPG_Child_Index_Node *node 
+         = ppg_child_index_get_node(&ppg_context->child_index, parent_token);
+         
+   if(!node || (node->n_entries == PPG_CHILD_INDEX_QUERY_CHILDREN)) {
+      return false;
+   }
+   
+   PPG_Token_Id n_entries = 0;
+   PPG_Child_Index_Entry *entries 
+      = ppg_child_index_get_entries(&ppg_context->child_index,
+                                    node,
+                                    event->input,
+                                    &n_entries);
+   
+   PPG_Layer highest_layer = -1;
+   PPG_Count precedence = 0;
+   
+   *n_branch_candidates = 0;
+   *branch_token = NULL;
+   
+   for(PPG_Token_Id i = 0; i < n_entries; ++i) {
+      
+      PPG_Token__ *child = parent_token->children[entries[i].child];
+      
+      if(!ppg_branch_is_candidate(child)) { continue; }
+      
+      ++(*n_branch_candidates);
+      
+      ppg_branch_consider(
+         child, 
+         ppg_context->child_index.nodes[
+            node->first_child + entries[i].child].precedence,
+         &precedence,
+         &highest_layer,
+         branch_token);
+   }
+   
+   // If no child can consume the input, we scan the children. 
+   // They are tried and fail one after another, which 
+   // causes a reversion to the previous furcation. 
+   // A furcation without candidates would instead render the 
+   // overall pattern invalid.
+   //
+   return *n_branch_candidates > 0;
+}
+
+PPG_Token__ *ppg_token_get_most_appropriate_branch(
                         PPG_Token__ *parent_token,
                         PPG_Count *n_branch_candidates)
 {
    PPG_LOG_TOKEN_LOOKUP("Getting most appropriate branch for 0x%" PRIXPTR "\n",
            (uintptr_t)parent_token);
    
+   PPG_Token__ *branch_token = NULL;
+   
+   if(ppg_child_index_get_most_appropriate_branch(parent_token,
+                                                  n_branch_candidates,
+                                                  &branch_token)) {
+      return branch_token;
+   }
+   
+   // If the child index is available, it supplies the 
+   // precedences of the children
+   //
+   PPG_Child_Index_Node *node 
+         = (ppg_context->child_index.nodes) ?
+               ppg_child_index_get_node(&ppg_context->child_index, parent_token)
+            :  NULL;
+   
    // Determine the number of possible candidates
    //
    PPG_Layer highest_layer = -1;
-   PPG_Token__ *branch_token = NULL;
    PPG_Count precedence = 0;
    
-   *n_branch_candidates = 0;
+   // A branch that can be entered on the current layer
+   // but whose tokens do not use the input of the current event
+   //
+   PPG_Token__ *unused_branch = NULL;
    
-//    PPG_LOG("Getting most appropriate child\n");
+   *n_branch_candidates = 0;
    
    /* Find the most suitable token with respect to the current ppg_context->layer.
    */
    for(PPG_Count i = 0; i < parent_token->n_children; ++i) {
-         
-      if(parent_token->children[i]->misc.state == PPG_Token_Invalid) {
-         
-//          PPG_LOG("   Ignoring 0x%" PRIXPTR " as invalid\n",
-//            (uintptr_t)parent_token->children[i]);
-         
-//          #if PPG_HAVE_DEBUGGING
-//          PPG_PRINT_TOKEN(parent_token->children[i])
-//          #endif
-         continue;
-      }
       
-      /* Accept only paths through the search tree whose
-      * nodes' ppg_context->layer tags are lower or equal the current ppg_context->layer
-      */
-      /* Note: Positive layer values are interpreted as lower boundaries,
-       *       negative layer values are interpreted as upper boundaries by taking the
-       *       negative and subtracting one.
-       */
-      if(parent_token->children[i]->layer < 0) {
+      if(!ppg_branch_is_candidate(parent_token->children[i])) { continue; }
+      
+      // Branches that cannot use the input fail with the current event.
+      // They are not considered as candidates.
+      //
+      if(!ppg_branch_uses_current_input(parent_token->children[i])) {
          
-         if(ppg_context->layer > (-parent_token->children[i]->layer - 1)) {
-            PPG_LOG_TOKEN_LOOKUP("   Ignoring 0x%" PRIXPTR " due to insuitably low layer\n",
-            (uintptr_t)parent_token->children[i]);
-            
-            parent_token->children[i]->misc.state = PPG_Token_Invalid;
-            continue; 
+         if(!unused_branch) {
+            unused_branch = parent_token->children[i];
          }
-      }
-      else if(parent_token->children[i]->layer > ppg_context->layer) { 
-         
-         PPG_LOG_TOKEN_LOOKUP("   Ignoring 0x%" PRIXPTR " due to insuitably high layer\n",
-           (uintptr_t)parent_token->children[i]);
-         
-         parent_token->children[i]->misc.state = PPG_Token_Invalid;
-         continue; 
+         continue;
       }
 
       ++(*n_branch_candidates);
-   
-//       PPG_LOG("Child %d\n", i);
-      
-//       PPG_PRINT_TOKEN(parent_token->children[i])
       
       PPG_Count cur_precedence 
-            = parent_token->children[i]
-                  ->vtable->token_precedence(parent_token->children[i]);
-                  
-//       PPG_LOG("Cur precedence %d\n", cur_precedence);
-//       PPG_LOG("precedence %d\n", precedence);
+            = (node) ?
+                  ppg_context->child_index.nodes[node->first_child + i].precedence
+               :  ppg_token_precedence(parent_token->children[i]);
             
-      if(cur_precedence > precedence) {
-         precedence = cur_precedence;
-         highest_layer = parent_token->children[i]->layer;
-         
-         branch_token = parent_token->children[i];
-      }
-      else {
-         
-//          PPG_LOG("Equal precedence\n");
-         
-         if(parent_token->children[i]->layer > highest_layer) {
-            highest_layer = parent_token->children[i]->layer;
-            branch_token = parent_token->children[i];
-         }
-      }
-//       PPG_LOG("match_id %d\n", match_id);
+      ppg_branch_consider(parent_token->children[i],
+                          cur_precedence,
+                          &precedence,
+                          &highest_layer,
+                          &branch_token);
+   }
+   
+   // If no branch can use the input, we follow one of those that 
+   // cannot as the only candidate. It fails right away, which causes 
+   // a reversion to the previous furcation in the same way as if all 
+   // of them had been tried. A furcation without candidates would 
+   // instead render the overall pattern invalid.
+   //
+   if(!branch_token && unused_branch) {
+      
+      PPG_LOG_TOKEN_LOOKUP("No branch can use the input\n");
+      
+      *n_branch_candidates = 1;
+      branch_token = unused_branch;
    }
    
    #if PPG_HAVE_LOGGING
@@ -251,12 +370,15 @@ static PPG_Token__ *ppg_token_get_next_possible_branch(
             
    bool revert_to_previous_furcation = false;
    
-   if(parent_token->misc.state == PPG_Token_Invalid) {
+   if(PPG_TOKEN_MISC(parent_token).state == PPG_Token_Invalid) {
       revert_to_previous_furcation = true;
    }
    else if(parent_token->n_children == 1) {
       
-      if(parent_token->children[0]->misc.state == PPG_Token_Invalid) {
+      // A single child is subject to the same layer check as 
+      // the children of a furcation
+      //
+      if(!ppg_branch_is_candidate(parent_token->children[0])) {
          revert_to_previous_furcation = true;
       }
       else {
@@ -333,6 +455,71 @@ static PPG_Token__ *ppg_token_get_next_possible_branch(
    return branch;
 }
 
+bool ppg_token_completes_pattern(PPG_Token__ *token)
+{
+   // If no longer pattern can be continued on the current layer, there
+   // is no need to wait for further events or a timeout
+   //
+   return ppg_token_completes_on_layer(&ppg_context->completion_marks,
+                                       token,
+                                       ppg_context->layer);
+}
+
+// Returns true if the token of the current branch matched 
+// and completes the pattern
+//
+static bool ppg_pattern_matching_branch_completed(void)
+{
+   // The parallel engine resolves completed branches on its own
+   //
+   if(ppg_parallel_matching_in_charge()) { return false; }
+   
+   PPG_Count state = PPG_TOKEN_MISC(ppg_context->current_token).state;
+   
+   return   (   (state == PPG_Token_Matches)
+             || (state == PPG_Token_Finalized))
+         && ppg_token_completes_pattern(ppg_context->current_token);
+}
+
+bool ppg_branch_match_event(PPG_Token__ *token, PPG_Event *event)
+{
+   // All tokens that report their inputs are invalidated by the 
+   // activation of any other input. If none of the tokens of the branch 
+   // uses the input, the branch can thus not continue and we spare 
+   // asking the token.
+   //
+   if(   (event->flags & PPG_Event_Active)
+      && !ppg_input_used_by_subtree(&ppg_context->input_masks, 
+                                    token, 
+                                    event->input)) {
+      
+      PPG_LOG_TOKEN_LOOKUP("Input unused by branch\n");
+      
+      PPG_TOKEN_MISC(token).state = PPG_Token_Invalid;
+      
+      return false;
+   }
+   
+   #if PPG_HAVE_STATISTICS
+   ++ppg_context->statistics.n_token_checks;
+   #endif
+   
+   // Ask the token to process the event.
+   //
+   return ppg_token_match_event(token, 
+                                event,
+                                false /*allow modifications in any case*/);
+}
+
+bool ppg_pattern_matching_event_is_irrelevant(void)
+{
+   PPG_Event *event = &PPG_EB_EVENT(PPG_EB.cur);
+   
+   return      (event->flags & PPG_Event_Active)
+            && !ppg_input_is_relevant(&ppg_context->input_masks, 
+                                      event->input);
+}
+
 static PPG_Count ppg_process_next_event(void)
 {  
    PPG_LOG_TOKEN_LOOKUP("Processing next event\n");
@@ -342,7 +529,7 @@ static PPG_Count ppg_process_next_event(void)
    // we flush.
    //
    if(   (ppg_event_buffer_size() == 1)
-      && !(PPG_EB.events[PPG_EB.cur].event.flags & PPG_Event_Active)
+      && !(PPG_EB_EVENT(PPG_EB.cur).flags & PPG_Event_Active)
    ) {
       
 //       PPG_LOG("orpth deact\n");
@@ -354,19 +541,26 @@ static PPG_Count ppg_process_next_event(void)
       
       ppg_context->current_token = ppg_context->pattern_root;
       
+      // No branch can consume the activation of an input
+      // that is not used by any pattern. Thus, we spare the search.
+      //
+      if(ppg_pattern_matching_event_is_irrelevant()) {
+         return PPG_Pattern_Invalid;
+      }
+      
       // The root node must be reset explicitly
       //
-      PPG_CALL_VIRT_METHOD(ppg_context->current_token, reset);
+      ppg_token_reset(ppg_context->current_token);
       
       ppg_branch_prepare(ppg_context->current_token);
    }
 
    PPG_LOG_TOKEN_LOOKUP("Current token 0x%" PRIXPTR ", state %u\n", 
              (uintptr_t)ppg_context->current_token,
-             (PPG_Count)ppg_context->current_token->misc.state
+             (PPG_Count)PPG_TOKEN_MISC(ppg_context->current_token).state
           );
  
-   PPG_Count state = ppg_context->current_token->misc.state;
+   PPG_Count state = PPG_TOKEN_MISC(ppg_context->current_token).state;
    
    // Pretend a match for the root token
    //
@@ -427,73 +621,124 @@ static PPG_Count ppg_process_next_event(void)
       ppg_context->current_token = branch_token;
    }
 
-   PPG_Event *event = &PPG_EB.events[PPG_EB.cur].event;
+   PPG_Event *event = &PPG_EB_EVENT(PPG_EB.cur);
    
 //    PPG_LOG("Branch token 0x%" PRIXPTR "\n", 
 //              (uintptr_t)ppg_context->current_token);
 
    
-   PPG_Count state_before = ppg_context->current_token->misc.state;
+   PPG_Count state_before = PPG_TOKEN_MISC(ppg_context->current_token).state;
    
    PPG_LOG_TOKEN_LOOKUP("Try to match event %d\n", PPG_EB.cur)
    
-   // Ask the token to process the event.
-   //
-   bool event_consumed =
-         ppg_context->current_token
-            ->vtable->match_event(  
-                     ppg_context->current_token, 
-                     event,
-                     false /*allow modifications in any case*/
-               );
+   bool event_consumed = ppg_branch_match_event(ppg_context->current_token, 
+                                                event);
             
    PPG_LOG_TOKEN_LOOKUP("event consumed: %d\n", event_consumed);
             
-   PPG_EB.events[PPG_EB.cur].token_state.changed =
-      state_before != ppg_context->current_token->misc.state;
-   PPG_EB.events[PPG_EB.cur].token_state.state = 
-      ppg_context->current_token->misc.state;
+   PPG_EB_ENTRY(PPG_EB.cur).token_state.changed =
+      state_before != PPG_TOKEN_MISC(ppg_context->current_token).state;
+   PPG_EB_ENTRY(PPG_EB.cur).token_state.state = 
+      PPG_TOKEN_MISC(ppg_context->current_token).state;
       
    if(event_consumed) {
-      PPG_EB.events[PPG_EB.cur].consumer =
+      PPG_EB_ENTRY(PPG_EB.cur).consumer =
             ppg_context->current_token;
    }
    else {
-      PPG_EB.events[PPG_EB.cur].consumer = NULL;
+      PPG_EB_ENTRY(PPG_EB.cur).consumer = NULL;
    }
             
-   #if PPG_HAVE_STATISTICS
-   ++ppg_context->statistics.n_token_checks;
-   #endif
-            
    PPG_LOG("Token state of 0x%" PRIXPTR " after match_event: %u\n", 
            (uintptr_t)ppg_context->current_token,
-           (PPG_Count)ppg_context->current_token->misc.state);
+           (PPG_Count)PPG_TOKEN_MISC(ppg_context->current_token).state);
    PPG_LOG("Event consumed: %u\n", event_consumed);
 
-   switch(ppg_context->current_token->misc.state) {
+   // Whether a match completes the pattern is decided 
+   // by ppg_pattern_matching_run
+   //
+   if(PPG_TOKEN_MISC(ppg_context->current_token).state == PPG_Token_Invalid) {
+      return PPG_Pattern_Branch_Reversion;
+   }
       
-      case PPG_Token_Matches:
-      case PPG_Token_Finalized:
-         if(ppg_context->current_token->n_children == 0){
+   PPG_LOG_TOKEN_LOOKUP("Token state %d\n", PPG_TOKEN_MISC(ppg_context->current_token).state);
+   PPG_LOG_TOKEN_LOOKUP("p in prog\n");
+   
+   return PPG_Pattern_In_Progress;
+}
+
+bool ppg_pattern_matching_conclude(PPG_Count result)
+{
+   bool pattern_matched = false;
+   
+   switch(result) {
+      
+      case PPG_Pattern_Matches:
+         
+         ppg_recurse_and_process_actions(ppg_context->current_token);
+         
+         ppg_event_buffer_on_match_success();
+         
+         pattern_matched = true;
+         
+         break;
+         
+      case PPG_Pattern_Invalid:
+      {
+         bool action_processed 
+            = ppg_recurse_and_process_actions(ppg_context->current_token);
+   
+         if(action_processed) { 
+            
+//             PPG_LOG("Fallback success\n");
+            
+            // Fallback was possible
+         
+            // If an action was processed, we consider the processing as a match
+            //
+            ppg_event_buffer_on_match_success();
             
-            PPG_LOG_TOKEN_LOOKUP("p match\n");
+            // Prevent the timeout signal handler from processig events
+            //
+            ppg_delete_stored_events();
+         }
+         else {
          
-            // We found a matching pattern
+            // If no furcation was found, there is no chance
+            // for a match. Thus we remove the first stored event
+            // and rerun the overall pattern matching based on a
+            // new first event.
             //
-            return PPG_Pattern_Matches;
+            ppg_signal(PPG_On_Match_Failed);       
+            
+            PPG_LOG_TOKEN_LOOKUP("Match failed\n");
+            ppg_event_buffer_flush_failed_front();
          }
+      }
          break;
-      case PPG_Token_Invalid:
+         
+      case PPG_Pattern_Orphaned_Deactivation:
+         
+//          PPG_LOG("Orph deact\n");
+         
+         // Prepare the event buffer for 
+         // user processing
+         //
+         ppg_event_buffer_on_match_success();
+         
+         // If no furcation was found, there is no chance
+         // for a match. Thus we remove the first stored event
+         // and rerun the overall pattern matching based on a
+         // new first event.
+         //
+         ppg_signal(PPG_On_Flush_Events);       
 
-         return PPG_Pattern_Branch_Reversion;
+         ppg_delete_stored_events();
+         
          break;
    }
-      
-   PPG_LOG_TOKEN_LOOKUP("Token state %d\n", ppg_context->current_token->misc.state);
-   PPG_LOG_TOKEN_LOOKUP("p in prog\n");
    
-   return PPG_Pattern_In_Progress;
+   return pattern_matched;
 }
 
 bool ppg_pattern_matching_run(void)
@@ -504,76 +749,31 @@ bool ppg_pattern_matching_run(void)
    
    while(ppg_event_buffer_events_left()) {
       
-      PPG_Count process_event_result = ppg_process_next_event();
+      // If the work budget is exhausted, we stop here. The state of the 
+      // engine is preserved to resume with the current event.
+      //
+      if(!ppg_work_budget_consume(&ppg_context->work_budget)) { break; }
+      
+      PPG_Count process_event_result 
+         = ppg_parallel_matching_in_charge() ?
+                  ppg_parallel_matching_process_next_event()
+                : ppg_process_next_event();
       
       switch(process_event_result) {
-         
-         case PPG_Pattern_Matches:
-            
-            ppg_recurse_and_process_actions(ppg_context->current_token);
-            
-            ppg_event_buffer_on_match_success();
-            
-            pattern_matched = true;
-            
-            break;
             
-         case PPG_Pattern_Invalid:
-         {
-            bool action_processed 
-               = ppg_recurse_and_process_actions(ppg_context->current_token);
-      
-            if(action_processed) { 
-               
-//                PPG_LOG("Fallback success\n");
-               
-               // Fallback was possible
+         case PPG_Pattern_In_Progress:
             
-               // If an action was processed, we consider the processing as a match
-               //
-               ppg_event_buffer_on_match_success();
+            // If the current branch matched and cannot grow any further,
+            // we commit the match right away instead of waiting 
+            // for further events or a timeout
+            //
+            if(ppg_pattern_matching_branch_completed()) {
                
-               // Prevent the timeout signal handler from processig events
-               //
-               ppg_delete_stored_events();
-            }
-            else {
-            
-               // If no furcation was found, there is no chance
-               // for a match. Thus we remove the first stored event
-               // and rerun the overall pattern matching based on a
-               // new first event.
-               //
-               ppg_signal(PPG_On_Match_Failed);       
+               PPG_LOG_TOKEN_LOOKUP("p match\n");
                
-               PPG_LOG_TOKEN_LOOKUP("Match failed\n");
-               ppg_even_buffer_flush_and_remove_first_event(false /* no success */);
-               ppg_event_buffer_flush_and_remove_non_processable_deactivation_events();
+               process_event_result = PPG_Pattern_Matches;
+               break;
             }
-         }
-            break;
-            
-         case PPG_Pattern_Orphaned_Deactivation:
-            
-//             PPG_LOG("Orph deact\n");
-            
-            // Prepare the event buffer for 
-            // user processing
-            //
-            ppg_event_buffer_on_match_success();
-            
-            // If no furcation was found, there is no chance
-            // for a match. Thus we remove the first stored event
-            // and rerun the overall pattern matching based on a
-            // new first event.
-            //
-            ppg_signal(PPG_On_Flush_Events);       
-
-            ppg_delete_stored_events();
-            
-            break;
-            
-         case PPG_Pattern_In_Progress:
             
             ppg_event_buffer_advance();
             
@@ -587,6 +787,8 @@ bool ppg_pattern_matching_run(void)
             continue;
       }
       
+      pattern_matched |= ppg_pattern_matching_conclude(process_event_result);
+      
       // Prepare for restart of pattern matching
       //
       ppg_reset_pattern_matching_engine();
@@ -597,6 +799,10 @@ bool ppg_pattern_matching_run(void)
 
 bool ppg_pattern_matching_process_remaining_branch_options(void)
 {
+   if(ppg_parallel_matching_in_charge()) {
+      return ppg_parallel_matching_process_remaining_branch_options();
+   }
+   
    bool pattern_matched = false;
    
    // Continue processing until all possible branches for the
@@ -604,7 +810,9 @@ bool ppg_pattern_matching_process_remaining_branch_options(void)
    //
    while(ppg_context->current_token) {
       
-      ppg_context->current_token->misc.state = PPG_Token_Invalid;
+      if(!ppg_work_budget_consume(&ppg_context->work_budget)) { break; }
+      
+      PPG_TOKEN_MISC(ppg_context->current_token).state = PPG_Token_Invalid;
       
       ppg_context->current_token 
                      = ppg_token_get_next_possible_branch(
@@ -613,12 +821,21 @@ bool ppg_pattern_matching_process_remaining_branch_options(void)
       if(ppg_context->current_token) {
          
          pattern_matched |= ppg_pattern_matching_run();
+         
+         if(ppg_context->work_budget.pending) { break; }
       }
    }
    
    return pattern_matched;
 }
 
+void ppg_pattern_matching_synchronize(void)
+{
+   if(ppg_parallel_matching_in_charge()) {
+      ppg_parallel_matching_synchronize();
+   }
+}
+
 bool ppg_pattern_matching_in_progress(void)
 {
    return ppg_event_buffer_size() > 0;
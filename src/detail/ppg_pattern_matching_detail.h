@@ -21,7 +21,17 @@
 
 #include <stdbool.h>
 
-// Returns true if a match occurred
+enum {
+   PPG_Pattern_State_Undefined = 0,
+   PPG_Pattern_Matches,
+   PPG_Pattern_Invalid,
+   PPG_Pattern_Orphaned_Deactivation,
+   PPG_Pattern_In_Progress,
+   PPG_Pattern_Branch_Reversion
+};
+
+// Returns true if a match occurred. Stops early if the work budget
+// is exhausted. Calling it again resumes with the current event.
 //
 bool ppg_pattern_matching_run(void);
 
@@ -29,10 +39,52 @@ bool ppg_pattern_matching_run(void);
 //
 bool ppg_pattern_matching_in_progress(void);
 
-// Returns true if a match occurred
+// Returns true if a match occurred. Stops early if the work budget
+// is exhausted. To resume, ppg_pattern_matching_run must be called 
+// before calling this function again.
 //
 bool ppg_pattern_matching_process_remaining_branch_options(void);
 
+// Finishes the processing of the event buffer after a pattern
+// matched or was found to be invalid. Returns true if a match occurred
+//
+bool ppg_pattern_matching_conclude(PPG_Count result);
+
+// Returns true if a token that matched completes the pattern. This is
+// the case if it has no children or if it carries an action and none of
+// its children can be entered on the current layer, 
+// see PPG_Completion_Mark.
+//
+bool ppg_token_completes_pattern(PPG_Token__ *token);
+
+// Returns true if the current event is the activation of an input
+// that no pattern can consume
+//
+bool ppg_pattern_matching_event_is_irrelevant(void);
+
+// Passes an event to the token of the current branch. Returns true if 
+// the event was consumed. The activation of an input that no token 
+// of the branch's subtree uses renders the token invalid without 
+// it being asked.
+//
+bool ppg_branch_match_event(PPG_Token__ *token, PPG_Event *event);
+
+// Makes sure that the event buffer reflects the state of
+// the pattern matching engine before it is accessed from outside
+//
+void ppg_pattern_matching_synchronize(void);
+
+void ppg_branch_prepare(PPG_Token__ *branch_token);
+
+// Returns false and marks the token invalid if it cannot be entered 
+// on the current layer
+//
+bool ppg_branch_is_candidate(PPG_Token__ *token);
+
+PPG_Token__ *ppg_token_get_most_appropriate_branch(
+                        PPG_Token__ *parent_token,
+                        PPG_Count *n_branch_candidates);
+
 PPG_Token__ * ppg_branch_find_root(
                         PPG_Token__ *cur_token,
                         PPG_Token__ *end_token);
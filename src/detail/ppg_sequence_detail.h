@@ -22,9 +22,14 @@
 
 typedef struct {
    PPG_Aggregate aggregate;
-   PPG_Count next_member;
 } PPG_Sequence;
 
 extern PPG_Token_Vtable ppg_sequence_vtable;
 
+bool ppg_sequence_match_event(PPG_Sequence *sequence,
+                              PPG_Event *event,
+                              bool modify_only_if_consuming);
+                              
+void ppg_sequence_reset(PPG_Sequence *sequence);
+
 #endif
@@ -0,0 +1,43 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_TIMEOUT_DETAIL_H
+#define PPG_TIMEOUT_DETAIL_H
+
+#include "ppg_settings.h"
+
+#include <stdbool.h>
+
+// Checks for a timeout with respect to the given time instead
+// of the time reported by the time manager
+//
+bool ppg_timeout_check_at(PPG_Time cur_time);
+
+// Continues processing a timeout that was interrupted because
+// the work budget was exhausted. Pattern matching must have been 
+// resumed before.
+//
+void ppg_timeout_resume(void);
+
+struct PPG_Context_Struct;
+
+// Retreives the timeout deadline of a context that is not
+// necessarily the current context
+//
+bool ppg_timeout_get_deadline_of(struct PPG_Context_Struct *context, 
+                                 PPG_Time *deadline);
+
+#endif
@@ -0,0 +1,67 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_TIMER_WHEEL_DETAIL_H
+#define PPG_TIMER_WHEEL_DETAIL_H
+
+#include "detail/ppg_context_detail.h"
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+typedef struct PPG_Timer_Wheel_Entry_Struct {
+   
+   // Entries are stored in singly linked lists per slot. 
+   // prev_next points to the pointer that refers to the entry. This
+   // allows for removing an entry without knowing its slot.
+   //
+   struct PPG_Timer_Wheel_Entry_Struct *next;
+   struct PPG_Timer_Wheel_Entry_Struct **prev_next;
+   
+   // All entries of a timer wheel, whether scheduled or not
+   //
+   struct PPG_Timer_Wheel_Entry_Struct *next_registered;
+   struct PPG_Timer_Wheel_Entry_Struct **prev_next_registered;
+   
+   struct PPG_Timer_Wheel_Struct *timer_wheel;
+   
+   PPG_Context *context;
+   
+   // The tick at which the timeout of the context is checked
+   //
+   PPG_Time expiry;
+   
+} PPG_Timer_Wheel_Entry;
+
+// Schedules the current context with its timer wheel if it 
+// has stored events or pending work and is not already scheduled
+//
+void ppg_timer_wheel_schedule(PPG_Timer_Wheel_Entry *entry);
+
+inline
+static void ppg_timer_wheel_on_events_processed(void)
+{
+   if(ppg_context->timer_wheel_entry) {
+      ppg_timer_wheel_schedule(ppg_context->timer_wheel_entry);
+   }
+}
+
+#else
+
+#define ppg_timer_wheel_on_events_processed()
+
+#endif
+
+#endif
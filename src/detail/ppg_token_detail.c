@@ -41,44 +41,213 @@ void ppg_token_reset_control_state(PPG_Token__ *token)
 {
 //    PPG_LOG("Resetting tk 0x%" PRIXPTR "\n", (uintptr_t)token);
    
-   token->misc.state = PPG_Token_Initialized;
-   token->misc.action_state = PPG_Action_Disabled;
+   PPG_TOKEN_MISC(token).state = PPG_Token_Initialized;
+   PPG_TOKEN_MISC(token).action_state = PPG_Action_Disabled;
+}
+
+void ppg_token_completion_marks_init(PPG_Completion_Marks *completion_marks)
+{
+   completion_marks->marks = NULL;
+   completion_marks->n_tokens = 0;
+}
+
+static void ppg_token_mark_completion(PPG_Token__ *token,
+                                      PPG_Completion_Marks *completion_marks)
+{
+   PPG_Completion_Mark *mark = &completion_marks->marks[token->id];
+   
+   mark->children_lower_layer = -1;
+   mark->children_upper_layer = 0;
+   
+   if(token->n_children == 0) {
+      mark->type = PPG_Completion_Always;
+      return;
+   }
+   
+   // Without an action, a match of an interior token is only
+   // a step towards a longer pattern
+   //
+   mark->type = (token->action.callback.func) ?
+                     PPG_Completion_By_Layer
+                  :  PPG_Completion_Never;
+   
+   for(PPG_Count i = 0; i < token->n_children; ++i) {
+      
+      PPG_Layer layer = token->children[i]->layer;
+      
+      if(layer < 0) {
+         if(layer < mark->children_upper_layer) {
+            mark->children_upper_layer = layer;
+         }
+      }
+      else if(   (mark->children_lower_layer < 0)
+              || (layer < mark->children_lower_layer)) {
+         mark->children_lower_layer = layer;
+      }
+   }
+}
+
+void ppg_token_compile_completion_marks(PPG_Completion_Marks *completion_marks,
+                                        PPG_Token__ *root,
+                                        PPG_Token_Id n_tokens,
+                                        PPG_Allocator *allocator)
+{
+   ppg_token_free_completion_marks(completion_marks, allocator);
+   
+   if(n_tokens == 0) { return; }
+   
+   completion_marks->marks 
+      = (PPG_Completion_Mark *)ppg_allocator_malloc(allocator,
+                                 n_tokens*sizeof(PPG_Completion_Mark));
+   completion_marks->n_tokens = n_tokens;
+   
+   ppg_token_traverse_tree(root,
+                           (PPG_Token_Tree_Visitor)ppg_token_mark_completion,
+                           NULL,
+                           (void*)completion_marks);
+}
+
+void ppg_token_free_completion_marks(PPG_Completion_Marks *completion_marks,
+                                     PPG_Allocator *allocator)
+{
+   ppg_allocator_free(allocator, completion_marks->marks);
+   
+   ppg_token_completion_marks_init(completion_marks);
+}
+
+bool ppg_token_completes_on_layer(PPG_Completion_Marks *completion_marks,
+                                  PPG_Token__ *token,
+                                  PPG_Layer layer)
+{
+   // Tokens that were added after the tree was compiled 
+   // have no mark
+   //
+   if(   !completion_marks->marks
+      || (token->id >= completion_marks->n_tokens)) {
+      return token->n_children == 0;
+   }
+   
+   PPG_Completion_Mark *mark = &completion_marks->marks[token->id];
+   
+   switch(mark->type) {
+      case PPG_Completion_Always:
+         return true;
+      case PPG_Completion_Never:
+         return false;
+   }
+   
+   // The layer bounds are applied in the same way as 
+   // during branch selection
+   //
+   if(   (mark->children_lower_layer >= 0)
+      && (layer >= mark->children_lower_layer)) {
+      return false;
+   }
+   
+   if(   (mark->children_upper_layer < 0)
+      && (layer <= (-mark->children_upper_layer - 1))) {
+      return false;
+   }
+   
+   return true;
+}
+
+static void ppg_token_count_visitor(PPG_Token__ *token, void *user_data)
+{
+   PPG_UNUSED(token);
+
+   ++(*(size_t*)user_data);
+}
+
+PPG_Token_Id ppg_token_assign_ids(PPG_Token__ *root,
+                                  PPG_Allocator *allocator)
+{
+   size_t n_tokens = 0;
+
+   ppg_token_traverse_tree(root,
+                           ppg_token_count_visitor,
+                           NULL,
+                           (void*)&n_tokens);
+   
+   // The invalid id must remain distinguishable from all assigned ids
+   //
+   if(n_tokens >= (size_t)PPG_TOKEN_ID_INVALID) {
+      PPG_ERROR("Pattern tree with %lu tokens exceeds the range of "
+                "PPG_Token_Id\n", (unsigned long)n_tokens);
+      abort();
+   }
+
+   // Use a queue to visit the tokens in breadth first order
+   //
+   PPG_Token__ **queue
+      = (PPG_Token__ **)ppg_allocator_malloc(allocator,
+                                             n_tokens*sizeof(PPG_Token__ *));
+
+   queue[0] = root;
+   root->id = 0;
+
+   size_t n_assigned = 1;
+
+   for(size_t t = 0; t < n_tokens; ++t) {
+
+      PPG_Token__ *token = queue[t];
+
+      for(PPG_Count i = 0; i < token->n_children; ++i) {
+         token->children[i]->id = (PPG_Token_Id)n_assigned;
+         queue[n_assigned] = token->children[i];
+         ++n_assigned;
+      }
+   }
+
+   PPG_ASSERT(n_assigned == n_tokens);
+
+   ppg_allocator_free(allocator, queue);
+
+   return (PPG_Token_Id)n_tokens;
 }
 
 PPG_Token__ *ppg_token_alloc(void) 
 {
-    return (PPG_Token__*)PPG_MALLOC(sizeof(PPG_Token__));
+    return (PPG_Token__*)ppg_tree_malloc(sizeof(PPG_Token__));
 }
 
 static void ppg_token_allocate_children(PPG_Token__ *token, PPG_Count n_children) {
 
     token->children 
-      = (struct PPG_TokenStruct **)PPG_MALLOC(n_children*sizeof(struct PPG_TokenStruct*));
+      = (struct PPG_TokenStruct **)ppg_tree_malloc(n_children*sizeof(struct PPG_TokenStruct*));
     token->n_allocated_children = n_children;
 }
 
 static void ppg_token_grow_children(PPG_Token__ *token) {
 
-   if(token->n_allocated_children == 0) {
+   PPG_Token__ **oldSucessors = token->children;
+   
+   // Children arrays that are not owned by the token, e.g. 
+   // because they are part of a compacted children block, 
+   // are copied but never freed
+   //
+   bool owned = (token->n_allocated_children != 0);
+   
+   if(token->n_children == 0) {
       
       ppg_token_allocate_children(token, 1);
    }
    else {
-      PPG_Token__ **oldSucessors = token->children;
-      
-      ppg_token_allocate_children(token, 2*token->n_allocated_children);
+      ppg_token_allocate_children(token, 2*token->n_children);
          
       for(PPG_Count i = 0; i < token->n_children; ++i) {
          token->children[i] = oldSucessors[i];
       }
-      
-      free(oldSucessors); 
+   }
+   
+   if(owned) {
+      ppg_tree_free(oldSucessors); 
    }
 }
 
 void ppg_token_add_child(PPG_Token__ *token, PPG_Token__ *child) {
    
-   if(token->n_allocated_children == token->n_children) {
+   if(token->n_allocated_children <= token->n_children) {
       ppg_token_grow_children(token);
    }
    
@@ -101,12 +270,73 @@ void ppg_token_free_children(PPG_Token__ *token)
       ppg_token_free(token->children[i]);
    }
    
-   free(token->children);
+   if(token->n_allocated_children != 0) {
+      ppg_tree_free(token->children);
+   }
    
    token->children = NULL;
    token->n_allocated_children = 0;
 }
 
+static void ppg_token_count_children_visitor(PPG_Token__ *token, 
+                                             void *user_data)
+{
+   *(size_t*)user_data += token->n_children;
+}
+
+PPG_Token__ **ppg_token_compact_children(PPG_Token__ *root,
+                                         PPG_Allocator *allocator)
+{
+   size_t n_children_total = 0;
+   
+   ppg_token_traverse_tree(root,
+                           ppg_token_count_children_visitor,
+                           NULL,
+                           (void*)&n_children_total);
+   
+   if(n_children_total == 0) { return NULL; }
+   
+   PPG_Token__ **block
+      = (PPG_Token__ **)ppg_allocator_malloc(allocator,
+                                 n_children_total*sizeof(PPG_Token__ *));
+   
+   // The block itself serves as the queue of a breadth first traversal. 
+   // The children of the n-th token that is appended
+   // are stored directly behind those of the (n-1)-th token.
+   //
+   size_t n_stored = 0;
+   size_t next = 0;
+   
+   PPG_Token__ *token = root;
+   
+   while(true) {
+      
+      PPG_Token__ **children = block + n_stored;
+      
+      for(PPG_Count i = 0; i < token->n_children; ++i) {
+         children[i] = token->children[i];
+      }
+      
+      if(token->n_allocated_children != 0) {
+         ppg_tree_free(token->children);
+      }
+      
+      token->children = (token->n_children != 0) ? children : NULL;
+      token->n_allocated_children = 0;
+      
+      n_stored += token->n_children;
+      
+      if(next == n_stored) { break; }
+      
+      token = block[next];
+      ++next;
+   }
+   
+   PPG_ASSERT(n_stored == n_children_total);
+   
+   return block;
+}
+
 PPG_Token__* ppg_token_destroy(PPG_Token__ *token) {
 
 //    printf("Destroying token %p\n", token);
@@ -127,7 +357,7 @@ void ppg_token_free(PPG_Token__ *token) {
    
    PPG_CALL_VIRT_METHOD(token, destroy);
 
-   free(token);
+   ppg_tree_free(token);
 }
 
 PPG_Token__* ppg_token_get_equivalent_child(
@@ -201,13 +431,13 @@ void ppg_token_register_pointers_for_compression(
 void ppg_token_print_self_start(PPG_Token__ *p, PPG_Count indent)
 {
    PPG_I PPG_LOG("\tprnt: 0x%" PRIXPTR "\n", (uintptr_t)p->parent);
-   PPG_I PPG_LOG("\tst: %d\n", (PPG_Count)p->misc.state);
-   PPG_I PPG_LOG("\tflgs: %d\n", (PPG_Count)p->misc.flags);
-   PPG_I PPG_LOG("\ta.st: %d\n", (PPG_Count)p->misc.action_state);
+   PPG_I PPG_LOG("\tst: %d\n", (PPG_Count)PPG_TOKEN_MISC(p).state);
+   PPG_I PPG_LOG("\tflgs: %d\n", (PPG_Count)PPG_TOKEN_MISC(p).flags);
+   PPG_I PPG_LOG("\ta.st: %d\n", (PPG_Count)PPG_TOKEN_MISC(p).action_state);
    PPG_I PPG_LOG("\ta.flgs: %d\n", (PPG_Count)p->misc.action_flags);
    PPG_I PPG_LOG("\ta.u_f: 0x%" PRIXPTR "\n", (uintptr_t)p->action.callback.func);
    PPG_I PPG_LOG("\ta.u_d: 0x%" PRIXPTR "\n", (uintptr_t)p->action.callback.user_data);
-   PPG_I PPG_LOG("\tst: %d\n", (PPG_Count)p->misc.state);
+   PPG_I PPG_LOG("\tst: %d\n", (PPG_Count)PPG_TOKEN_MISC(p).state);
    PPG_I PPG_LOG("\tlyr: %d\n", p->layer);
    PPG_I PPG_LOG("\tcldr: 0x%" PRIXPTR "\n", (uintptr_t)p->children);
 }
@@ -239,8 +469,8 @@ bool ppg_token_check_initialized(PPG_Token__ *token)
 {
    bool assertion_failed = false;
    
-   PPG_ASSERT_WARN(token->misc.state == PPG_Token_Initialized);
-   PPG_ASSERT_WARN(token->misc.action_state == PPG_Action_Disabled);
+   PPG_ASSERT_WARN(PPG_TOKEN_MISC(token).state == PPG_Token_Initialized);
+   PPG_ASSERT_WARN(PPG_TOKEN_MISC(token).action_state == PPG_Action_Disabled);
 /*   
 #if PPG_PRINT_SELF_ENABLED
    if(assertion_failed) {
@@ -364,6 +594,7 @@ PPG_Token__ *ppg_token_new(PPG_Token__ *token) {
     token->action.callback.func = NULL;
     token->action.callback.user_data = NULL;
     token->layer = 0;
+    token->id = PPG_TOKEN_ID_INVALID;
     
     return token;
 }
@@ -18,9 +18,11 @@
 #define PPG_TOKEN_DETAIL_H
 
 #include "ppg_token.h"
+#include "ppg_allocator.h"
 #include "ppg_event.h"
 #include "ppg_action.h"
 #include "ppg_layer.h"
+#include "ppg_input.h"
 #include "ppg_settings.h"
 #include "ppg_debug.h"
 #include "detail/ppg_compression_detail.h"
@@ -43,6 +45,23 @@ typedef bool (*PPG_Token_Equals_Fun)(struct PPG_TokenStruct *p1, struct PPG_Toke
 
 typedef PPG_Count (*PPG_Token_Precedence_Fun)(struct PPG_TokenStruct *token);
 
+/** @returns The inputs whose activation the token is able to consume
+ *           as the first event after it has been reset. The number of
+ *           inputs is returned via n_inputs. Tokens that do not provide this
+ *           method are considered to be able to consume any input.
+ */
+typedef PPG_Input_Id *(*PPG_Token_Entry_Inputs_Fun)(struct PPG_TokenStruct *token,
+                                                    PPG_Count *n_inputs);
+
+/** @returns All inputs whose activation or deactivation the token is 
+ *           able to consume. The number of inputs is returned via n_inputs. 
+ *           Tokens that do not provide this method are considered to 
+ *           be able to consume any input. Tokens that provide it must 
+ *           become invalid on the activation of any other input.
+ */
+typedef PPG_Input_Id *(*PPG_Token_Inputs_Fun)(struct PPG_TokenStruct *token,
+                                              PPG_Count *n_inputs);
+
 typedef size_t (*PPG_Token_Dynamic_Size_Requirement_Fun)(struct PPG_TokenStruct *p);
 
 typedef char *(*PPG_Token_Placement_Clone_Fun)(struct PPG_TokenStruct *p,
@@ -64,6 +83,15 @@ typedef void (*PPG_Token_Addresses_To_Absolute)(
                                              void *begin_of_buffer
 );
 
+/** @returns The number of bytes of per context matching state that the 
+ *           token requires. The state is stored at the given offset 
+ *           in the token data block of a context. Tokens that do not 
+ *           provide this method do not require any state beyond their
+ *           misc bits.
+ */
+typedef size_t (*PPG_Token_Layout_State_Fun)(struct PPG_TokenStruct *p,
+                                             size_t offset);
+
 #if PPG_PRINT_SELF_ENABLED
 typedef void (*PPG_Token_Print_Self_Fun)(struct PPG_TokenStruct *p, PPG_Count indent, bool recurse);
 #endif
@@ -89,6 +117,12 @@ typedef struct {
    PPG_Token_Precedence_Fun
                            token_precedence;
                            
+   PPG_Token_Entry_Inputs_Fun
+                           entry_inputs;
+                           
+   PPG_Token_Inputs_Fun
+                           inputs;
+                           
    PPG_Token_Dynamic_Size_Requirement_Fun
                            dynamic_size;
                            
@@ -104,6 +138,9 @@ typedef struct {
    PPG_Token_Addresses_To_Absolute   
                            addresses_to_absolute;
                            
+   PPG_Token_Layout_State_Fun
+                           layout_state;
+                           
    #if PPG_PRINT_SELF_ENABLED
    PPG_Token_Print_Self_Fun
                            print_self;
@@ -147,21 +184,45 @@ enum {
 };
 
 typedef struct PPG_TokenStruct {
-
+   
+   // The members that are accessed while matching come first 
+   // to make them share as few cache lines as possible. 
+   // Members that are only needed during tree construction or when 
+   // actions are triggered are placed at the end of the struct.
+   //
    PPG_Token_Vtable *vtable;
    
    struct PPG_TokenStruct *parent;
    
+   // After compilation of the pattern tree, the children arrays 
+   // (the pointers, not the child tokens themselves) of all tokens 
+   // are stored contiguously in breadth first order,
+   // see ppg_token_compact_children.
+   //
    struct PPG_TokenStruct **children;
    
-   PPG_Count n_allocated_children;
    PPG_Count n_children;
    
-   PPG_Action action;
+   // The token's breadth first index, assigned
+   // during compilation of the pattern tree
+   //
+   PPG_Token_Id id;
    
+   // The template of the token's misc bits. While matching, 
+   // every context works on its own copy, see PPG_TOKEN_MISC.
+   //
    PPG_Misc_Bits misc;
    
    PPG_Layer layer;
+   
+   // The number of children the children array has been allocated for.
+   // Zero for a non-empty children array means that the token does not own 
+   // the array, e.g. because it is part of the compacted children 
+   // block of a context.
+   //
+   PPG_Count n_allocated_children;
+   
+   PPG_Action action;
     
 } PPG_Token__;
 
@@ -181,6 +242,75 @@ void ppg_token_store_action(PPG_Token__ *token,
 
 void ppg_token_reset_control_state(   PPG_Token__ *token);
 
+enum {
+   PPG_Completion_Never = 0, ///< An interior token without action
+   PPG_Completion_Always, ///< A leaf token
+   PPG_Completion_By_Layer ///< An interior token with action
+};
+
+// Tells if a match of a token completes a pattern. This is the case 
+// for leaf tokens and for tokens with action whose subtree cannot grow
+// because none of their children can be entered on the current layer.
+// The layer bounds of the children are determined during compilation 
+// of the pattern tree. children_lower_layer is the lowest layer tag 
+// of all children that have a lower layer bound (-1 if there is none). 
+// children_upper_layer is the lowest negative layer tag of all
+// children that have an upper layer bound (0 if there is none).
+//
+typedef struct {
+   PPG_Layer children_lower_layer;
+   PPG_Layer children_upper_layer;
+   uint8_t type;
+} PPG_Completion_Mark;
+
+// The completion marks of all tokens of a pattern tree, 
+// indexed by token id
+//
+typedef struct {
+   PPG_Completion_Mark *marks;
+   PPG_Token_Id n_tokens;
+} PPG_Completion_Marks;
+
+void ppg_token_completion_marks_init(PPG_Completion_Marks *completion_marks);
+
+// Determines the completion marks of all tokens of a tree. 
+// The token ids must have been assigned before.
+//
+void ppg_token_compile_completion_marks(PPG_Completion_Marks *completion_marks,
+                                        PPG_Token__ *root,
+                                        PPG_Token_Id n_tokens,
+                                        PPG_Allocator *allocator);
+
+void ppg_token_free_completion_marks(PPG_Completion_Marks *completion_marks,
+                                     PPG_Allocator *allocator);
+
+// Returns true if a match of the token completes the pattern
+// on the given layer
+//
+bool ppg_token_completes_on_layer(PPG_Completion_Marks *completion_marks,
+                                  PPG_Token__ *token,
+                                  PPG_Layer layer);
+
+// Moves the children arrays of all tokens of a tree to a single
+// contiguous block in breadth first order. Children arrays that are
+// owned by tokens are freed. Returns the block that must be freed 
+// after the tree has been destroyed or NULL if the tree has no children.
+//
+// Only the arrays of child pointers are packed. The tokens themselves
+// stay where they have been allocated, so the data of siblings is not 
+// necessarily adjacent in memory. Scanning the children of a token 
+// touches one contiguous pointer range but still dereferences 
+// every child separately.
+//
+PPG_Token__ **ppg_token_compact_children(PPG_Token__ *root,
+                                         PPG_Allocator *allocator);
+
+// Assigns breadth first indices to all tokens of a tree
+// and returns the number of tokens
+//
+PPG_Token_Id ppg_token_assign_ids(PPG_Token__ *root,
+                                  PPG_Allocator *allocator);
+
 PPG_Token__ *ppg_token_alloc(void);
 
 PPG_Token__ *ppg_token_new(PPG_Token__ *token);
@@ -0,0 +1,137 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_TOKEN_DISPATCH_DETAIL_H
+#define PPG_TOKEN_DISPATCH_DETAIL_H
+
+#include "detail/ppg_token_detail.h"
+#include "detail/ppg_note_detail.h"
+#include "detail/ppg_chord_detail.h"
+#include "detail/ppg_cluster_detail.h"
+#include "detail/ppg_sequence_detail.h"
+#include "detail/ppg_token_precedence_detail.h"
+
+// The methods that are called while matching. If PPG_DEVIRTUALIZE_TOKENS 
+// is enabled, the built-in token types are identified by their 
+// vtable and their methods are called directly. Only user defined token
+// types are dispatched through their vtable.
+
+#if PPG_DEVIRTUALIZE_TOKENS
+
+inline
+static bool ppg_token_match_event(PPG_Token__ *token,
+                                  PPG_Event *event,
+                                  bool modify_only_if_consuming)
+{
+   if(token->vtable == &ppg_note_vtable) {
+      return ppg_note_match_event((PPG_Note*)token, 
+                                  event, 
+                                  modify_only_if_consuming);
+   }
+   else if(token->vtable == &ppg_chord_vtable) {
+      return ppg_chord_match_event((PPG_Chord*)token, 
+                                   event, 
+                                   modify_only_if_consuming);
+   }
+   else if(token->vtable == &ppg_sequence_vtable) {
+      return ppg_sequence_match_event((PPG_Sequence*)token, 
+                                      event, 
+                                      modify_only_if_consuming);
+   }
+   else if(token->vtable == &ppg_cluster_vtable) {
+      return ppg_cluster_match_event((PPG_Cluster*)token, 
+                                     event, 
+                                     modify_only_if_consuming);
+   }
+   
+   return token->vtable->match_event(token, 
+                                     event, 
+                                     modify_only_if_consuming);
+}
+
+inline
+static void ppg_token_reset(PPG_Token__ *token)
+{
+   if(token->vtable == &ppg_note_vtable) {
+      ppg_note_reset((PPG_Note*)token);
+   }
+   else if(token->vtable == &ppg_chord_vtable) {
+      ppg_aggregate_reset((PPG_Aggregate*)token);
+   }
+   else if(token->vtable == &ppg_sequence_vtable) {
+      ppg_sequence_reset((PPG_Sequence*)token);
+   }
+   else if(token->vtable == &ppg_cluster_vtable) {
+      ppg_cluster_reset((PPG_Cluster*)token);
+   }
+   else if(token->vtable == &ppg_token_vtable) {
+      ppg_token_reset_control_state(token);
+   }
+   else {
+      token->vtable->reset(token);
+   }
+}
+
+// Returns zero for tokens that do not define a precedence
+//
+inline
+static PPG_Count ppg_token_precedence(PPG_Token__ *token)
+{
+   if(token->vtable == &ppg_note_vtable) {
+      return ppg_note_token_precedence(token);
+   }
+   else if(token->vtable == &ppg_chord_vtable) {
+      return PPG_Token_Precedence_Chord;
+   }
+   else if(token->vtable == &ppg_sequence_vtable) {
+      return PPG_Token_Precedence_Sequence;
+   }
+   else if(token->vtable == &ppg_cluster_vtable) {
+      return PPG_Token_Precedence_Cluster;
+   }
+   
+   return (token->vtable->token_precedence) ?
+               token->vtable->token_precedence(token) : 0;
+}
+
+#else
+
+inline
+static bool ppg_token_match_event(PPG_Token__ *token,
+                                  PPG_Event *event,
+                                  bool modify_only_if_consuming)
+{
+   return token->vtable->match_event(token, 
+                                     event, 
+                                     modify_only_if_consuming);
+}
+
+inline
+static void ppg_token_reset(PPG_Token__ *token)
+{
+   token->vtable->reset(token);
+}
+
+inline
+static PPG_Count ppg_token_precedence(PPG_Token__ *token)
+{
+   return (token->vtable->token_precedence) ?
+               token->vtable->token_precedence(token) : 0;
+}
+
+#endif
+
+#endif
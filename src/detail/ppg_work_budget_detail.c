@@ -0,0 +1,128 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "detail/ppg_work_budget_detail.h"
+#include "detail/ppg_malloc_detail.h"
+#include "ppg_debug.h"
+
+void ppg_work_budget_init(PPG_Work_Budget *budget)
+{
+   budget->n_steps = 0;
+   budget->n_steps_left = 0;
+   budget->pending = false;
+   budget->timeout_pending = false;
+   budget->deferred = NULL;
+   budget->first_deferred = 0;
+   budget->n_deferred = 0;
+   budget->deferred_mask = 0;
+}
+
+void ppg_work_budget_set(PPG_Work_Budget *budget,
+                         size_t n_steps,
+                         PPG_Allocator *allocator)
+{
+   budget->n_steps = n_steps;
+   
+   if(n_steps == 0) { return; }
+   
+   // Unless a capacity was set explicitly, the ring is 
+   // allocated with a default capacity when a budget is set for 
+   // the first time
+   //
+   if(!budget->deferred) {
+      ppg_work_budget_set_deferred_capacity(budget, PPG_MAX_EVENTS, allocator);
+   }
+}
+
+void ppg_work_budget_set_deferred_capacity(PPG_Work_Budget *budget,
+                                           size_t n_events,
+                                           PPG_Allocator *allocator)
+{
+   // Events that are already deferred are never dropped
+   //
+   if(n_events < budget->n_deferred) {
+      n_events = budget->n_deferred;
+   }
+   
+   size_t new_capacity = 1;
+   
+   while(new_capacity < n_events) {
+      new_capacity *= 2;
+   }
+   
+   if(new_capacity == ppg_work_budget_get_deferred_capacity(budget)) { 
+      return; 
+   }
+   
+   PPG_Event *deferred 
+      = (PPG_Event *)ppg_allocator_malloc(allocator, 
+                                          new_capacity*sizeof(PPG_Event));
+   
+   // Deferred events keep their order and start at 
+   // the beginning of the new storage
+   //
+   for(size_t i = 0; i < budget->n_deferred; ++i) {
+      deferred[i] 
+         = budget->deferred[(budget->first_deferred + i) 
+                                 & budget->deferred_mask];
+   }
+   
+   ppg_allocator_free(allocator, budget->deferred);
+   
+   budget->deferred = deferred;
+   budget->first_deferred = 0;
+   budget->deferred_mask = new_capacity - 1;
+}
+
+void ppg_work_budget_free(PPG_Work_Budget *budget,
+                          PPG_Allocator *allocator)
+{
+   ppg_allocator_free(allocator, budget->deferred);
+   
+   ppg_work_budget_init(budget);
+}
+
+bool ppg_work_budget_defer(PPG_Work_Budget *budget, PPG_Event *event)
+{
+   if(budget->n_deferred == ppg_work_budget_get_deferred_capacity(budget)) {
+      return false; 
+   }
+   
+   size_t pos = budget->first_deferred + budget->n_deferred;
+   
+   budget->deferred[pos & budget->deferred_mask] = *event;
+   
+   ++budget->n_deferred;
+   
+   return true;
+}
+
+PPG_Event *ppg_work_budget_peek(PPG_Work_Budget *budget)
+{
+   if(budget->n_deferred == 0) { return NULL; }
+   
+   return &budget->deferred[budget->first_deferred & budget->deferred_mask];
+}
+
+void ppg_work_budget_pop(PPG_Work_Budget *budget)
+{
+   PPG_ASSERT(budget->n_deferred > 0);
+   
+   ++budget->first_deferred;
+   
+   --budget->n_deferred;
+}
@@ -0,0 +1,123 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PPG_WORK_BUDGET_DETAIL_H
+#define PPG_WORK_BUDGET_DETAIL_H
+
+#include "ppg_allocator.h"
+#include "ppg_event.h"
+#include "ppg_settings.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Limits the number of pattern matching steps that are performed
+// by a single call to one of the event processing functions. 
+// A step is the check of a single token (or of all parallel threads)
+// against an event or the reversion to another branch option. 
+// Work that exceeds the budget remains pending and is resumed 
+// by the next call. Events that arrive while work is pending
+// are deferred until all previous work is done.
+//
+typedef struct {
+   size_t n_steps; ///< The number of steps per call, zero means unlimited
+   size_t n_steps_left; ///< The steps left for the current call
+   
+   bool pending; ///< Pattern matching stopped before all events were processed
+   bool timeout_pending; ///< A timeout is processed but not yet concluded
+   
+   // Ring of events that await processing. Its capacity is a power 
+   // of two. The free running position of the oldest event is mapped 
+   // to a storage index by masking.
+   //
+   PPG_Event *deferred;
+   size_t first_deferred; ///< The position of the oldest deferred event
+   size_t n_deferred; ///< The number of deferred events
+   size_t deferred_mask; ///< The capacity of the ring minus one
+} PPG_Work_Budget;
+
+void ppg_work_budget_init(PPG_Work_Budget *budget);
+
+// Sets the number of steps per call. The ring of deferred events 
+// is allocated when a budget is set for the first time.
+//
+void ppg_work_budget_set(PPG_Work_Budget *budget,
+                         size_t n_steps,
+                         PPG_Allocator *allocator);
+
+void ppg_work_budget_free(PPG_Work_Budget *budget,
+                          PPG_Allocator *allocator);
+
+inline
+static size_t ppg_work_budget_get_deferred_capacity(PPG_Work_Budget *budget)
+{
+   return (budget->deferred) ? budget->deferred_mask + 1 : 0;
+}
+
+// Resizes the ring of deferred events to hold the given number
+// of events. The capacity is rounded up to the next power of two. 
+// It never drops below the number of events that are currently deferred.
+//
+void ppg_work_budget_set_deferred_capacity(PPG_Work_Budget *budget,
+                                           size_t n_events,
+                                           PPG_Allocator *allocator);
+
+inline
+static void ppg_work_budget_refill(PPG_Work_Budget *budget)
+{
+   budget->n_steps_left = budget->n_steps;
+}
+
+// Returns false and marks work as pending if the budget 
+// of the current call is exhausted
+//
+inline
+static bool ppg_work_budget_consume(PPG_Work_Budget *budget)
+{
+   if(budget->n_steps == 0) { return true; }
+   
+   if(budget->n_steps_left == 0) {
+      budget->pending = true;
+      return false;
+   }
+   
+   --budget->n_steps_left;
+   
+   return true;
+}
+
+// Returns true if there is pending work or there are deferred 
+// events. New events must then be deferred to preserve their order.
+//
+inline
+static bool ppg_work_budget_busy(PPG_Work_Budget *budget)
+{
+   return budget->pending || (budget->n_deferred > 0);
+}
+
+// Appends an event to the ring of deferred events. Returns false
+// if the ring is full. The event is then not stored.
+//
+bool ppg_work_budget_defer(PPG_Work_Budget *budget, PPG_Event *event);
+
+// Returns the oldest deferred event or NULL if there is none
+//
+PPG_Event *ppg_work_budget_peek(PPG_Work_Budget *budget);
+
+void ppg_work_budget_pop(PPG_Work_Budget *budget);
+
+#endif
@@ -20,6 +20,9 @@
 
 #include "ppg_action.h"
 #include "ppg_action_flags.h"
+#include "ppg_action_worker.h"
+#include "ppg_allocator.h"
+#include "ppg_arena.h"
 #include "ppg_chord.h"
 #include "ppg_cluster.h"
 #include "ppg_compression.h"
@@ -28,6 +31,7 @@
 #include "ppg_event.h"
 #include "ppg_event_buffer.h"
 #include "ppg_global.h"
+#include "ppg_ingress_queue.h"
 #include "ppg_input.h"
 #include "ppg_layer.h"
 #include "ppg_leader_sequences.h"
@@ -37,9 +41,11 @@
 #include "ppg_signal_callback.h"
 #include "ppg_signals.h"
 #include "ppg_statistics.h"
+#include "ppg_stream_set.h"
 #include "ppg_tap_dance.h"
 #include "ppg_time.h"
 #include "ppg_timeout.h"
+#include "ppg_timer_wheel.h"
 #include "ppg_token.h"
 
 #endif
@@ -63,6 +63,28 @@ typedef struct {
    PPG_Action_Callback callback; ///< The user callback that represents that action
 } PPG_Action;
 
+/** @brief Function type of action dispatchers
+ * 
+ * A dispatcher receives the actions that are triggered by pattern matching
+ * instead of them being called directly, e.g. to execute them 
+ * asynchronously.
+ * 
+ * @param callback The action callback
+ * @param activation_flags The activation flags to pass to the callback
+ * @param user_data The user data of the dispatcher
+ */
+typedef void (*PPG_Action_Dispatch_Fun)(PPG_Action_Callback callback,
+                                        PPG_Count activation_flags,
+                                        void *user_data);
+
+/** @brief The PPG_Action_Dispatcher struct groups dispatcher information
+ *  in an object oriented fashion (functor).
+ */
+typedef struct {
+   PPG_Action_Dispatch_Fun func; ///< The dispatch function
+   void *   user_data; ///< Optional user data that is passed to the dispatch function
+} PPG_Action_Dispatcher;
+
 /** @brief Use this macro to simplify specification of action callbacks
  * @param FUNC The callback function pointer
  * @param USER_DATA A pointer to user data or NULL if none is required
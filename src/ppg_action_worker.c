@@ -0,0 +1,413 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg_action_worker.h"
+#include "ppg_debug.h"
+
+#include <stdlib.h>
+
+#if PPG_HAVE_ACTION_WORKER
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Every entry carries a sequence number that tells whether it 
+// is ready to be written by a producer or to be read by the worker
+// (D. Vyukov's bounded queue, see also ppg_ingress_queue.c).
+//
+typedef struct {
+   size_t sequence;
+   PPG_Action_Callback callback;
+   PPG_Count activation_flags;
+} PPG_Action_Worker_Entry;
+
+typedef struct {
+   
+   PPG_Action_Worker_Entry *entries;
+   size_t mask;
+   
+   // Entries are claimed and published by means of atomic 
+   // operations only
+   //
+   size_t enqueue_pos;
+   
+   // Only accessed by the worker thread
+   //
+   size_t dequeue_pos;
+   
+   // Threads only sleep while the queue is empty or full. The flags
+   // tell the other side whether it has to wake them. Setting a flag 
+   // and checking the queue afterwards (and vice versa on the other side)
+   // with sequentially consistent operations ensures that no wakeup 
+   // is lost.
+   //
+   pthread_mutex_t wake_lock;
+   pthread_cond_t not_empty;
+   pthread_cond_t not_full;
+   bool worker_sleeping;
+   size_t n_producers_sleeping;
+   
+   // Threads that flush the worker sleep until the actions
+   // they wait for have been executed
+   //
+   pthread_cond_t executed;
+   size_t n_executed;
+   size_t n_flushing;
+   
+   pthread_t thread;
+   
+} PPG_Action_Worker;
+
+static void ppg_action_worker_wake(PPG_Action_Worker *worker, 
+                                   pthread_cond_t *condition)
+{
+   pthread_mutex_lock(&worker->wake_lock);
+   pthread_cond_broadcast(condition);
+   pthread_mutex_unlock(&worker->wake_lock);
+}
+
+// Returns true if the entry at the given position can be written
+//
+static bool ppg_action_worker_entry_free(PPG_Action_Worker *worker,
+                                         size_t pos)
+{
+   PPG_Action_Worker_Entry *entry = &worker->entries[pos & worker->mask];
+   
+   return __atomic_load_n(&entry->sequence, __ATOMIC_SEQ_CST) == pos;
+}
+
+// Returns true if the entry at the given position can be read
+//
+static bool ppg_action_worker_entry_ready(PPG_Action_Worker *worker,
+                                          size_t pos)
+{
+   PPG_Action_Worker_Entry *entry = &worker->entries[pos & worker->mask];
+   
+   return __atomic_load_n(&entry->sequence, __ATOMIC_SEQ_CST) == pos + 1;
+}
+
+// Claims the entry at the enqueue position. Sleeps while the 
+// queue is full.
+//
+static PPG_Action_Worker_Entry *ppg_action_worker_claim(
+                                          PPG_Action_Worker *worker,
+                                          size_t *pos)
+{
+   *pos = __atomic_load_n(&worker->enqueue_pos, __ATOMIC_RELAXED);
+   
+   while(1) {
+      
+      PPG_Action_Worker_Entry *entry 
+         = &worker->entries[*pos & worker->mask];
+      
+      size_t sequence = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+      
+      intptr_t diff = (intptr_t)sequence - (intptr_t)*pos;
+      
+      if(diff == 0) {
+         
+         // The entry is free, try to claim it
+         //
+         if(__atomic_compare_exchange_n(&worker->enqueue_pos, pos, *pos + 1,
+                                        true, 
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return entry;
+         }
+      }
+      else if(diff < 0) {
+         
+         // The entry has not been read yet, i.e. the queue is full
+         //
+         pthread_mutex_lock(&worker->wake_lock);
+         
+         __atomic_fetch_add(&worker->n_producers_sleeping, 1, 
+                            __ATOMIC_SEQ_CST);
+         
+         while(!ppg_action_worker_entry_free(worker, *pos)) {
+            pthread_cond_wait(&worker->not_full, &worker->wake_lock);
+         }
+         
+         __atomic_fetch_sub(&worker->n_producers_sleeping, 1, 
+                            __ATOMIC_RELAXED);
+         
+         pthread_mutex_unlock(&worker->wake_lock);
+         
+         *pos = __atomic_load_n(&worker->enqueue_pos, __ATOMIC_RELAXED);
+      }
+      else {
+         
+         // Another producer claimed the entry
+         //
+         *pos = __atomic_load_n(&worker->enqueue_pos, __ATOMIC_RELAXED);
+      }
+   }
+}
+
+// An entry without callback function tells the worker to quit
+//
+static void ppg_action_worker_push(PPG_Action_Worker *worker,
+                                   PPG_Action_Callback callback,
+                                   PPG_Count activation_flags)
+{
+   size_t pos;
+   
+   PPG_Action_Worker_Entry *entry = ppg_action_worker_claim(worker, &pos);
+   
+   entry->callback = callback;
+   entry->activation_flags = activation_flags;
+   
+   __atomic_store_n(&entry->sequence, pos + 1, __ATOMIC_SEQ_CST);
+   
+   if(__atomic_load_n(&worker->worker_sleeping, __ATOMIC_SEQ_CST)) {
+      ppg_action_worker_wake(worker, &worker->not_empty);
+   }
+}
+
+static void *ppg_action_worker_run(void *worker__)
+{
+   PPG_Action_Worker *worker = (PPG_Action_Worker *)worker__;
+   
+   while(1) {
+      
+      size_t pos = worker->dequeue_pos;
+      
+      if(!ppg_action_worker_entry_ready(worker, pos)) {
+         
+         pthread_mutex_lock(&worker->wake_lock);
+         
+         __atomic_store_n(&worker->worker_sleeping, true, __ATOMIC_SEQ_CST);
+         
+         while(!ppg_action_worker_entry_ready(worker, pos)) {
+            pthread_cond_wait(&worker->not_empty, &worker->wake_lock);
+         }
+         
+         __atomic_store_n(&worker->worker_sleeping, false, __ATOMIC_RELAXED);
+         
+         pthread_mutex_unlock(&worker->wake_lock);
+      }
+      
+      PPG_Action_Worker_Entry *entry = &worker->entries[pos & worker->mask];
+      
+      PPG_Action_Callback callback = entry->callback;
+      PPG_Count activation_flags = entry->activation_flags;
+      
+      // Release the entry for the next round
+      //
+      __atomic_store_n(&entry->sequence, pos + worker->mask + 1, 
+                       __ATOMIC_SEQ_CST);
+      
+      worker->dequeue_pos = pos + 1;
+      
+      if(__atomic_load_n(&worker->n_producers_sleeping, __ATOMIC_SEQ_CST)) {
+         ppg_action_worker_wake(worker, &worker->not_full);
+      }
+      
+      if(!callback.func) { break; }
+      
+      callback.func(activation_flags, callback.user_data);
+      
+      __atomic_fetch_add(&worker->n_executed, 1, __ATOMIC_SEQ_CST);
+      
+      if(__atomic_load_n(&worker->n_flushing, __ATOMIC_SEQ_CST)) {
+         ppg_action_worker_wake(worker, &worker->executed);
+      }
+   }
+   
+   return NULL;
+}
+
+static void ppg_action_worker_dispatch(PPG_Action_Callback callback,
+                                       PPG_Count activation_flags,
+                                       void *user_data)
+{
+   ppg_action_worker_push((PPG_Action_Worker *)user_data,
+                          callback, 
+                          activation_flags);
+}
+
+// Initializes the synchronization primitives of a worker. 
+// Returns false and releases all primitives that were 
+// already initialized if one of them fails.
+//
+static bool ppg_action_worker_init_sync(PPG_Action_Worker *worker)
+{
+   if(pthread_mutex_init(&worker->wake_lock, NULL) != 0) {
+      return false;
+   }
+   
+   if(pthread_cond_init(&worker->not_empty, NULL) != 0) {
+      pthread_mutex_destroy(&worker->wake_lock);
+      return false;
+   }
+   
+   if(pthread_cond_init(&worker->not_full, NULL) != 0) {
+      pthread_cond_destroy(&worker->not_empty);
+      pthread_mutex_destroy(&worker->wake_lock);
+      return false;
+   }
+   
+   if(pthread_cond_init(&worker->executed, NULL) != 0) {
+      pthread_cond_destroy(&worker->not_full);
+      pthread_cond_destroy(&worker->not_empty);
+      pthread_mutex_destroy(&worker->wake_lock);
+      return false;
+   }
+   
+   return true;
+}
+
+static void ppg_action_worker_destroy_sync(PPG_Action_Worker *worker)
+{
+   pthread_cond_destroy(&worker->executed);
+   pthread_cond_destroy(&worker->not_full);
+   pthread_cond_destroy(&worker->not_empty);
+   pthread_mutex_destroy(&worker->wake_lock);
+}
+
+void* ppg_action_worker_create(size_t capacity)
+{
+   // One additional entry for the quit message
+   //
+   size_t n_entries = 2;
+   
+   while(n_entries < capacity + 1) {
+      
+      if(n_entries > SIZE_MAX/2/sizeof(PPG_Action_Worker_Entry)) {
+         PPG_ERROR("Action worker capacity %lu too large\n", 
+                   (unsigned long)capacity);
+         return NULL;
+      }
+      
+      n_entries <<= 1;
+   }
+   
+   PPG_Action_Worker *worker 
+      = (PPG_Action_Worker *)malloc(sizeof(PPG_Action_Worker));
+      
+   if(!worker) {
+      PPG_ERROR("Failed to allocate action worker\n");
+      return NULL;
+   }
+   
+   worker->entries 
+      = (PPG_Action_Worker_Entry *)malloc(
+                           n_entries*sizeof(PPG_Action_Worker_Entry));
+   
+   if(!worker->entries) {
+      PPG_ERROR("Failed to allocate %lu action worker entries\n",
+                (unsigned long)n_entries);
+      free(worker);
+      return NULL;
+   }
+   
+   for(size_t i = 0; i < n_entries; ++i) {
+      worker->entries[i].sequence = i;
+   }
+   
+   worker->mask = n_entries - 1;
+   worker->enqueue_pos = 0;
+   worker->dequeue_pos = 0;
+   worker->worker_sleeping = false;
+   worker->n_producers_sleeping = 0;
+   worker->n_executed = 0;
+   worker->n_flushing = 0;
+   
+   if(!ppg_action_worker_init_sync(worker)) {
+      
+      PPG_ERROR("Failed to initialize action worker synchronization\n");
+      
+      free(worker->entries);
+      free(worker);
+      
+      return NULL;
+   }
+   
+   if(pthread_create(&worker->thread, NULL, 
+                     ppg_action_worker_run, worker) != 0) {
+      
+      PPG_ERROR("Failed to start action worker thread\n");
+      
+      ppg_action_worker_destroy_sync(worker);
+      free(worker->entries);
+      free(worker);
+      
+      return NULL;
+   }
+   
+   return worker;
+}
+
+void ppg_action_worker_destroy(void *worker)
+{
+   PPG_Action_Worker *worker__ = (PPG_Action_Worker *)worker;
+   
+   ppg_action_worker_push(worker__, 
+                          (PPG_Action_Callback) { 
+                              .func = NULL, 
+                              .user_data = NULL 
+                          },
+                          PPG_Action_Activation_Flags_Empty);
+   
+   pthread_join(worker__->thread, NULL);
+   
+   ppg_action_worker_destroy_sync(worker__);
+   
+   free(worker__->entries);
+   free(worker__);
+}
+
+PPG_Action_Dispatcher ppg_action_worker_get_dispatcher(void *worker)
+{
+   return (PPG_Action_Dispatcher) {
+      .func = ppg_action_worker_dispatch,
+      .user_data = worker
+   };
+}
+
+static bool ppg_action_worker_executed(PPG_Action_Worker *worker,
+                                       size_t n_actions)
+{
+   return __atomic_load_n(&worker->n_executed, __ATOMIC_SEQ_CST) 
+               >= n_actions;
+}
+
+void ppg_action_worker_flush(void *worker)
+{
+   PPG_Action_Worker *worker__ = (PPG_Action_Worker *)worker;
+   
+   // Actions that were claimed but not published yet are waited for
+   // as well
+   //
+   size_t n_pushed 
+      = __atomic_load_n(&worker__->enqueue_pos, __ATOMIC_SEQ_CST);
+   
+   if(ppg_action_worker_executed(worker__, n_pushed)) { return; }
+   
+   pthread_mutex_lock(&worker__->wake_lock);
+   
+   __atomic_fetch_add(&worker__->n_flushing, 1, __ATOMIC_SEQ_CST);
+   
+   while(!ppg_action_worker_executed(worker__, n_pushed)) {
+      pthread_cond_wait(&worker__->executed, &worker__->wake_lock);
+   }
+   
+   __atomic_fetch_sub(&worker__->n_flushing, 1, __ATOMIC_RELAXED);
+   
+   pthread_mutex_unlock(&worker__->wake_lock);
+}
+
+#endif
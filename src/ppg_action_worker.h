@@ -0,0 +1,94 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_ACTION_WORKER_H
+#define PPG_ACTION_WORKER_H
+
+/** @file */
+
+#include "ppg_action.h"
+
+#include <stddef.h>
+
+/** @brief This macro is defined non-zero if action workers are available. 
+ * 
+ * Action workers rely on POSIX threads and the atomic builtins 
+ * of GCC and clang.
+ */
+#ifndef PPG_HAVE_ACTION_WORKER
+#if defined(__unix__) && defined(__GNUC__) && !defined(__AVR__)
+#define PPG_HAVE_ACTION_WORKER 1
+#else
+#define PPG_HAVE_ACTION_WORKER 0
+#endif
+#endif
+
+#if PPG_HAVE_ACTION_WORKER
+
+/* An action worker executes actions on a dedicated thread. Actions
+ * are passed to the worker through a queue so that pattern matching
+ * is not stalled by slow actions. Actions are executed in the
+ * order they were triggered. To execute the actions of several contexts
+ * in parallel, use one worker per context.
+ * 
+ * Actions are enqueued without locks. Threads only block while the queue
+ * is full (pattern matching) or empty (the worker).
+ * 
+ * Actions that are executed by a worker must not call papageno functions
+ * that refer to the current context.
+ */
+
+/** @brief Creates a new action worker and starts its thread
+ * 
+ * @param capacity The maximum number of actions that can be queued.
+ *                 If the queue is full, pattern matching waits
+ *                 until the worker has executed an action.
+ * @returns The newly created worker or NULL if memory, synchronization 
+ *          primitives or the thread could not be obtained
+ */
+void* ppg_action_worker_create(size_t capacity);
+
+/** @brief Executes all queued actions, stops the worker's thread 
+ *         and destroys the worker
+ * 
+ * The worker must not be used by any context any more.
+ * 
+ * @param worker The worker to destroy
+ */
+void ppg_action_worker_destroy(void *worker);
+
+/** @brief Retreives a dispatcher that passes actions to a worker
+ * 
+ * Use ppg_global_set_action_dispatcher to install the dispatcher.
+ * 
+ * @param worker The worker
+ * @returns The dispatcher
+ */
+PPG_Action_Dispatcher ppg_action_worker_get_dispatcher(void *worker);
+
+/** @brief Waits until all actions that were passed to a worker 
+ *         have been executed
+ * 
+ * Must not be called from an action that the worker executes. 
+ * The worker would wait for itself, i.e. deadlock.
+ * 
+ * @param worker The worker
+ */
+void ppg_action_worker_flush(void *worker);
+
+#endif
+
+#endif
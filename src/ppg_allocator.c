@@ -0,0 +1,489 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg_allocator.h"
+#include "detail/ppg_malloc_detail.h"
+#include "detail/ppg_context_detail.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The fixed buffer allocator
+//
+
+typedef struct {
+   char *begin;
+   size_t size;
+   size_t n_used;
+} PPG_Fixed_Buffer;
+
+// Every block is preceded by a header that stores its size 
+// to support resizing
+//
+typedef union {
+   size_t n_bytes;
+   PPG_Max_Align alignment;
+} PPG_Fixed_Buffer_Block_Header;
+
+#define PPG_FB_HEADER(MEMORY) \
+   (((PPG_Fixed_Buffer_Block_Header *)(MEMORY)) - 1)
+
+static bool ppg_fixed_buffer_is_last_block(PPG_Fixed_Buffer *fb, 
+                                           void *memory)
+{
+   return    (char*)memory + PPG_FB_HEADER(memory)->n_bytes
+          == fb->begin + fb->n_used;
+}
+
+static void *ppg_fixed_buffer_alloc(size_t n_bytes, void *user_data)
+{
+   PPG_Fixed_Buffer *fb = (PPG_Fixed_Buffer *)user_data;
+   
+   n_bytes = ppg_align_size(n_bytes);
+   
+   size_t n_required = sizeof(PPG_Fixed_Buffer_Block_Header) + n_bytes;
+   
+   if(fb->size - fb->n_used < n_required) { return NULL; }
+   
+   PPG_Fixed_Buffer_Block_Header *header 
+      = (PPG_Fixed_Buffer_Block_Header *)(fb->begin + fb->n_used);
+      
+   header->n_bytes = n_bytes;
+   
+   fb->n_used += n_required;
+   
+   return (void*)(header + 1);
+}
+
+static void ppg_fixed_buffer_free(void *memory, void *user_data)
+{
+   PPG_Fixed_Buffer *fb = (PPG_Fixed_Buffer *)user_data;
+   
+   // Only the most recently allocated block can be reclaimed
+   //
+   if(!ppg_fixed_buffer_is_last_block(fb, memory)) { return; }
+   
+   fb->n_used -=   sizeof(PPG_Fixed_Buffer_Block_Header) 
+                 + PPG_FB_HEADER(memory)->n_bytes;
+}
+
+static void *ppg_fixed_buffer_realloc(void *memory, 
+                                      size_t n_bytes, 
+                                      void *user_data)
+{
+   if(!memory) {
+      return ppg_fixed_buffer_alloc(n_bytes, user_data);
+   }
+   
+   PPG_Fixed_Buffer *fb = (PPG_Fixed_Buffer *)user_data;
+   
+   size_t n_old_bytes = PPG_FB_HEADER(memory)->n_bytes;
+   
+   n_bytes = ppg_align_size(n_bytes);
+   
+   if(n_bytes <= n_old_bytes) { return memory; }
+   
+   // The most recently allocated block grows in place
+   //
+   if(ppg_fixed_buffer_is_last_block(fb, memory)) {
+      
+      if(fb->size - fb->n_used < n_bytes - n_old_bytes) { return NULL; }
+      
+      fb->n_used += n_bytes - n_old_bytes;
+      PPG_FB_HEADER(memory)->n_bytes = n_bytes;
+      
+      return memory;
+   }
+   
+   void *new_memory = ppg_fixed_buffer_alloc(n_bytes, user_data);
+   
+   if(!new_memory) { return NULL; }
+   
+   memcpy(new_memory, memory, n_old_bytes);
+   
+   return new_memory;
+}
+
+PPG_Allocator ppg_fixed_buffer_allocator(void *buffer, size_t n_bytes)
+{
+   PPG_ASSERT(((uintptr_t)buffer % PPG_Max_Align_Bytes) == 0);
+   PPG_ASSERT(n_bytes >= ppg_align_size(sizeof(PPG_Fixed_Buffer)));
+   
+   size_t header_size = ppg_align_size(sizeof(PPG_Fixed_Buffer));
+   
+   PPG_Fixed_Buffer *fb = (PPG_Fixed_Buffer *)buffer;
+   
+   fb->begin = (char*)buffer + header_size;
+   fb->size = n_bytes - header_size;
+   fb->n_used = 0;
+   
+   return (PPG_Allocator) {
+      .alloc = ppg_fixed_buffer_alloc,
+      .realloc = ppg_fixed_buffer_realloc,
+      .free = ppg_fixed_buffer_free,
+      .user_data = (void*)fb
+   };
+}
+
+size_t ppg_fixed_buffer_allocator_get_n_used(void *buffer)
+{
+   PPG_Fixed_Buffer *fb = (PPG_Fixed_Buffer *)buffer;
+   
+   return (size_t)(fb->begin - (char*)buffer) + fb->n_used;
+}
+
+bool ppg_allocator_is_fixed_buffer(PPG_Allocator *allocator)
+{
+   return allocator->alloc == ppg_fixed_buffer_alloc;
+}
+
+// The measuring allocator
+//
+
+// Every block obtained from the heap is preceded by a header that 
+// stores the block's position in the fixed buffer that is imitated
+//
+typedef union {
+   struct {
+      size_t offset;
+      size_t n_bytes;
+   } info;
+   PPG_Max_Align alignment;
+} PPG_Measuring_Block_Header;
+
+#define PPG_MB_HEADER(MEMORY) \
+   (((PPG_Measuring_Block_Header *)(MEMORY)) - 1)
+
+static bool ppg_measuring_is_last_block(size_t *n_used, void *memory)
+{
+   return    PPG_MB_HEADER(memory)->info.offset 
+           + PPG_MB_HEADER(memory)->info.n_bytes
+          == *n_used;
+}
+
+static void *ppg_measuring_alloc(size_t n_bytes, void *user_data)
+{
+   size_t *n_used = (size_t *)user_data;
+   
+   n_bytes = ppg_align_size(n_bytes);
+   
+   PPG_Measuring_Block_Header *header 
+      = (PPG_Measuring_Block_Header *)malloc(
+                        sizeof(PPG_Measuring_Block_Header) + n_bytes);
+      
+   if(!header) { return NULL; }
+   
+   *n_used += sizeof(PPG_Fixed_Buffer_Block_Header);
+   
+   header->info.offset = *n_used;
+   header->info.n_bytes = n_bytes;
+   
+   *n_used += n_bytes;
+   
+   return (void*)(header + 1);
+}
+
+static void ppg_measuring_free(void *memory, void *user_data)
+{
+   size_t *n_used = (size_t *)user_data;
+   
+   if(!memory) { return; }
+   
+   // Like with a fixed buffer, only the most recently 
+   // allocated block is reclaimed
+   //
+   if(ppg_measuring_is_last_block(n_used, memory)) {
+      *n_used -=   sizeof(PPG_Fixed_Buffer_Block_Header) 
+                 + PPG_MB_HEADER(memory)->info.n_bytes;
+   }
+   
+   free(PPG_MB_HEADER(memory));
+}
+
+static void *ppg_measuring_realloc(void *memory, 
+                                   size_t n_bytes, 
+                                   void *user_data)
+{
+   if(!memory) {
+      return ppg_measuring_alloc(n_bytes, user_data);
+   }
+   
+   size_t *n_used = (size_t *)user_data;
+   
+   size_t n_old_bytes = PPG_MB_HEADER(memory)->info.n_bytes;
+   
+   n_bytes = ppg_align_size(n_bytes);
+   
+   if(n_bytes <= n_old_bytes) { return memory; }
+   
+   // The most recently allocated block grows in place
+   //
+   if(ppg_measuring_is_last_block(n_used, memory)) {
+      
+      PPG_Measuring_Block_Header *header 
+         = (PPG_Measuring_Block_Header *)realloc(PPG_MB_HEADER(memory),
+                        sizeof(PPG_Measuring_Block_Header) + n_bytes);
+         
+      if(!header) { return NULL; }
+      
+      *n_used += n_bytes - n_old_bytes;
+      header->info.n_bytes = n_bytes;
+      
+      return (void*)(header + 1);
+   }
+   
+   void *new_memory = ppg_measuring_alloc(n_bytes, user_data);
+   
+   if(!new_memory) { return NULL; }
+   
+   memcpy(new_memory, memory, n_old_bytes);
+   
+   // The space of the old block remains in use
+   //
+   free(PPG_MB_HEADER(memory));
+   
+   return new_memory;
+}
+
+PPG_Allocator ppg_measuring_allocator(size_t *n_used)
+{
+   *n_used = ppg_align_size(sizeof(PPG_Fixed_Buffer));
+   
+   return (PPG_Allocator) {
+      .alloc = ppg_measuring_alloc,
+      .realloc = ppg_measuring_realloc,
+      .free = ppg_measuring_free,
+      .user_data = (void*)n_used
+   };
+}
+
+// The pool allocator
+//
+
+enum { PPG_Pool_Min_Class_Bytes = 16 };
+enum { PPG_Pool_N_Classes = 9 }; // 16 ... 4096 bytes
+enum { PPG_Pool_Slab_Size = 16384 };
+
+typedef struct PPG_Pool_Slab_Struct {
+   struct PPG_Pool_Slab_Struct *next;
+} PPG_Pool_Slab;
+
+// Every block is preceded by a header that stores its size class.
+// Free blocks are linked through their headers.
+//
+typedef union PPG_Pool_Block_Header_Union {
+   struct {
+      size_t size_class;
+      union PPG_Pool_Block_Header_Union *next_free;
+   } info;
+   PPG_Max_Align alignment;
+} PPG_Pool_Block_Header;
+
+typedef struct {
+   
+   PPG_Allocator backing;
+   
+   PPG_Pool_Block_Header *free_lists[PPG_Pool_N_Classes];
+   
+   PPG_Pool_Slab *slabs;
+   
+   // The unused rest of the most recent slab
+   //
+   char *slab_pos;
+   size_t slab_n_left;
+   
+} PPG_Pool;
+
+static size_t ppg_pool_class_size(size_t size_class)
+{
+   return (size_t)PPG_Pool_Min_Class_Bytes << size_class;
+}
+
+static size_t ppg_pool_get_class(size_t n_bytes)
+{
+   size_t size_class = 0;
+   
+   while(   (size_class < PPG_Pool_N_Classes)
+         && (ppg_pool_class_size(size_class) < n_bytes)) {
+      ++size_class;
+   }
+   
+   return size_class;
+}
+
+static void ppg_pool_add_slab(PPG_Pool *pool, size_t n_bytes)
+{
+   size_t header_size = ppg_align_size(sizeof(PPG_Pool_Slab));
+   
+   PPG_Pool_Slab *slab 
+      = (PPG_Pool_Slab *)ppg_allocator_malloc(&pool->backing, 
+                                              header_size + n_bytes);
+   slab->next = pool->slabs;
+   pool->slabs = slab;
+   
+   pool->slab_pos = (char*)slab + header_size;
+   pool->slab_n_left = n_bytes;
+}
+
+static void *ppg_pool_alloc(size_t n_bytes, void *user_data)
+{
+   PPG_Pool *pool = (PPG_Pool *)user_data;
+   
+   size_t size_class = ppg_pool_get_class(n_bytes);
+   
+   PPG_Pool_Block_Header *header = NULL;
+   
+   if(size_class == PPG_Pool_N_Classes) {
+      
+      // Large blocks are not pooled
+      //
+      header = (PPG_Pool_Block_Header *)ppg_allocator_malloc(&pool->backing,
+                                 sizeof(PPG_Pool_Block_Header) + n_bytes);
+   }
+   else if(pool->free_lists[size_class]) {
+      
+      header = pool->free_lists[size_class];
+      pool->free_lists[size_class] = header->info.next_free;
+   }
+   else {
+      
+      size_t n_required =   sizeof(PPG_Pool_Block_Header) 
+                          + ppg_pool_class_size(size_class);
+      
+      if(pool->slab_n_left < n_required) {
+         ppg_pool_add_slab(pool, PPG_Pool_Slab_Size);
+      }
+      
+      header = (PPG_Pool_Block_Header *)pool->slab_pos;
+      
+      pool->slab_pos += n_required;
+      pool->slab_n_left -= n_required;
+   }
+   
+   header->info.size_class = size_class;
+   
+   return (void*)(header + 1);
+}
+
+static void ppg_pool_free(void *memory, void *user_data)
+{
+   PPG_Pool *pool = (PPG_Pool *)user_data;
+   
+   PPG_Pool_Block_Header *header = ((PPG_Pool_Block_Header *)memory) - 1;
+   
+   if(header->info.size_class == PPG_Pool_N_Classes) {
+      ppg_allocator_free(&pool->backing, (void*)header);
+      return;
+   }
+   
+   header->info.next_free = pool->free_lists[header->info.size_class];
+   pool->free_lists[header->info.size_class] = header;
+}
+
+static void *ppg_pool_realloc(void *memory, size_t n_bytes, void *user_data)
+{
+   if(!memory) {
+      return ppg_pool_alloc(n_bytes, user_data);
+   }
+   
+   PPG_Pool_Block_Header *header = ((PPG_Pool_Block_Header *)memory) - 1;
+   
+   size_t size_class = header->info.size_class;
+   
+   if(   (size_class < PPG_Pool_N_Classes)
+      && (n_bytes <= ppg_pool_class_size(size_class))) {
+      return memory;
+   }
+   
+   PPG_Pool *pool = (PPG_Pool *)user_data;
+   
+   if(size_class == PPG_Pool_N_Classes) {
+      
+      header = (PPG_Pool_Block_Header *)ppg_allocator_realloc(&pool->backing,
+                                 (void*)header,
+                                 sizeof(PPG_Pool_Block_Header) + n_bytes);
+      return (void*)(header + 1);
+   }
+   
+   void *new_memory = ppg_pool_alloc(n_bytes, user_data);
+   
+   memcpy(new_memory, memory, ppg_pool_class_size(size_class));
+   
+   ppg_pool_free(memory, user_data);
+   
+   return new_memory;
+}
+
+void* ppg_pool_allocator_create(PPG_Allocator backing, 
+                                size_t n_bytes_reserved)
+{
+   PPG_Pool *pool 
+      = (PPG_Pool *)ppg_allocator_malloc(&backing, sizeof(PPG_Pool));
+   
+   pool->backing = backing;
+   
+   for(size_t i = 0; i < PPG_Pool_N_Classes; ++i) {
+      pool->free_lists[i] = NULL;
+   }
+   
+   pool->slabs = NULL;
+   pool->slab_pos = NULL;
+   pool->slab_n_left = 0;
+   
+   if(n_bytes_reserved > 0) {
+      
+      ppg_pool_add_slab(pool, ppg_align_size(n_bytes_reserved));
+      
+      // Touch all pages of the reserved memory
+      //
+      memset(pool->slab_pos, 0, pool->slab_n_left);
+   }
+   
+   return pool;
+}
+
+void ppg_pool_allocator_destroy(void *pool)
+{
+   PPG_Pool *pool__ = (PPG_Pool *)pool;
+   
+   PPG_Pool_Slab *slab = pool__->slabs;
+   
+   while(slab) {
+      PPG_Pool_Slab *next = slab->next;
+      ppg_allocator_free(&pool__->backing, (void*)slab);
+      slab = next;
+   }
+   
+   PPG_Allocator backing = pool__->backing;
+   
+   ppg_allocator_free(&backing, pool);
+}
+
+PPG_Allocator ppg_pool_allocator_get_allocator(void *pool)
+{
+   return (PPG_Allocator) {
+      .alloc = ppg_pool_alloc,
+      .realloc = ppg_pool_realloc,
+      .free = ppg_pool_free,
+      .user_data = pool
+   };
+}
+
+PPG_Allocator ppg_global_get_allocator(void)
+{
+   return ppg_context->allocator;
+}
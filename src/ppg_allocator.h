@@ -0,0 +1,126 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_ALLOCATOR_H
+#define PPG_ALLOCATOR_H
+
+/** @file */
+
+#include "ppg_settings.h"
+
+#include <stddef.h>
+
+/** @brief Function type for allocating memory
+ * 
+ * @param n_bytes The number of bytes requested
+ * @param user_data The user data of the allocator
+ * @returns The memory or NULL if the allocator is exhausted
+ */
+typedef void *(*PPG_Allocator_Alloc_Fun)(size_t n_bytes, void *user_data);
+
+/** @brief Function type for resizing memory
+ * 
+ * Like realloc, the content is preserved up to the lesser of the 
+ * old and the new size. Passing a NULL memory pointer is 
+ * equivalent to allocating.
+ * 
+ * @param memory The memory to resize
+ * @param n_bytes The new number of bytes
+ * @param user_data The user data of the allocator
+ * @returns The resized memory or NULL if the allocator is exhausted
+ */
+typedef void *(*PPG_Allocator_Realloc_Fun)(void *memory, 
+                                           size_t n_bytes, 
+                                           void *user_data);
+
+/** @brief Function type for freeing memory
+ * 
+ * @param memory The memory to free
+ * @param user_data The user data of the allocator
+ */
+typedef void (*PPG_Allocator_Free_Fun)(void *memory, void *user_data);
+
+/** @brief An allocator that provides the dynamic memory of a context
+ * 
+ * A zero initialized allocator (alloc == NULL) uses the heap.
+ */
+typedef struct {
+   PPG_Allocator_Alloc_Fun alloc; ///< Allocates memory
+   PPG_Allocator_Realloc_Fun realloc; ///< Resizes memory
+   PPG_Allocator_Free_Fun free; ///< Frees memory
+   void *user_data; ///< Passed to all functions of the allocator
+} PPG_Allocator;
+
+/** @brief Creates an allocator that serves memory from a fixed buffer
+ * 
+ * Memory is handed out from the front of the buffer. Freeing
+ * or resizing memory only reclaims space if it is the most recently
+ * allocated block. The buffer must outlive all users of the allocator.
+ * Some bytes at the front of the buffer are used for bookkeeping.
+ * 
+ * @param buffer The buffer
+ * @param n_bytes The size of the buffer
+ * @returns The allocator
+ */
+PPG_Allocator ppg_fixed_buffer_allocator(void *buffer, size_t n_bytes);
+
+/** @brief Retreives the number of bytes used of a fixed buffer
+ * 
+ * @param buffer A buffer that was passed to ppg_fixed_buffer_allocator
+ * @returns The number of bytes that are in use, including bookkeeping
+ */
+size_t ppg_fixed_buffer_allocator_get_n_used(void *buffer);
+
+/** @brief Creates a pool allocator with free lists of power of two size classes
+ * 
+ * Memory of the pool is obtained from a backing allocator in slabs,
+ * e.g. NUMA local memory. Memory that is freed is kept
+ * in the free list of its size class and reused. Only requests that
+ * exceed the largest size class are forwarded to the backing allocator.
+ * A pool is not thread safe. It must only be used by contexts that
+ * are operated by the same thread.
+ * 
+ * @param backing The allocator that provides the slabs
+ * @param n_bytes_reserved The number of bytes to obtain and to 
+ *                         touch immediately to avoid page faults later on
+ * @returns The pool
+ */
+void* ppg_pool_allocator_create(PPG_Allocator backing, 
+                                size_t n_bytes_reserved);
+
+/** @brief Destroys a pool allocator and returns all slabs to the backing allocator
+ * 
+ * @param pool The pool
+ */
+void ppg_pool_allocator_destroy(void *pool);
+
+/** @brief Retreives the allocator interface of a pool
+ * 
+ * @param pool The pool
+ * @returns The allocator
+ */
+PPG_Allocator ppg_pool_allocator_get_allocator(void *pool);
+
+/** @brief Retreives the allocator of the current context
+ *
+ * Allocators are assigned when contexts are created, see
+ * ppg_context_create_with_allocator.
+ *
+ * @returns The allocator
+ */
+PPG_Allocator ppg_global_get_allocator(void);
+
+#endif
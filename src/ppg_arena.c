@@ -0,0 +1,45 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg_arena.h"
+#include "detail/ppg_context_detail.h"
+#include "detail/ppg_arena_detail.h"
+
+PPG_Arena_Storage ppg_global_set_tree_storage(PPG_Arena_Storage storage)
+{
+   PPG_Arena_Storage previous_storage = ppg_context->tree_arena.storage;
+   
+   ppg_context->tree_arena.storage = storage;
+   
+   return previous_storage;
+}
+
+PPG_Arena_Storage ppg_global_get_tree_storage(void)
+{
+   return ppg_context->tree_arena.storage;
+}
+
+void ppg_global_get_tree_memory_usage(size_t *n_bytes_used,
+                                      size_t *n_bytes_reserved)
+{
+   if(n_bytes_used) {
+      *n_bytes_used = ppg_arena_get_n_used(&ppg_context->tree_arena);
+   }
+   
+   if(n_bytes_reserved) {
+      *n_bytes_reserved = ppg_context->tree_arena.n_reserved;
+   }
+}
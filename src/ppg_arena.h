@@ -0,0 +1,87 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_ARENA_H
+#define PPG_ARENA_H
+
+/** @file */
+
+#include <stddef.h>
+
+/* All memory of a context's pattern tree (tokens, children arrays and
+ * aggregate members) is taken from an arena that is owned by the context.
+ * The arena obtains memory in large chunks from its storage and hands 
+ * it out by advancing a pointer. Memory is only given back to the 
+ * storage when the context is destroyed. This happens
+ * all at once, without traversing the pattern tree.
+ * 
+ * Tokens are taken from the arena of the context that is current 
+ * when they are created, even if they are added to the tree of 
+ * another context. Tokens that are created while no context is current
+ * are never released.
+ */
+
+/** @brief Function type for obtaining a chunk of memory from arena storage
+ * 
+ * @param n_bytes The number of bytes requested
+ * @param user_data The user data of the storage
+ * @returns The memory or NULL if the storage is exhausted
+ */
+typedef void *(*PPG_Arena_Allocate_Fun)(size_t n_bytes, void *user_data);
+
+/** @brief Function type for returning a chunk of memory to arena storage
+ * 
+ * @param memory The memory chunk
+ * @param user_data The user data of the storage
+ */
+typedef void (*PPG_Arena_Release_Fun)(void *memory, void *user_data);
+
+/** @brief The backing storage of an arena
+ * 
+ * If allocate is NULL, chunks are obtained from the allocator 
+ * of the context.
+ */
+typedef struct {
+   PPG_Arena_Allocate_Fun allocate; ///< Obtains a chunk of memory
+   PPG_Arena_Release_Fun release; ///< Returns a chunk of memory (may be NULL)
+   void *user_data; ///< Passed to allocate and release
+} PPG_Arena_Storage;
+
+/** @brief Sets the backing storage of the pattern tree of the current context
+ * 
+ * The storage is used for all chunks that are obtained from now on. 
+ * Chunks obtained before are returned to the storage they came from.
+ *
+ * @param storage The new storage
+ * @returns The previous storage
+ */
+PPG_Arena_Storage ppg_global_set_tree_storage(PPG_Arena_Storage storage);
+
+/** @brief Retreives the backing storage of the pattern tree of the current context
+ *
+ * @returns The current storage
+ */
+PPG_Arena_Storage ppg_global_get_tree_storage(void);
+
+/** @brief Retreives the memory usage of the pattern tree of the current context
+ *
+ * @param n_bytes_used The number of bytes that are handed out to the tree
+ * @param n_bytes_reserved The number of bytes that were obtained from storage
+ */
+void ppg_global_get_tree_memory_usage(size_t *n_bytes_used,
+                                      size_t *n_bytes_reserved);
+
+#endif
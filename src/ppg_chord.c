@@ -24,7 +24,7 @@
 
 typedef PPG_Aggregate PPG_Chord;
 
-static bool ppg_chord_match_event(  
+bool ppg_chord_match_event(  
                                  PPG_Chord *chord,
                                  PPG_Event *event,
                                  bool modify_only_if_consuming) 
@@ -35,6 +35,11 @@ static bool ppg_chord_match_event(
    
    PPG_ASSERT(chord->n_members != 0);
    
+   PPG_Aggregate_State *aggregate_state = ppg_aggregate_get_state(chord);
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(chord, PPG_Aggregate_Member_Active);
+   
    /* Check if the input is part of the current chord 
     */
    for(PPG_Count i = 0; i < chord->n_members; ++i) {
@@ -44,27 +49,27 @@ static bool ppg_chord_match_event(
          input_part_of_chord = true;
          
          if(event->flags & PPG_Event_Active) {
-            if(!ppg_bitfield_get_bit(&chord->member_active, i)) {
-               ppg_bitfield_set_bit(&chord->member_active, i, true);
-               ++chord->n_inputs_active;
+            if(!ppg_bitfield_get_bit(&member_active, i)) {
+               ppg_bitfield_set_bit(&member_active, i, true);
+               ++aggregate_state->n_inputs_active;
             }
          }
          else {
             
-            if(   ((chord->super.misc.flags & PPG_Aggregate_All_Active) == 0)
-               && (chord->super.misc.flags &          
+            if(   ((PPG_TOKEN_MISC(chord).flags & PPG_Aggregate_All_Active) == 0)
+               && (PPG_TOKEN_MISC(chord).flags &          
                         PPG_Chord_Flags_Disallow_Input_Deactivation)) {
                
                if(!modify_only_if_consuming) {
-                  chord->super.misc.state = PPG_Token_Invalid;
+                  PPG_TOKEN_MISC(chord).state = PPG_Token_Invalid;
                }
                
                return false;
             }
             
-            if(ppg_bitfield_get_bit(&chord->member_active, i)) {
-               ppg_bitfield_set_bit(&chord->member_active, i, false);
-               --chord->n_inputs_active;
+            if(ppg_bitfield_get_bit(&member_active, i)) {
+               ppg_bitfield_set_bit(&member_active, i, false);
+               --aggregate_state->n_inputs_active;
             }
             else {
                
@@ -85,7 +90,7 @@ static bool ppg_chord_match_event(
       PPG_LOG("%d: 0x%d = %d\n", 
               i, 
               chord->inputs[i],
-              ppg_bitfield_get_bit(&chord->member_active, i)
+              ppg_bitfield_get_bit(&member_active, i)
       );
    }
 #endif
@@ -94,7 +99,7 @@ static bool ppg_chord_match_event(
       if(event->flags & PPG_Event_Active) {
          
          if(!modify_only_if_consuming) {
-            chord->super.misc.state = PPG_Token_Invalid;
+            PPG_TOKEN_MISC(chord).state = PPG_Token_Invalid;
          }
       }
       
@@ -103,34 +108,34 @@ static bool ppg_chord_match_event(
       return false;
    }
    
-   chord->super.misc.state = PPG_Token_Activation_In_Progress;
+   PPG_TOKEN_MISC(chord).state = PPG_Token_Activation_In_Progress;
    
-   if(chord->n_inputs_active == chord->n_members) {
+   if(aggregate_state->n_inputs_active == chord->n_members) {
       
-      chord->super.misc.flags |= PPG_Aggregate_All_Active;
+      PPG_TOKEN_MISC(chord).flags |= PPG_Aggregate_All_Active;
       
       /* Chord matches
        */
-      chord->super.misc.state = PPG_Token_Matches;
+      PPG_TOKEN_MISC(chord).state = PPG_Token_Matches;
 //       PPG_LOG("C");
    }
-   else if(chord->n_inputs_active == 0) {
+   else if(aggregate_state->n_inputs_active == 0) {
       
-      if(chord->super.misc.flags & PPG_Aggregate_All_Active) {
+      if(PPG_TOKEN_MISC(chord).flags & PPG_Aggregate_All_Active) {
       
-         if(chord->super.misc.flags & PPG_Token_Flags_Pedantic) {
+         if(PPG_TOKEN_MISC(chord).flags & PPG_Token_Flags_Pedantic) {
             /* Chord matches
             */
-            chord->super.misc.state = PPG_Token_Matches;
+            PPG_TOKEN_MISC(chord).state = PPG_Token_Matches;
          }
          else {
-            chord->super.misc.state = PPG_Token_Finalized;
+            PPG_TOKEN_MISC(chord).state = PPG_Token_Finalized;
          }
       }
    }
    else {
-      if(chord->super.misc.flags & PPG_Aggregate_All_Active) {
-         chord->super.misc.state = PPG_Token_Deactivation_In_Progress;
+      if(PPG_TOKEN_MISC(chord).flags & PPG_Aggregate_All_Active) {
+         PPG_TOKEN_MISC(chord).state = PPG_Token_Deactivation_In_Progress;
       }
    }
    
@@ -170,12 +175,15 @@ static void ppg_chord_print_self(PPG_Chord *c, PPG_Count indent, bool recurse)
    PPG_I PPG_LOG("<*** chrd (0x%" PRIXPTR ") ***>\n", (uintptr_t)c);
    ppg_token_print_self_start((PPG_Token__*)c, indent);
    PPG_I PPG_LOG("\tn mem: %d\n", c->n_members);
-   PPG_I PPG_LOG("\tn I actv: %d\n", c->n_inputs_active);
+   PPG_I PPG_LOG("\tn I actv: %d\n", ppg_aggregate_get_state(c)->n_inputs_active);
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(c, PPG_Aggregate_Member_Active);
    
    for(PPG_Count i = 0; i < c->n_members; ++i) {
       PPG_I PPG_LOG("\t\tI: 0x%d, actv: %d\n", 
               c->inputs[i],
-               ppg_bitfield_get_bit(&c->member_active, i));
+               ppg_bitfield_get_bit(&member_active, i));
    }
    ppg_token_print_self_end((PPG_Token__*)c, indent, recurse);
 }
@@ -193,6 +201,10 @@ PPG_Token_Vtable ppg_chord_vtable =
       = (PPG_Token_Equals_Fun) ppg_aggregates_equal,
    .token_precedence
       = (PPG_Token_Precedence_Fun)ppg_chord_token_precedence,
+   .entry_inputs
+      = (PPG_Token_Entry_Inputs_Fun)ppg_aggregate_entry_inputs,
+   .inputs
+      = (PPG_Token_Inputs_Fun)ppg_aggregate_inputs,
    .dynamic_size
       = (PPG_Token_Dynamic_Size_Requirement_Fun)ppg_chord_dynamic_member_size,
    .placement_clone
@@ -202,7 +214,9 @@ PPG_Token_Vtable ppg_chord_vtable =
    .addresses_to_relative
       = (PPG_Token_Addresses_To_Relative)ppg_aggregate_addresses_to_relative,
    .addresses_to_absolute
-      = (PPG_Token_Addresses_To_Absolute)ppg_aggregate_addresses_to_absolute
+      = (PPG_Token_Addresses_To_Absolute)ppg_aggregate_addresses_to_absolute,
+   .layout_state
+      = (PPG_Token_Layout_State_Fun)ppg_aggregate_layout_state
       
    #if PPG_PRINT_SELF_ENABLED
    ,
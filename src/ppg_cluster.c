@@ -23,9 +23,7 @@
 #include "detail/ppg_token_precedence_detail.h"
 #include "detail/ppg_malloc_detail.h"
 
-#include <string.h>
-
-static bool ppg_cluster_match_event(   
+bool ppg_cluster_match_event(   
                                  PPG_Cluster *cluster,
                                  PPG_Event *event,
                                  bool modify_only_if_consuming)
@@ -34,6 +32,16 @@ static bool ppg_cluster_match_event(
    
    PPG_ASSERT(cluster->aggregate.n_members != 0);
    
+   PPG_Aggregate_State *aggregate_state 
+      = ppg_aggregate_get_state(&cluster->aggregate);
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(&cluster->aggregate, 
+                                   PPG_Aggregate_Member_Active);
+   PPG_Bitfield member_active_lasting 
+      = ppg_aggregate_get_bitfield(&cluster->aggregate, 
+                                   PPG_Aggregate_Member_Active_Lasting);
+   
    /* Check it the input is part of the current cluster 
     */
    for(PPG_Count i = 0; i < cluster->aggregate.n_members; ++i) {
@@ -43,21 +51,21 @@ static bool ppg_cluster_match_event(
          input_part_of_cluster = true;
          
          if(event->flags & PPG_Event_Active) {
-            if(!ppg_bitfield_get_bit(&cluster->aggregate.member_active, i)) {
-               ppg_bitfield_set_bit(&cluster->aggregate.member_active, i, true);
-               ++cluster->aggregate.n_inputs_active;
+            if(!ppg_bitfield_get_bit(&member_active, i)) {
+               ppg_bitfield_set_bit(&member_active, i, true);
+               ++aggregate_state->n_inputs_active;
             }
             
-            if(!ppg_bitfield_get_bit(&cluster->member_active_lasting, i)) {
-               ppg_bitfield_set_bit(&cluster->member_active_lasting, i, true);
-               ++cluster->n_lasting;
+            if(!ppg_bitfield_get_bit(&member_active_lasting, i)) {
+               ppg_bitfield_set_bit(&member_active_lasting, i, true);
+               ++aggregate_state->n_lasting;
             }
          }
          else {
             
-            if(cluster->aggregate.super.misc.flags & PPG_Cluster_Flags_Disallow_Input_Deactivation) {
+            if(PPG_TOKEN_MISC(cluster).flags & PPG_Cluster_Flags_Disallow_Input_Deactivation) {
                if(!modify_only_if_consuming) {
-                  cluster->aggregate.super.misc.state = PPG_Token_Invalid;
+                  PPG_TOKEN_MISC(cluster).state = PPG_Token_Invalid;
                }
                return false;
             }
@@ -66,10 +74,10 @@ static bool ppg_cluster_match_event(
              * released inputs here. Every cluster member must be 
              * pressed only once
             */
-            if(ppg_bitfield_get_bit(&cluster->aggregate.member_active, i)) {
+            if(ppg_bitfield_get_bit(&member_active, i)) {
                
-               ppg_bitfield_set_bit(&cluster->aggregate.member_active, i, false);
-               --cluster->aggregate.n_inputs_active;
+               ppg_bitfield_set_bit(&member_active, i, false);
+               --aggregate_state->n_inputs_active;
             }
             else {
                return false;
@@ -85,7 +93,7 @@ static bool ppg_cluster_match_event(
       PPG_LOG("%d: 0x%d = %d\n", 
               i, 
               cluster->aggregate.inputs[i],
-              ppg_bitfield_get_bit(&cluster->aggregate.member_active, i)
+              ppg_bitfield_get_bit(&member_active, i)
       );
    }
    PPG_LOG("Lasting\n"); 
@@ -93,7 +101,7 @@ static bool ppg_cluster_match_event(
       PPG_LOG("%d: 0x%d = %d\n", 
               i, 
               cluster->aggregate.inputs[i],
-              ppg_bitfield_get_bit(&cluster->member_active_lasting, i)
+              ppg_bitfield_get_bit(&member_active_lasting, i)
       );
    }
 #endif
@@ -102,7 +110,7 @@ static bool ppg_cluster_match_event(
       if(event->flags & PPG_Event_Active) {
          
          if(!modify_only_if_consuming) {
-            cluster->aggregate.super.misc.state = PPG_Token_Invalid;
+            PPG_TOKEN_MISC(cluster).state = PPG_Token_Invalid;
          }
       }
       
@@ -111,36 +119,36 @@ static bool ppg_cluster_match_event(
       return false;
    }
    
-   cluster->aggregate.super.misc.state = PPG_Token_Activation_In_Progress;
+   PPG_TOKEN_MISC(cluster).state = PPG_Token_Activation_In_Progress;
    
-   if(   (cluster->aggregate.n_inputs_active == 0)
-      && (cluster->aggregate.super.misc.flags & PPG_Aggregate_All_Active)
+   if(   (aggregate_state->n_inputs_active == 0)
+      && (PPG_TOKEN_MISC(cluster).flags & PPG_Aggregate_All_Active)
    ) {
       
-      if(cluster->aggregate.super.misc.flags & PPG_Aggregate_All_Active) {
+      if(PPG_TOKEN_MISC(cluster).flags & PPG_Aggregate_All_Active) {
          
-         if(cluster->aggregate.super.misc.flags & PPG_Token_Flags_Pedantic) {
+         if(PPG_TOKEN_MISC(cluster).flags & PPG_Token_Flags_Pedantic) {
             /* Cluster matches
             */
-            cluster->aggregate.super.misc.state = PPG_Token_Matches;
+            PPG_TOKEN_MISC(cluster).state = PPG_Token_Matches;
          }
          else {
-            cluster->aggregate.super.misc.state = PPG_Token_Finalized;
+            PPG_TOKEN_MISC(cluster).state = PPG_Token_Finalized;
          }
       }
    }
-   else if(cluster->n_lasting == cluster->aggregate.n_members) {
+   else if(aggregate_state->n_lasting == cluster->aggregate.n_members) {
       
-      cluster->aggregate.super.misc.flags |= PPG_Aggregate_All_Active;
+      PPG_TOKEN_MISC(cluster).flags |= PPG_Aggregate_All_Active;
       
       /* Cluster matches
        */
-      cluster->aggregate.super.misc.state = PPG_Token_Matches;
+      PPG_TOKEN_MISC(cluster).state = PPG_Token_Matches;
 //       PPG_LOG("O");
    }
    else {
-      if(cluster->aggregate.super.misc.flags & PPG_Aggregate_All_Active) {
-         cluster->aggregate.super.misc.state = PPG_Token_Deactivation_In_Progress;
+      if(PPG_TOKEN_MISC(cluster).flags & PPG_Aggregate_All_Active) {
+         PPG_TOKEN_MISC(cluster).state = PPG_Token_Deactivation_In_Progress;
       }
    }
    
@@ -156,9 +164,7 @@ static PPG_Count ppg_cluster_token_precedence(PPG_Token__ *token)
 static size_t ppg_cluster_dynamic_member_size(PPG_Token *token)
 {
    return   sizeof(PPG_Cluster)
-         +  ppg_aggregate_dynamic_member_size((PPG_Aggregate *)token)
-         +  ppg_bitfield_get_num_cells(&((PPG_Cluster *)token)->member_active_lasting)
-               *sizeof(PPG_Bitfield_Storage_Type);
+         +  ppg_aggregate_dynamic_member_size((PPG_Aggregate *)token);
 }
 
 static char *ppg_cluster_placement_clone(PPG_Token__ *token, char *buffer)
@@ -167,49 +173,23 @@ static char *ppg_cluster_placement_clone(PPG_Token__ *token, char *buffer)
    
    *((PPG_Cluster *)buffer) = *cluster;
    
-   PPG_Cluster *clone = (PPG_Cluster *)buffer;
    PPG_Token__ *clone_token = (PPG_Token__ *)buffer;
    
 //    printf("Replacing children pointer %p with %p\n", clone->children, (PPG_Token__ **)(buffer + sizeof(PPG_Cluster)));
    
    clone_token->children = (PPG_Token__ **)(buffer + sizeof(PPG_Cluster));
    
-   buffer = ppg_aggregate_copy_dynamic_members(token, clone_token, buffer + sizeof(PPG_Cluster));
-   
-   size_t n_bytes = ppg_bitfield_get_num_cells(&cluster->member_active_lasting)
-               *sizeof(PPG_Bitfield_Storage_Type);
-   
-   memcpy(buffer, (void*)cluster->member_active_lasting.bitarray, n_bytes);
-   
-   clone->member_active_lasting.bitarray = (PPG_Bitfield_Storage_Type *)buffer;
-   
-   return buffer + n_bytes;
-}
-
-static void ppg_cluster_addresses_to_relative(  PPG_Token__ *token,
-                                       void *begin_of_buffer
-) 
-{
-   ppg_aggregate_addresses_to_relative(token, begin_of_buffer);
-   
-   PPG_Cluster *cluster = (PPG_Cluster *)token;
-   
-   cluster->member_active_lasting.bitarray = (PPG_Bitfield_Storage_Type *)
-                        ((char*)cluster->member_active_lasting.bitarray
-                                 - (char*)begin_of_buffer);
+   return ppg_aggregate_copy_dynamic_members(token, clone_token, buffer + sizeof(PPG_Cluster));
 }
 
-static void ppg_cluster_addresses_to_absolute(  PPG_Token__ *token,
-                                       void *begin_of_buffer
-) 
+static size_t ppg_cluster_layout_state(PPG_Cluster *cluster, size_t offset)
 {
-   ppg_aggregate_addresses_to_absolute(token, begin_of_buffer);
-   
-   PPG_Cluster *cluster = (PPG_Cluster *)token;
-   
-   cluster->member_active_lasting.bitarray = (PPG_Bitfield_Storage_Type *)
-         ((char*)begin_of_buffer
-               + (size_t)cluster->member_active_lasting.bitarray);
+   // Clusters additionally keep track of the members
+   // that were activated at least once
+   //
+   return ppg_aggregate_layout_state_bitfields(&cluster->aggregate, 
+                                               offset, 
+                                               2);
 }
 
 #if PPG_PRINT_SELF_ENABLED
@@ -218,45 +198,47 @@ static void ppg_cluster_print_self(PPG_Cluster *c, PPG_Count indent, bool recurs
    PPG_I PPG_LOG("<*** clstr (0x%" PRIXPTR ") ***>\n", (uintptr_t)c);
    ppg_token_print_self_start((PPG_Token__*)c, indent);
    PPG_I PPG_LOG("\tn mbr: %d\n", c->aggregate.n_members);
-   PPG_I PPG_LOG("\tn I actv: %d\n", c->aggregate.n_inputs_active);
-   PPG_I PPG_LOG("\tn I lastg.: %d\n", c->n_lasting);
+   
+   PPG_Aggregate_State *aggregate_state 
+      = ppg_aggregate_get_state(&c->aggregate);
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(&c->aggregate, 
+                                   PPG_Aggregate_Member_Active);
+   PPG_Bitfield member_active_lasting 
+      = ppg_aggregate_get_bitfield(&c->aggregate, 
+                                   PPG_Aggregate_Member_Active_Lasting);
+   
+   PPG_I PPG_LOG("\tn I actv: %d\n", aggregate_state->n_inputs_active);
+   PPG_I PPG_LOG("\tn I lastg.: %d\n", aggregate_state->n_lasting);
    
    for(PPG_Count i = 0; i < c->aggregate.n_members; ++i) {
       PPG_LOG("\t\tI: 0x%d, actv: %d\n", 
              c->aggregate.inputs[i], 
-                 ppg_bitfield_get_bit(&c->aggregate.member_active, i));
+                 ppg_bitfield_get_bit(&member_active, i));
    }
     
    for(PPG_Count i = 0; i < c->aggregate.n_members; ++i) {
       PPG_LOG("\t\tI: 0x%d, lasting actv: %d\n", 
              c->aggregate.inputs[i], 
-                 ppg_bitfield_get_bit(&c->member_active_lasting, i));
+                 ppg_bitfield_get_bit(&member_active_lasting, i));
    }
    
    ppg_token_print_self_end((PPG_Token__*)c, indent, recurse);
 }
 #endif
 
-static PPG_Cluster *ppg_cluster_destroy(PPG_Cluster *cluster) {
-   
-   ppg_bitfield_destroy(&cluster->member_active_lasting);
-   
-   ppg_aggregate_destroy(&cluster->aggregate);
-   
-   return cluster;
-}
-
-static void ppg_cluster_reset(PPG_Cluster *cluster) 
+void ppg_cluster_reset(PPG_Cluster *cluster) 
 {
    ppg_aggregate_reset(&cluster->aggregate);
-
-   for(PPG_Count i = 0; i < cluster->aggregate.n_members; ++i) {
-      ppg_bitfield_set_bit(&cluster->member_active_lasting,
-                           i,
-                           false);
-   }
    
-   cluster->n_lasting = 0;
+   ppg_aggregate_get_state(&cluster->aggregate)->n_lasting = 0;
+   
+   PPG_Bitfield member_active_lasting 
+      = ppg_aggregate_get_bitfield(&cluster->aggregate, 
+                                   PPG_Aggregate_Member_Active_Lasting);
+
+   ppg_bitfield_clear(&member_active_lasting);
 }
 
 PPG_Token_Vtable ppg_cluster_vtable =
@@ -266,11 +248,15 @@ PPG_Token_Vtable ppg_cluster_vtable =
    .reset 
       = (PPG_Token_Reset_Fun) ppg_cluster_reset,
    .destroy 
-      = (PPG_Token_Destroy_Fun) ppg_cluster_destroy,
+      = (PPG_Token_Destroy_Fun) ppg_aggregate_destroy,
    .equals
       = (PPG_Token_Equals_Fun) ppg_aggregates_equal,
    .token_precedence
       = (PPG_Token_Precedence_Fun)ppg_cluster_token_precedence,
+   .entry_inputs
+      = (PPG_Token_Entry_Inputs_Fun)ppg_aggregate_entry_inputs,
+   .inputs
+      = (PPG_Token_Inputs_Fun)ppg_aggregate_inputs,
    .dynamic_size
       = (PPG_Token_Dynamic_Size_Requirement_Fun)ppg_cluster_dynamic_member_size,
    .placement_clone
@@ -278,9 +264,11 @@ PPG_Token_Vtable ppg_cluster_vtable =
    .register_ptrs_for_compression
       = (PPG_Token_Register_Pointers_For_Compression)ppg_token_register_pointers_for_compression,
    .addresses_to_relative
-      = (PPG_Token_Addresses_To_Relative)ppg_cluster_addresses_to_relative,
+      = (PPG_Token_Addresses_To_Relative)ppg_aggregate_addresses_to_relative,
    .addresses_to_absolute
-      = (PPG_Token_Addresses_To_Absolute)ppg_cluster_addresses_to_absolute
+      = (PPG_Token_Addresses_To_Absolute)ppg_aggregate_addresses_to_absolute,
+   .layout_state
+      = (PPG_Token_Layout_State_Fun)ppg_cluster_layout_state
    #if PPG_PRINT_SELF_ENABLED
    ,
    .print_self
@@ -295,7 +283,7 @@ PPG_Token_Vtable ppg_cluster_vtable =
 };
 
 PPG_Cluster *ppg_cluster_alloc(void) {
-    return (PPG_Cluster*)PPG_MALLOC(sizeof(PPG_Cluster));
+    return (PPG_Cluster*)ppg_tree_malloc(sizeof(PPG_Cluster));
 }
    
 PPG_Token ppg_cluster_create(
@@ -308,13 +296,6 @@ PPG_Token ppg_cluster_create(
     
    cluster->aggregate.super.vtable = &ppg_cluster_vtable;
    
-   ppg_bitfield_init(&cluster->member_active_lasting);
-   ppg_bitfield_resize(&cluster->member_active_lasting,
-                       n_inputs,
-                       false /*drop old bits*/);
-   
-   cluster->n_lasting = 0;
-   
    return ppg_global_initialize_aggregate(&cluster->aggregate, n_inputs, inputs);
 }
 
@@ -18,7 +18,9 @@
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_token_vtable_detail.h"
 #include "detail/ppg_malloc_detail.h"
+#include "detail/ppg_input_detail.h"
 #include "ppg_debug.h"
+#include "ppg_global.h"
 
 #include <stdio.h>
 #include "assert.h"
@@ -320,6 +322,10 @@ void ppg_compression_generate_dynamic_assignment_information(
       ppg_compression_context_register_symbol((void**)&context->event_processor, ccontext);
    }
    
+   if(context->event_span_processor) {
+      ppg_compression_context_register_symbol((void**)&context->event_span_processor, ccontext);
+   }
+   
    if(context->signal_callback.func) {
       ppg_compression_context_register_symbol((void**)&context->signal_callback.func, ccontext);
    }
@@ -433,6 +439,31 @@ void ppg_compression_setup_context(void *context)
                            NULL,
                            (void *)context);
    
+   ppg_context_compile_token_states(the_context);
+   
+   if(the_context->engine == PPG_Engine_Parallel) {
+      ppg_parallel_matcher_reserve(&the_context->parallel_matcher,
+                     the_context->n_tokens,
+                     ppg_event_buffer_get_capacity(&the_context->event_buffer),
+                     &the_context->allocator);
+   }
+   
+   if(the_context->engine == PPG_Engine_Indexed) {
+      ppg_child_index_build(&the_context->child_index, 
+                            the_context->pattern_root,
+                            &the_context->allocator);
+   }
+   
+   ppg_input_collect_masks(&the_context->input_masks, 
+                           the_context->pattern_root,
+                           the_context->n_tokens,
+                           &the_context->allocator);
+   
+   ppg_token_compile_completion_marks(&the_context->completion_marks,
+                                      the_context->pattern_root,
+                                      the_context->n_tokens,
+                                      &the_context->allocator);
+   
 //    printf("properties: %u\n", *((unsigned char*)&the_context->properties));
    
    PPG_ASSERT(the_context->properties.papageno_enabled);
@@ -15,39 +15,140 @@
  */
 
 #include "ppg_context.h"
+#include "ppg_global.h"
+#include "ppg_timeout.h"
+#include "ppg_timer_wheel.h"
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_furcation_detail.h"
+#include "detail/ppg_input_detail.h"
+#include "detail/ppg_timeout_detail.h"
 #include "ppg_debug.h"
 #include "detail/ppg_malloc_detail.h"
 
 #include <stdlib.h>
 
 void* ppg_context_create(void)
+{
+   return ppg_context_create_with_allocator(
+      (PPG_Allocator) { 
+         .alloc = NULL, .realloc = NULL, .free = NULL, .user_data = NULL 
+      }
+   );
+}
+
+void* ppg_context_create_with_allocator(PPG_Allocator allocator)
 {
 //    PPG_LOG("Cr. new cntxt\n");
    
-   PPG_Context *context = (PPG_Context *)PPG_MALLOC(sizeof(PPG_Context));
+   PPG_Context *context 
+      = (PPG_Context *)ppg_allocator_malloc(&allocator, sizeof(PPG_Context));
    
-   ppg_global_initialize_context(context);
+   ppg_global_initialize_context(context, allocator);
    
    return context;
 }
 
+void* ppg_context_create_in_buffer(void *buffer, size_t n_bytes)
+{
+   return ppg_context_create_with_allocator(
+                        ppg_fixed_buffer_allocator(buffer, n_bytes));
+}
+
+size_t ppg_context_get_buffer_usage(void *context)
+{
+   PPG_Allocator *allocator = &((PPG_Context *)context)->allocator;
+   
+   if(!ppg_allocator_is_fixed_buffer(allocator)) { return 0; }
+   
+   return ppg_fixed_buffer_allocator_get_n_used(allocator->user_data);
+}
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+size_t ppg_context_required_bytes(PPG_Context_Setup_Fun setup,
+                                  void *user_data)
+{
+   size_t n_used = 0;
+   
+   void *context 
+      = ppg_context_create_with_allocator(ppg_measuring_allocator(&n_used));
+      
+   void *previous_context = ppg_global_set_current_context(context);
+   
+   setup(user_data);
+   
+   size_t n_required = n_used;
+   
+   ppg_global_set_current_context(previous_context);
+   
+   ppg_context_destroy(context);
+   
+   return n_required;
+}
+
+#endif
+
+void* ppg_context_create_shared(void *context)
+{
+   PPG_Context *shared 
+      = (PPG_Context *)ppg_allocator_malloc(&((PPG_Context *)context)->allocator, 
+                                            sizeof(PPG_Context));
+   
+   ppg_context_initialize_shared(shared, (PPG_Context *)context);
+   
+   return shared;
+}
+
 void ppg_context_destroy(void *context)
 {
    PPG_Context *context__ = (PPG_Context *)context;
    
-   if(!context__->properties.destruction_enabled) { return; }
+   // The context itself is freed by its own allocator
+   //
+   PPG_Allocator allocator = context__->allocator;
    
-   ppg_event_buffer_free(&context__->event_buffer);
-   ppg_furcation_stack_free(&context__->furcation_stack);
-   ppg_active_tokens_free(&context__->active_tokens);
+   if(context__->properties.tree_shared) {
+      
+      ppg_context_finalize_shared(context__);
+      
+      ppg_allocator_free(&allocator, context__);
+      
+      return;
+   }
    
-   ppg_token_destroy(context__->pattern_root);
+   #if !PPG_DISABLE_CONTEXT_SWITCHING
+   ppg_timer_wheel_unregister_context(context__);
+   #endif
    
-   free(context__->pattern_root);
+   // The child index, the parallel matcher, the work budget, the input 
+   // masks, the completion marks and the token states are always 
+   // dynamically allocated, even for contexts that were restored 
+   // from compressed data
+   //
+   ppg_child_index_free(&context__->child_index, &context__->allocator);
+   ppg_parallel_matcher_free(&context__->parallel_matcher, 
+                             &context__->allocator);
+   ppg_work_budget_free(&context__->work_budget, &context__->allocator);
+   ppg_input_free_masks(&context__->input_masks, &context__->allocator);
+   ppg_token_free_completion_marks(&context__->completion_marks, 
+                                   &context__->allocator);
+   ppg_context_free_token_states(context__);
    
-   free(context__);
+   // All tokens that were dynamically allocated live in the tree arena. 
+   // Releasing it frees the whole tree at once.
+   //
+   ppg_arena_free(&context__->tree_arena);
+   
+   if(!context__->properties.destruction_enabled) { return; }
+   
+   ppg_event_buffer_free(&context__->event_buffer, &context__->allocator);
+   ppg_furcation_stack_free(&context__->furcation_stack, 
+                            &context__->allocator);
+   ppg_active_tokens_free(&context__->active_tokens, &context__->allocator);
+   
+   ppg_allocator_free(&context__->allocator, context__->children_block);
+   
+   ppg_allocator_free(&allocator, context__);
 }
 
 #if !PPG_DISABLE_CONTEXT_SWITCHING
@@ -66,4 +167,79 @@ void* ppg_global_get_current_context(void)
    return ppg_context;
 }
 
+bool ppg_global_is_context_thread_local(void)
+{
+   return PPG_HAVE_THREAD_LOCAL_CONTEXT;
+}
+
+// Executes a statement with the given context being the current
+// context of the calling thread. Without thread local storage, 
+// this is the current context of all threads 
+// (see ppg_global_is_context_thread_local).
+//
+#define PPG_CTX_CALL(CONTEXT, ...) \
+   PPG_Context *old_context = ppg_context; \
+   ppg_context = (PPG_Context *)(CONTEXT); \
+   __VA_ARGS__; \
+   ppg_context = old_context;
+
+void ppg_ctx_event_process(void *context, PPG_Event *event)
+{
+   PPG_CTX_CALL(context, ppg_event_process(event))
+}
+
+void ppg_ctx_event_process_batch(void *context, 
+                                 PPG_Event *events, 
+                                 size_t n_events)
+{
+   PPG_CTX_CALL(context, ppg_event_process_batch(events, n_events))
+}
+
+bool ppg_ctx_event_process_pending(void *context)
+{
+   bool pending;
+   
+   PPG_CTX_CALL(context, pending = ppg_event_process_pending())
+   
+   return pending;
+}
+
+bool ppg_ctx_timeout_check(void *context)
+{
+   bool timeout_hit;
+   
+   PPG_CTX_CALL(context, timeout_hit = ppg_timeout_check())
+   
+   return timeout_hit;
+}
+
+bool ppg_ctx_timeout_get_deadline(void *context, PPG_Time *deadline)
+{
+   return ppg_timeout_get_deadline_of((PPG_Context *)context, deadline);
+}
+
+void ppg_ctx_compile(void *context)
+{
+   PPG_CTX_CALL(context, ppg_global_compile())
+}
+
+void ppg_ctx_abort_pattern_matching(void *context)
+{
+   PPG_CTX_CALL(context, ppg_global_abort_pattern_matching())
+}
+
+PPG_Layer ppg_ctx_set_layer(void *context, PPG_Layer layer)
+{
+   PPG_Layer old_layer;
+   
+   PPG_CTX_CALL(context, old_layer = ppg_global_set_layer(layer))
+   
+   return old_layer;
+}
+
+PPG_Layer ppg_ctx_get_layer(void *context)
+{
+   return ((PPG_Context *)context)->layer;
+}
+
 #endif
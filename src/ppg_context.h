@@ -19,12 +19,98 @@
 
 /** @file */
 
+#include "ppg_event.h"
+#include "ppg_layer.h"
+#include "ppg_allocator.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
 /** @brief Creates a new papageno context
  * 
  * @returns The newly created context
  */
 void* ppg_context_create(void);
 
+/** @brief Creates a new papageno context that obtains all its dynamic memory from an allocator
+ *
+ * The context itself, its event buffer, the matching state and the 
+ * pattern tree (unless a tree storage is set, see 
+ * ppg_global_set_tree_storage) are allocated using the allocator.
+ * Contexts that share the pattern tree with the new context use 
+ * the same allocator.
+ *
+ * @param allocator The allocator
+ * @returns The newly created context
+ */
+void* ppg_context_create_with_allocator(PPG_Allocator allocator);
+
+/** @brief Creates a new papageno context that lives entirely in a fixed buffer
+ *
+ * The context, its pattern tree and all matching state are carved from 
+ * the buffer. No heap memory is used by the context.
+ * As the space needed depends on the patterns, it is best determined 
+ * by a dry run: Create the context in a sufficiently large buffer, 
+ * define and compile all patterns and query 
+ * ppg_context_get_buffer_usage. The result can then be used as 
+ * the static buffer size. Running out of buffer space is fatal.
+ * 
+ * Alternatively, use ppg_context_required_bytes.
+ * 
+ * Event buffer and active tokens are sized according to PPG_MAX_EVENTS
+ * and PPG_MAX_ACTIVE_TOKENS. After compilation, all memory that is
+ * needed for pattern matching is reserved. Capacities are fixed 
+ * afterwards. Events that arrive while the event buffer is full 
+ * are dropped and PPG_On_Event_Dropped is signaled. 
+ * Use ppg_global_set_event_buffer_capacity to reserve 
+ * more space in advance.
+ * 
+ * The buffer must be aligned suitably for any type, e.g. 
+ * by declaring it as an array of long long or double.
+ *
+ * @param buffer The buffer
+ * @param n_bytes The size of the buffer
+ * @returns The newly created context
+ */
+void* ppg_context_create_in_buffer(void *buffer, size_t n_bytes);
+
+/** @brief Retreives the number of buffer bytes used by a context
+ *
+ * @param context A context created by ppg_context_create_in_buffer
+ * @returns The number of bytes used, including bookkeeping, or zero if 
+ *          the context does not live in a fixed buffer
+ */
+size_t ppg_context_get_buffer_usage(void *context);
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+/** @brief Function type for setting up a context
+ * 
+ * @param user_data The user data that is passed to ppg_context_required_bytes
+ */
+typedef void (*PPG_Context_Setup_Fun)(void *user_data);
+
+/** @brief Determines the size of the buffer that a context 
+ *         created by ppg_context_create_in_buffer requires
+ * 
+ * The setup function is called with a temporary context being current.
+ * It must define and compile the patterns and apply all settings 
+ * that reserve memory, e.g. the engine, the work budget or the 
+ * capacity of the event buffer, exactly as for the context 
+ * that is later created in the buffer. The memory of the 
+ * temporary context is obtained from the heap, but accounted for 
+ * like that of a context that lives in a buffer. The previously 
+ * current context is restored afterwards.
+ * 
+ * @param setup The setup function
+ * @param user_data Passed to the setup function
+ * @returns The number of bytes required
+ */
+size_t ppg_context_required_bytes(PPG_Context_Setup_Fun setup,
+                                  void *user_data);
+
+#endif
+
 /** @brief Destroys a papageno context
  * 
  * Make sure to unset a context before 
@@ -34,6 +120,23 @@ void* ppg_context_create(void);
  */
 void ppg_context_destroy(void *context);
 
+/** @brief Creates a new papageno context that shares the pattern tree
+ *         of an existing context
+ * 
+ * The pattern tree of the given context must have been compiled. 
+ * The new context works on the same immutable pattern tree but 
+ * has its own matching state, event buffer and settings. 
+ * This allows many matchers to run on a single tree, e.g. one
+ * per input stream.
+ * 
+ * The given context must neither be destroyed nor have its pattern
+ * tree modified or recompiled as long as any shared contexts exist.
+ * 
+ * @param context The context that owns the pattern tree
+ * @returns The newly created context
+ */
+void* ppg_context_create_shared(void *context);
+
 #if !PPG_DISABLE_CONTEXT_SWITCHING
 
 /** @brief Sets a new current context
@@ -49,6 +152,114 @@ void* ppg_global_set_current_context(void *context);
  */
 void* ppg_global_get_current_context(void);
 
+/** @brief Tells whether every thread has its own current context
+ * 
+ * This is the case by default, unless the platform lacks thread local 
+ * storage (e.g. AVR) or Papageno was built without 
+ * PPG_THREAD_LOCAL_CONTEXT (CMake option PAPAGENO_THREAD_LOCAL_CONTEXT).
+ * 
+ * @returns True if the current context is thread local, 
+ *          false if it is shared by all threads
+ */
+bool ppg_global_is_context_thread_local(void);
+
+/* The following functions operate on an explicitly passed context.
+ * The current context of the calling thread is only changed for 
+ * the duration of the call. Calls may be nested, e.g. an action or 
+ * signal callback may process events of another context.
+ * 
+ * Every thread has its own current context (see 
+ * ppg_global_is_context_thread_local). Thus, different threads may 
+ * use different contexts concurrently, including contexts that share 
+ * a pattern tree. A context that is made current by one thread 
+ * is not current for any other thread. Threads that use the global API
+ * must activate a context first. The following limits apply.
+ * 
+ * - A single context must not be used by several threads concurrently.
+ * - The pattern tree of shared contexts must not be modified or 
+ *   recompiled while any of them is in use.
+ * - Callbacks, e.g. actions and signals, run on the thread that 
+ *   processes the events, with the context being current. Actions that 
+ *   are executed by an action worker run without current context.
+ * - Without thread local storage, all threads share the current
+ *   context, and the ppg_ctx_... functions as well as the global API
+ *   must not be called concurrently.
+ */
+
+/** @brief Processes an input event with respect to a given context
+ * 
+ * See ppg_event_process for further information.
+ * 
+ * @param context The context
+ * @param event A pointer to an input event
+ */
+void ppg_ctx_event_process(void *context, PPG_Event *event);
+
+/** @brief Processes a series of input events with respect to a given context
+ * 
+ * See ppg_event_process_batch for further information.
+ * 
+ * @param context The context
+ * @param events An array of input events to process
+ * @param n_events The number of events in the array
+ */
+void ppg_ctx_event_process_batch(void *context, 
+                                 PPG_Event *events, 
+                                 size_t n_events);
+
+/** @brief Continues interrupted pattern matching work of a given context
+ * 
+ * See ppg_event_process_pending for further information.
+ * 
+ * @param context The context
+ * @returns True if there is still work pending
+ */
+bool ppg_ctx_event_process_pending(void *context);
+
+/** @brief Checks if a timeout happened with respect to a given context
+ * 
+ * @param context The context
+ * @returns true if timeout happened, false else
+ */
+bool ppg_ctx_timeout_check(void *context);
+
+/** @brief Retreives the timeout deadline of a given context
+ * 
+ * See ppg_timeout_get_deadline for further information.
+ * 
+ * @param context The context
+ * @param deadline Pointer to the time value to receive the deadline
+ * @returns true if a timeout is pending, false else
+ */
+bool ppg_ctx_timeout_get_deadline(void *context, PPG_Time *deadline);
+
+/** @brief Compiles the pattern tree of a given context
+ * 
+ * @param context The context
+ */
+void ppg_ctx_compile(void *context);
+
+/** @brief Aborts processing of the current pattern of a given context
+ * 
+ * @param context The context
+ */
+void ppg_ctx_abort_pattern_matching(void *context);
+
+/** @brief Sets the current layer of a given context
+ * 
+ * @param context The context
+ * @param layer The new layer
+ * @returns The previously active layer
+ */
+PPG_Layer ppg_ctx_set_layer(void *context, PPG_Layer layer);
+
+/** @brief Retreives the current layer of a given context
+ * 
+ * @param context The context
+ * @returns The current layer
+ */
+PPG_Layer ppg_ctx_get_layer(void *context);
+
 #endif
 
 #endif
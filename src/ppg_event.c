@@ -15,11 +15,17 @@
  */
 
 #include "ppg_event.h"
+#include "detail/ppg_event_detail.h"
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_global_detail.h"
 #include "detail/ppg_pattern_matching_detail.h"
 #include "detail/ppg_signal_detail.h"
+#include "detail/ppg_timeout_detail.h"
+#include "detail/ppg_timer_wheel_detail.h"
+#include "detail/ppg_input_detail.h"
+#include "detail/ppg_event_buffer_detail.h"
 #include "ppg_debug.h"
+#include "ppg_time.h"
 // 
 #include <stdbool.h>
 
@@ -55,29 +61,64 @@ static bool ppg_check_ignore_event(PPG_Event *event)
    return false;
 }
 
-void ppg_event_process(PPG_Event *event)
+// Checks if an event can be passed on without being matched
+//
+static bool ppg_event_check_passthrough(PPG_Event *event)
 {
-   PPG_LOG("ppg_event_process\n");
-   if(!ppg_context->properties.papageno_enabled) {
+   // Events of inputs that are not used by any pattern cannot be
+   // part of a match. While events are stored, such an event must 
+   // still go through pattern matching. It would otherwise overtake 
+   // the stored events. Also, it must fail the current match, 
+   // which may trigger fallback actions.
+   //
+   return   (ppg_context->event_buffer.size == 0)
+         && !ppg_context->current_token
+         && (ppg_context->abort_trigger_input != event->input)
+         && !ppg_input_is_relevant(&ppg_context->input_masks, 
+                                   event->input);
+}
+
+// Processes an event whose time of arrival has already been registered
+//
+static void ppg_event_process_registered(PPG_Event *event)
+{
+   if(ppg_event_check_passthrough(event)) {
+      
+      PPG_LOG("Passing through event\n");
+      
+      if(ppg_context->event_span_processor) {
+         
+         PPG_Event_Span span = {
+            .events = event,
+            .n_events = 1,
+            .n_considered = 0
+         };
+         
+         ppg_context->event_span_processor(&span, 1, NULL);
+      }
+      else if(ppg_context->event_processor) {
+         ppg_context->event_processor(event, NULL);
+      }
+      else {
+         
+         // Without a processor, events can only be flushed by 
+         // the signal handler. It needs the event to be stored.
+         //
+         if(ppg_event_buffer_store_event(event)) {
+            
+            ppg_signal(PPG_On_Flush_Events);
+            
+            ppg_delete_stored_events();
+         }
+      }
       
-      PPG_LOG("ppg disabled\n");
       return;
    }
    
-   PPG_LOG("Input 0x%d, active %d\n", event->input, 
-              event->flags & PPG_Event_Active);
-   
-   ppg_timeout_check();
-   
-   // Register the time of arrival to check for timeout
-   //
-   ppg_context->time_manager.time(&ppg_context->time_last_event);
-   
-   
-//    PPG_LOG("time: %ld\n", ppg_context->time_last_event);
-   
    event = ppg_event_buffer_store_event(event);
    
+   if(!event) { return; }
+   
    // If there are active tokens on the stack,
    // we allow them to consume the event without
    // storing it.
@@ -96,6 +137,220 @@ void ppg_event_process(PPG_Event *event)
    }
 
    ppg_pattern_matching_run();
+}
+
+// Processes an event at a given time of arrival without checking
+// for a timeout
+//
+static void ppg_event_process_registered_at(PPG_Event *event, 
+                                            PPG_Time time)
+{
+   ppg_context->time_last_event = time;
+   
+   ppg_event_process_registered(event);
+}
+
+// Processes an event at a given time of arrival. Returns false if 
+// the event could not be processed because the timeout that
+// the event caused was interrupted.
+//
+static bool ppg_event_process_at(PPG_Event *event, PPG_Time time)
+{
+   ppg_timeout_check_at(time);
+   
+   if(ppg_context->work_budget.pending) { return false; }
+   
+   ppg_event_process_registered_at(event, time);
+   
+   return true;
+}
+
+bool ppg_event_resume_work(void)
+{
+   PPG_Work_Budget *budget = &ppg_context->work_budget;
+   
+   if(budget->pending) {
+      
+      budget->pending = false;
+      
+      ppg_pattern_matching_run();
+      
+      if(budget->pending) { return true; }
+      
+      ppg_timeout_resume();
+      
+      if(budget->pending) { return true; }
+   }
+   
+   PPG_Event *deferred = NULL;
+   
+   while((deferred = ppg_work_budget_peek(budget))) {
+      
+      // Like the remainder of a batch, deferred events are dropped 
+      // if papageno is disabled by an action
+      //
+      if(!ppg_context->properties.papageno_enabled) {
+         
+         PPG_LOG("ppg disabled\n");
+         
+         budget->n_deferred = 0;
+         break;
+      }
+      
+      PPG_Event event = *deferred;
+      
+      // The event remains deferred if it could not be processed
+      //
+      if(!ppg_event_process_at(&event, event.time)) { return true; }
+      
+      ppg_work_budget_pop(budget);
+      
+      if(budget->pending) { return true; }
+   }
+   
+   return false;
+}
+
+// Defers an event whose time member holds its time of arrival 
+// until all pending work is done
+//
+static void ppg_event_defer(PPG_Event *event)
+{
+   PPG_Work_Budget *budget = &ppg_context->work_budget;
+   
+   if(ppg_work_budget_defer(budget, event)) { return; }
+   
+   // Completing the pending work regardless of the budget would 
+   // defeat its purpose. Thus, the event is dropped.
+   //
+   PPG_LOG("Deferred events exhausted, dropping event\n");
+   
+   ppg_signal(PPG_On_Event_Dropped);
+}
+
+void ppg_event_process(PPG_Event *event)
+{
+   PPG_LOG("ppg_event_process\n");
+   if(!ppg_context->properties.papageno_enabled) {
+      
+      PPG_LOG("ppg disabled\n");
+      return;
+   }
+   
+   PPG_LOG("Input 0x%d, active %d\n", event->input, 
+              event->flags & PPG_Event_Active);
+   
+   PPG_Work_Budget *budget = &ppg_context->work_budget;
+   
+   ppg_work_budget_refill(budget);
+   
+   // Work that remains from previous calls is done first 
+   //
+   ppg_event_resume_work();
+   
+   // Register the time of arrival to check for timeout. In event 
+   // time mode, the event already carries it.
+   //
+   PPG_Event registered = *event;
+   
+   if(!ppg_context->properties.event_time_enabled) {
+      ppg_context->time_manager.time(&registered.time);
+   }
+   
+//    PPG_LOG("time: %ld\n", registered.time);
+   
+   if(   ppg_work_budget_busy(budget)
+      || !ppg_event_process_at(&registered, registered.time)) {
+      
+      ppg_event_defer(&registered);
+   }
+   
+   ppg_timer_wheel_on_events_processed();
+}
+
+bool ppg_event_process_pending(void)
+{
+   PPG_Work_Budget *budget = &ppg_context->work_budget;
+   
+   ppg_work_budget_refill(budget);
+   
+   ppg_event_resume_work();
+   
+   ppg_timer_wheel_on_events_processed();
+   
+   return ppg_work_budget_busy(budget);
+}
+
+bool ppg_event_work_pending(void)
+{
+   return ppg_work_budget_busy(&ppg_context->work_budget);
+}
+
+size_t ppg_event_process_until_busy(PPG_Event *events, size_t n_events)
+{
+   PPG_Work_Budget *budget = &ppg_context->work_budget;
+   
+   if(ppg_work_budget_busy(budget)) { return 0; }
+   
+   // With integer time values, the time stamps of subsequent events
+   // are compared inline. The full timeout check only runs for 
+   // events that arrive after the deadline that the previous 
+   // event established.
+   //
+   bool integer_time 
+      =     ppg_context->properties.event_time_enabled
+         || (  ppg_context->time_manager.time_difference 
+            == ppg_monotonic_time_difference);
+   
+   for(size_t i = 0; i < n_events; ++i) {
+      
+      // Actions that are triggered while the events are processed
+      // may disable papageno. The remaining events are dropped.
+      //
+      if(!ppg_context->properties.papageno_enabled) {
+         
+         PPG_LOG("ppg disabled\n");
+         return n_events;
+      }
+      
+      PPG_Event *event = &events[i];
+      
+      // The events carry their own time of arrival. Thus, there is
+      // no need to query the time manager.
+      //
+      if(   integer_time
+         && (  ppg_time_integer_difference(ppg_context->time_last_event,
+                                           event->time)
+            <= ppg_context->event_timeout)) {
+         
+         ppg_event_process_registered_at(event, event->time);
+      }
+      else if(!ppg_event_process_at(event, event->time)) {
+         return i;
+      }
+      
+      if(ppg_work_budget_busy(budget)) { return i + 1; }
+   }
+   
+   return n_events;
+}
+
+void ppg_event_process_batch(PPG_Event *events, size_t n_events)
+{
+   PPG_LOG("ppg_event_process_batch\n");
+   
+   ppg_work_budget_refill(&ppg_context->work_budget);
+   
+   ppg_event_resume_work();
+   
+   size_t n_processed = ppg_event_process_until_busy(events, n_events);
+   
+   // Once the work budget is exhausted, the remaining events 
+   // are deferred
+   //
+   for(size_t i = n_processed; i < n_events; ++i) {
+      ppg_event_defer(&events[i]);
+   }
    
-   return;
+   ppg_timer_wheel_on_events_processed();
 }
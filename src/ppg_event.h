@@ -24,6 +24,9 @@
 #include "ppg_time.h"
 #include "ppg_layer.h"
 
+#include <stddef.h>
+#include <stdbool.h>
+
 /** @brief Flags that are used to tag events
  * 
  * Please note that currently only the flag PPG_Event_Active
@@ -60,10 +63,67 @@ typedef void (*PPG_Event_Processor_Fun)(PPG_Event *event,
                                            void *user_data);
 
 /** @brief This is the main entry function for input event processing.
+ * 
+ * Events of inputs that are not used by any pattern are passed on
+ * right away when no other events are stored. They are neither matched 
+ * nor stored but handed directly to the event span processor 
+ * or the default event processor, see ppg_global_set_default_event_processor. 
+ * If neither is set, they are stored and signaled as PPG_On_Flush_Events 
+ * for the signal handler to flush them. While other events are stored, 
+ * such events are matched like any other event to preserve the order 
+ * of events and to make the current match fail. The set of inputs used 
+ * is determined by ppg_global_compile.
  * 
  * @param event A pointer to an input event to process by papagenop
  * @returns If further input event processing by other input event processors is desired
  */
 void ppg_event_process(PPG_Event *event);
 
+/** @brief Processes a series of input events at once.
+ * 
+ * Other than ppg_event_process, this function does not query the time manager.
+ * Instead, the time member of every event is used as its time of arrival, 
+ * e.g. when replaying recorded input. Timeouts between subsequent events are 
+ * detected based on these time stamps. The time stamps must be non-decreasing
+ * and compatible with the time values returned by the time manager.
+ * 
+ * In event time mode or with monotonic integer time values, the time stamp 
+ * of every event is compared inline with the timeout deadline established 
+ * by its predecessor, and the full timeout check only runs for events that 
+ * pass the deadline. With other time managers, the timeout is checked 
+ * through the time manager for every event.
+ * 
+ * @param events An array of input events to process
+ * @param n_events The number of events in the array
+ */
+void ppg_event_process_batch(PPG_Event *events, size_t n_events);
+
+/** @brief Continues pattern matching work that was interrupted because 
+ *         the work budget was exhausted
+ * 
+ * When a work budget is set (see ppg_global_set_work_budget), 
+ * every call to ppg_event_process, ppg_event_process_batch, 
+ * ppg_timeout_check and this function performs at most the given 
+ * number of pattern matching steps. Work that exceeds the budget 
+ * is resumed exactly where it stopped by the next call. Events that are passed 
+ * while work is pending are deferred and processed in the order of
+ * their arrival once the previous work is done. Timeouts
+ * are not checked while work is pending. If the ring of deferred events
+ * is full (see ppg_global_set_deferred_event_capacity), further events 
+ * are dropped and signaled as PPG_On_Event_Dropped.
+ * 
+ * Call this function repeatedly, e.g. from an idle loop, until it returns false.
+ * 
+ * @returns True if there is still work pending
+ */
+bool ppg_event_process_pending(void);
+
+/** @brief Checks whether pattern matching work is pending
+ * 
+ * See ppg_event_process_pending for further information.
+ * 
+ * @returns True if there is work pending
+ */
+bool ppg_event_work_pending(void);
+
 #endif
@@ -24,16 +24,19 @@ typedef struct {
    void *user_data;
 } PPG_Event_Buffer_Visitor_Adaptor_Data;
 
-static void ppg_event_buffer_visit_adaptor(PPG_Event_Queue_Entry *eqe,
+static void ppg_event_buffer_visit_adaptor(PPG_Event *event,
+                        PPG_Event_Queue_Entry *eqe,
                         void *user_data)
 {
+   PPG_UNUSED(eqe);
+   
    PPG_Event_Buffer_Visitor_Adaptor_Data *adaptor_data
       = (PPG_Event_Buffer_Visitor_Adaptor_Data*)user_data;
       
    PPG_ASSERT(adaptor_data);
    PPG_ASSERT(adaptor_data->fun);
    
-   adaptor_data->fun(&eqe->event, adaptor_data->user_data);
+   adaptor_data->fun(event, adaptor_data->user_data);
 }
 
 uint8_t ppg_event_buffer_iterate(
@@ -53,3 +56,27 @@ uint8_t ppg_event_buffer_iterate(
       &adaptor_data
    );
 }
+
+size_t ppg_event_buffer_iterate_spans(
+                        PPG_Event_Span_Processor_Fun span_processor,
+                        void *user_data)
+{
+   PPG_LOG("ppg_event_buffer_iterate_spans\n")
+   
+   PPG_ASSERT(span_processor);
+   
+   PPG_Event_Buffer *eb = &ppg_context->event_buffer;
+   
+   size_t n_events = eb->size;
+   
+   if(n_events == 0) { return 0; }
+   
+   PPG_Event_Span spans[2];
+   
+   uint8_t n_spans 
+      = ppg_event_buffer_get_spans(eb, eb->start, n_events, spans);
+   
+   span_processor(spans, n_spans, user_data);
+   
+   return n_events;
+}
@@ -19,6 +19,8 @@
 
 #include "ppg_event.h"
 
+#include <stddef.h>
+
 /** @brief Call this function to actively flush any input events that are in cache.
  * 
  * This function is called internally when melodies complete, on abort and on timeout.
@@ -33,4 +35,43 @@ uint8_t ppg_event_buffer_iterate(
                         PPG_Event_Processor_Fun event_processor,
                         void *user_data);
 
+/** @brief A contiguous run of input events that are in cache
+ */
+typedef struct {
+   PPG_Event *events; ///< The first event of the span
+   size_t n_events; ///< The number of events of the span
+   size_t n_considered; ///< The number of events of the span that have the flag PPG_Event_Considered set. If zero, the span can be forwarded as a whole.
+} PPG_Event_Span;
+
+/** @brief The callback type for event span processors
+ * 
+ * @param spans The spans of events in the order of their arrival
+ * @param n_spans The number of spans (one or two)
+ * @param user_data Optional user data
+ */
+typedef void (*PPG_Event_Span_Processor_Fun)(PPG_Event_Span *spans,
+                                             uint8_t n_spans,
+                                             void *user_data);
+
+/** @brief Passes all input events that are in cache to a processor with a single call.
+ * 
+ * The event cache is a ring buffer. Its events are therefore passed
+ * as at most two contiguous spans, the second one being the part
+ * that wrapped around. This allows for forwarding sequences of events
+ * at once instead of event by event, e.g. when a pattern fails.
+ * As with ppg_event_buffer_iterate, events that have the flag 
+ * PPG_Event_Considered set are supposed to be ignored.
+ * 
+ * The spans point into the event cache. They are only valid during
+ * the call to the processor.
+ * 
+ * @param span_processor The span processor callback
+ * @param user_data Optional user data is passed on to the span processor callback
+ * 
+ * @returns The number of events that were passed. The processor is not called if there are none.
+ */
+size_t ppg_event_buffer_iterate_spans(
+                        PPG_Event_Span_Processor_Fun span_processor,
+                        void *user_data);
+
 #endif
@@ -24,6 +24,8 @@
 #include "detail/ppg_event_buffer_detail.h"
 #include "detail/ppg_signal_detail.h"
 #include "detail/ppg_pattern_detail.h"
+#include "detail/ppg_input_detail.h"
+#include "detail/ppg_malloc_detail.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -40,12 +42,173 @@ void ppg_global_init(void) {
 
 void ppg_global_compile(void)
 {
+   // The pattern tree of a shared context is compiled 
+   // by the context that owns it
+   //
+   if(ppg_context->properties.tree_shared) { return; }
+   
+   // Only trees whose tokens were dynamically allocated are compacted.
+   // Compressed and statically generated trees already store 
+   // their children in one place.
+   //
+   if(ppg_context->properties.destruction_enabled) {
+      
+      PPG_Token__ **children_block 
+         = ppg_token_compact_children(ppg_context->pattern_root,
+                                      &ppg_context->allocator);
+         
+      if(ppg_context->children_block) {
+         ppg_allocator_free(&ppg_context->allocator, 
+                            ppg_context->children_block);
+      }
+      
+      ppg_context->children_block = children_block;
+   }
+   
+   ppg_context_compile_token_states(ppg_context);
+   
    ppg_context->tree_depth = ppg_pattern_tree_depth();
    
    // Initialize the furcation buffer to ensure correct size (the maximum
-   // search tree depth)
+   // search tree depth). The buffer of dynamically allocated contexts
+   // is resized in place as it stems from the context's allocator.
+   //
+   if(ppg_context->properties.destruction_enabled) {
+      ppg_furcation_stack_resize(&ppg_context->furcation_stack,
+                                 ppg_context->tree_depth,
+                                 &ppg_context->allocator);
+   }
+   else {
+      ppg_furcation_stack_restore(&ppg_context->furcation_stack,
+                                  &ppg_context->allocator);
+   }
+   
+   // The number of threads of the parallel matcher is bounded by the 
+   // number of tokens, the number of events a thread records by the
+   // capacity of the event buffer. Reserving them up front avoids 
+   // allocation during pattern matching.
+   //
+   if(ppg_context->engine == PPG_Engine_Parallel) {
+      ppg_parallel_matcher_reserve(&ppg_context->parallel_matcher,
+                     ppg_context->n_tokens,
+                     ppg_event_buffer_get_capacity(&ppg_context->event_buffer),
+                     &ppg_context->allocator);
+   }
+   
+   if(ppg_context->engine == PPG_Engine_Indexed) {
+      ppg_child_index_build(&ppg_context->child_index, 
+                            ppg_context->pattern_root,
+                            &ppg_context->allocator);
+   }
+   else {
+      ppg_child_index_free(&ppg_context->child_index, &ppg_context->allocator);
+   }
+   
+   ppg_input_collect_masks(&ppg_context->input_masks, 
+                           ppg_context->pattern_root,
+                           ppg_context->n_tokens,
+                           &ppg_context->allocator);
+   
+   ppg_token_compile_completion_marks(&ppg_context->completion_marks,
+                                      ppg_context->pattern_root,
+                                      ppg_context->n_tokens,
+                                      &ppg_context->allocator);
+}
+
+PPG_Count ppg_global_set_engine(PPG_Count engine)
+{
+   PPG_Count old_engine = ppg_context->engine;
+   
+   ppg_context->engine = engine;
+   
+   // If the pattern tree is already compiled, the parallel matcher 
+   // is prepared right away
    //
-   ppg_furcation_stack_restore(&ppg_context->furcation_stack);
+   if((engine == PPG_Engine_Parallel) && (ppg_context->n_tokens > 0)) {
+      ppg_parallel_matcher_reserve(&ppg_context->parallel_matcher,
+                     ppg_context->n_tokens,
+                     ppg_event_buffer_get_capacity(&ppg_context->event_buffer),
+                     &ppg_context->allocator);
+   }
+   
+   return old_engine;
+}
+
+PPG_Count ppg_global_get_engine(void)
+{
+   return ppg_context->engine;
+}
+
+size_t ppg_global_set_work_budget(size_t n_steps)
+{
+   size_t old_n_steps = ppg_context->work_budget.n_steps;
+   
+   ppg_work_budget_set(&ppg_context->work_budget, 
+                       n_steps, 
+                       &ppg_context->allocator);
+   
+   return old_n_steps;
+}
+
+size_t ppg_global_get_work_budget(void)
+{
+   return ppg_context->work_budget.n_steps;
+}
+
+size_t ppg_global_set_deferred_event_capacity(size_t n_events)
+{
+   size_t old_n_events = ppg_global_get_deferred_event_capacity();
+   
+   ppg_work_budget_set_deferred_capacity(&ppg_context->work_budget,
+                                         n_events,
+                                         &ppg_context->allocator);
+   
+   return old_n_events;
+}
+
+size_t ppg_global_get_deferred_event_capacity(void)
+{
+   return ppg_work_budget_get_deferred_capacity(&ppg_context->work_budget);
+}
+
+size_t ppg_global_set_event_buffer_capacity(size_t n_events)
+{
+   size_t old_n_events = ppg_global_get_event_buffer_capacity();
+   
+   if(n_events <= old_n_events) { return old_n_events; }
+   
+   // One slot is always kept free
+   //
+   if(   !ppg_context->properties.destruction_enabled
+      || (n_events >= PPG_EVENT_BUFFER_MAX_CAPACITY)) {
+      PPG_ERROR("Unable to reserve space for %lu events\n",
+                (unsigned long)n_events);
+      abort();
+   }
+   
+   ppg_event_buffer_resize(&ppg_context->event_buffer,
+                           n_events + 1,
+                           &ppg_context->allocator);
+   
+   // The records of the parallel matcher are sized according
+   // to the capacity of the event buffer
+   //
+   if(ppg_context->parallel_matcher.n_allocated_threads > 0) {
+      ppg_parallel_matcher_reserve(&ppg_context->parallel_matcher,
+                     ppg_context->parallel_matcher.n_allocated_threads,
+                     ppg_event_buffer_get_capacity(&ppg_context->event_buffer),
+                     &ppg_context->allocator);
+   }
+   
+   return old_n_events;
+}
+
+size_t ppg_global_get_event_buffer_capacity(void)
+{
+   size_t capacity 
+      = ppg_event_buffer_get_capacity(&ppg_context->event_buffer);
+      
+   return (capacity > 0) ? capacity - 1 : 0;
 }
 
 void ppg_global_finalize(void) {
@@ -103,6 +266,17 @@ PPG_Event_Processor_Fun ppg_global_set_default_event_processor(PPG_Event_Process
    return old_event_processor;
 }
 
+PPG_Event_Span_Processor_Fun ppg_global_set_default_event_span_processor(
+                        PPG_Event_Span_Processor_Fun span_processor)
+{
+   PPG_Event_Span_Processor_Fun old_span_processor 
+      = ppg_context->event_span_processor;
+   
+   ppg_context->event_span_processor = span_processor;
+   
+   return old_span_processor;
+}
+
 bool ppg_global_set_enabled(bool state)
 {
    bool old_state = ppg_context->properties.papageno_enabled;
@@ -126,6 +300,20 @@ bool ppg_global_get_timeout_enabled(void)
    return ppg_context->properties.timeout_enabled;
 }
 
+bool ppg_global_set_event_time_enabled(bool state)
+{
+   bool previous_state = ppg_context->properties.event_time_enabled;
+   
+   ppg_context->properties.event_time_enabled = state;
+   
+   return previous_state;
+}
+
+bool ppg_global_get_event_time_enabled(void)
+{
+   return ppg_context->properties.event_time_enabled;
+}
+
 PPG_Layer ppg_global_set_layer(PPG_Layer layer)
 {
    PPG_Layer previous_layer = ppg_context->layer;
@@ -160,6 +348,21 @@ PPG_Signal_Callback ppg_global_get_signal_callback(void)
    return ppg_context->signal_callback;
 }
 
+PPG_Action_Dispatcher ppg_global_set_action_dispatcher(
+                                    PPG_Action_Dispatcher dispatcher)
+{
+   PPG_Action_Dispatcher previous_dispatcher = ppg_context->action_dispatcher;
+   
+   ppg_context->action_dispatcher = dispatcher;
+   
+   return previous_dispatcher;
+}
+
+PPG_Action_Dispatcher ppg_global_get_action_dispatcher(void)
+{
+   return ppg_context->action_dispatcher;
+}
+
 void ppg_global_abort_pattern_matching(void)
 {     
    if(!ppg_context->current_token) { return; }
@@ -174,6 +377,12 @@ void ppg_global_abort_pattern_matching(void)
    ppg_delete_stored_events();
    
    ppg_reset_pattern_matching_engine();
+   
+   // Interrupted work is obsolete. Deferred events are 
+   // processed as usual.
+   //
+   ppg_context->work_budget.pending = false;
+   ppg_context->work_budget.timeout_pending = false;
 }
 
 #if PPG_HAVE_DEBUGGING
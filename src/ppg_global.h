@@ -22,8 +22,10 @@
 #include "ppg_input.h"
 #include "ppg_time.h"
 #include "ppg_event.h"
+#include "ppg_event_buffer.h"
 #include "ppg_layer.h"
 #include "ppg_signal_callback.h"
+#include "ppg_action.h"
 
 #include <stdbool.h>
 #include <inttypes.h>
@@ -78,6 +80,20 @@ PPG_Time ppg_global_get_timeout(void);
  */
 PPG_Event_Processor_Fun ppg_global_set_default_event_processor(PPG_Event_Processor_Fun event_processor);
 
+/** @brief Defines the default event span processor callback. 
+ * 
+ * If set, the events that are flushed when a pattern fails are
+ * passed to the span processor with a single call (see 
+ * ppg_event_buffer_iterate_spans) instead of being passed to the
+ * default input processor one by one. By default, no span processor
+ * is set.
+ * 
+ * @param span_processor The default span processor callback or NULL
+ * @returns The callback that was active before resetting
+ */
+PPG_Event_Span_Processor_Fun ppg_global_set_default_event_span_processor(
+                        PPG_Event_Span_Processor_Fun span_processor);
+
 /** @brief Use this function to temporarily disable/enable pattern processing. 
  * 
  * Processing is enabled by default.
@@ -95,6 +111,120 @@ void ppg_global_init(void);
  */
 void ppg_global_compile(void);
 
+/** @brief The available pattern matching engines
+ */
+enum PPG_Engine {
+   PPG_Engine_Tree = 0, ///< Walks the token tree (the default)
+   PPG_Engine_Indexed, ///< Walks the token tree, looking up candidate children in a child index
+   PPG_Engine_Parallel ///< Advances all candidate branches simultaneously
+};
+
+/** @brief Selects the pattern matching engine
+ * 
+ * The indexed engine works exactly like the tree engine, but replaces the 
+ * linear scan of a token's children by a lookup in an index that maps 
+ * activated inputs to the children that can be entered with them. 
+ * The index is generated by ppg_global_compile. Thus, the engine must be 
+ * selected before the pattern tree is compiled. Tokens with many children, 
+ * such as the root of large pattern trees, are given a dispatch table 
+ * that yields the candidate children of an input in constant time.
+ * The index is no table driven state machine. Tokens still match events
+ * through their virtual match_event functions and the engine still
+ * reverts to previous furcations when a branch fails. Deactivation 
+ * events and children that cannot name their entry inputs 
+ * are handled by the linear scan.
+ * 
+ * The parallel engine passes every event to all candidate branches of the
+ * pattern tree at once instead of reverting to previous furcations and 
+ * processing events again when a branch fails. Every event is processed
+ * exactly once by each live branch. The storage the engine requires 
+ * is bounded by the number of tokens times the capacity of the event buffer
+ * and is allocated by ppg_global_compile. Its results are identical to 
+ * those of the tree engine with two exceptions. Tokens are reset when 
+ * their branch is entered, not when the tree engine would reach them. 
+ * This matters for tokens that are still active from a previous match. 
+ * If stored events are deleted while a pattern is in progress, 
+ * live branches continue with the events that follow, while branches that 
+ * ended on the deleted events are abandoned.
+ * 
+ * @param engine The engine to use, one of the PPG_Engine values
+ * @returns The previously selected engine
+ */
+PPG_Count ppg_global_set_engine(PPG_Count engine);
+
+/** @brief Retreives the currently selected pattern matching engine
+ * 
+ * @returns The current engine
+ */
+PPG_Count ppg_global_get_engine(void);
+
+/** @brief Limits the work that is done by a single call to one of the 
+ *         event processing functions
+ * 
+ * A step is the check of a token against an event (for the parallel 
+ * engine the check of all candidate branches against an event)
+ * or the reversion to another branch option after a timeout. 
+ * Bounding the number of steps per call allows for an upper bound 
+ * of the time spent, e.g. in an input interrupt, 
+ * as unfortunate input sequences can otherwise cause long 
+ * runs of backtracking. Remaining work is continued by 
+ * ppg_event_process_pending.
+ * 
+ * @param n_steps The maximum number of steps per call or zero for no limit
+ * @returns The previous number of steps
+ */
+size_t ppg_global_set_work_budget(size_t n_steps);
+
+/** @brief Retreives the work budget
+ * 
+ * @returns The maximum number of steps per call or zero if there is no limit
+ */
+size_t ppg_global_get_work_budget(void);
+
+/** @brief Sets the number of events that can be deferred while work is pending
+ * 
+ * Events that arrive while work is pending (see ppg_global_set_work_budget)
+ * are stored until the previous work is done. Events that
+ * arrive while the storage is full are dropped and signaled
+ * as PPG_On_Event_Dropped. By default, PPG_MAX_EVENTS events can 
+ * be deferred. The capacity is rounded up to a power of two 
+ * internally. It never drops below the number of events that are 
+ * currently deferred.
+ * 
+ * @param n_events The number of events that can be deferred
+ * @returns The previous number of events that could be deferred
+ */
+size_t ppg_global_set_deferred_event_capacity(size_t n_events);
+
+/** @brief Retreives the number of events that can be deferred
+ * 
+ * @returns The number of events or zero if no work budget was set so far
+ */
+size_t ppg_global_get_deferred_event_capacity(void);
+
+/** @brief Reserves space in the event buffer of the current context
+ * 
+ * The event buffer grows automatically when input events arrive 
+ * faster than patterns can be matched, e.g. for long patterns. 
+ * Reserving space in advance avoids growth while matching.
+ * The capacity is rounded up to a power of two internally. The 
+ * event buffer never shrinks. 
+ * 
+ * Contexts that were generated statically, e.g. by glockenspiel,
+ * cannot grow their event buffer. Reserving more events than they
+ * can hold is fatal.
+ * 
+ * @param n_events The minimum number of events that the buffer must be able to hold
+ * @returns The previous number of events that the buffer could hold
+ */
+size_t ppg_global_set_event_buffer_capacity(size_t n_events);
+
+/** @brief Retreives the number of events that the event buffer of the current context can hold without growing
+ * 
+ * @returns The number of events
+ */
+size_t ppg_global_get_event_buffer_capacity(void);
+
 /** @brief Finalizes Papageno, i.e. clears all patterns and frees all allocated memory.
  * 
  * Please not that this operation only operates on the current context. It you have created
@@ -132,6 +262,32 @@ bool ppg_global_set_timeout_enabled(bool state);
  */
 bool ppg_global_get_timeout_enabled(void);
 
+/** @brief Toggles event time mode
+ * 
+ * In event time mode, the time member of events passed to 
+ * ppg_event_process is used as their time of arrival instead of 
+ * querying the time manager. Timeouts are then computed with plain 
+ * integer arithmetic on PPG_Time values, which requires time values 
+ * to increase monotonically. Time differences are computed with 
+ * unsigned wrap-around. The time differencing and comparison
+ * functions of the time manager are not used. The time function is
+ * only used by ppg_timeout_check and ppg_timeout_update_timerfd 
+ * that have no event to read the time from.
+ * 
+ * Event time mode makes replaying recorded input deterministic.
+ * 
+ * @param state The new state of event time mode
+ * 
+ * @returns The previous state of event time mode
+ */
+bool ppg_global_set_event_time_enabled(bool state);
+
+/** @brief Determines if event time mode is enabled
+ * 
+ * @returns The current state of event time mode
+ */
+bool ppg_global_get_event_time_enabled(void);
+
 /** @brief Set the current layer
  * 
  * @returns The previously active layer
@@ -157,6 +313,24 @@ PPG_Signal_Callback ppg_global_set_signal_callback(PPG_Signal_Callback callback)
  */
 PPG_Signal_Callback ppg_global_get_signal_callback(void);
 
+/** @brief Set a dispatcher that receives all triggered actions
+ * 
+ * Without a dispatcher, actions are called directly during pattern
+ * matching. Pass a dispatcher with a NULL function to restore 
+ * this behavior. The dispatcher is not stored in compressed contexts.
+ *
+ * @param dispatcher The action dispatcher
+ * @returns The previous dispatcher
+ */
+PPG_Action_Dispatcher ppg_global_set_action_dispatcher(
+                                    PPG_Action_Dispatcher dispatcher);
+
+/** @brief Get the current action dispatcher
+ *
+ * @returns The current dispatcher
+ */
+PPG_Action_Dispatcher ppg_global_get_action_dispatcher(void);
+
 #if PPG_HAVE_DEBUGGING
 
 /** @brief Checks consistency of pattern matching system
@@ -0,0 +1,259 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg_ingress_queue.h"
+#include "ppg_debug.h"
+#include "detail/ppg_malloc_detail.h"
+#include "detail/ppg_event_detail.h"
+#include "detail/ppg_timer_wheel_detail.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if PPG_HAVE_INGRESS_QUEUE
+
+// The number of events that are passed to pattern matching at once
+//
+#ifndef PPG_INGRESS_QUEUE_BATCH_SIZE
+#define PPG_INGRESS_QUEUE_BATCH_SIZE 32
+#endif
+
+// Separates data that is written by producers from data that is 
+// written by the consumer to avoid false sharing
+//
+#ifndef PPG_CACHE_LINE_SIZE
+#define PPG_CACHE_LINE_SIZE 64
+#endif
+
+// Every cell carries a sequence number that tells whether it 
+// is ready to be written by a producer or to be read by the consumer
+// (D. Vyukov's bounded queue).
+//
+typedef struct {
+   size_t sequence;
+   PPG_Event event;
+} PPG_Ingress_Queue_Cell;
+
+typedef struct {
+   
+   PPG_Ingress_Queue_Cell *cells;
+   size_t mask;
+   
+   char padding_1[PPG_CACHE_LINE_SIZE];
+   
+   // Written by producers
+   //
+   size_t enqueue_pos;
+   size_t n_events_rejected;
+   
+   char padding_2[PPG_CACHE_LINE_SIZE];
+   
+   // Written by the consumer
+   //
+   size_t dequeue_pos;
+   size_t max_fill;
+   
+} PPG_Ingress_Queue;
+
+void* ppg_ingress_queue_create(size_t capacity)
+{
+   size_t n_cells = 2;
+   
+   while(n_cells < capacity) {
+      n_cells <<= 1;
+   }
+   
+   PPG_Ingress_Queue *queue 
+      = (PPG_Ingress_Queue *)PPG_MALLOC(sizeof(PPG_Ingress_Queue));
+   
+   queue->cells 
+      = (PPG_Ingress_Queue_Cell *)PPG_MALLOC(
+                              n_cells*sizeof(PPG_Ingress_Queue_Cell));
+   
+   for(size_t i = 0; i < n_cells; ++i) {
+      queue->cells[i].sequence = i;
+   }
+   
+   queue->mask = n_cells - 1;
+   queue->enqueue_pos = 0;
+   queue->n_events_rejected = 0;
+   queue->dequeue_pos = 0;
+   queue->max_fill = 0;
+   
+   return queue;
+}
+
+void ppg_ingress_queue_destroy(void *queue)
+{
+   PPG_Ingress_Queue *queue__ = (PPG_Ingress_Queue *)queue;
+   
+   free(queue__->cells);
+   free(queue__);
+}
+
+bool ppg_ingress_queue_push(void *queue, PPG_Event *event)
+{
+   PPG_Ingress_Queue *queue__ = (PPG_Ingress_Queue *)queue;
+   
+   size_t pos = __atomic_load_n(&queue__->enqueue_pos, __ATOMIC_RELAXED);
+   
+   PPG_Ingress_Queue_Cell *cell;
+   
+   while(1) {
+      
+      cell = &queue__->cells[pos & queue__->mask];
+      
+      size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+      
+      intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+      
+      if(diff == 0) {
+         
+         // The cell is free, try to claim it
+         //
+         if(__atomic_compare_exchange_n(&queue__->enqueue_pos, &pos, pos + 1,
+                                        true, 
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+         }
+      }
+      else if(diff < 0) {
+         
+         // The cell has not been read yet, i.e. the queue is full
+         //
+         __atomic_fetch_add(&queue__->n_events_rejected, 1, __ATOMIC_RELAXED);
+         
+         return false;
+      }
+      else {
+         
+         // Another producer claimed the cell
+         //
+         pos = __atomic_load_n(&queue__->enqueue_pos, __ATOMIC_RELAXED);
+      }
+   }
+   
+   cell->event = *event;
+   
+   __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+   
+   return true;
+}
+
+// Copies the event at the given offset from the read position 
+// without releasing its cell
+//
+static bool ppg_ingress_queue_peek(PPG_Ingress_Queue *queue, 
+                                   size_t offset,
+                                   PPG_Event *event)
+{
+   size_t pos = queue->dequeue_pos + offset;
+   
+   PPG_Ingress_Queue_Cell *cell = &queue->cells[pos & queue->mask];
+   
+   size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+   
+   // The cell is either empty or not completely written yet
+   //
+   if((intptr_t)sequence - (intptr_t)(pos + 1) < 0) {
+      return false;
+   }
+   
+   *event = cell->event;
+   
+   return true;
+}
+
+// Releases the cells of the given number of events at the read position
+// for the next round
+//
+static void ppg_ingress_queue_release(PPG_Ingress_Queue *queue, 
+                                      size_t n_events)
+{
+   for(size_t i = 0; i < n_events; ++i) {
+      
+      size_t pos = queue->dequeue_pos + i;
+      
+      __atomic_store_n(&queue->cells[pos & queue->mask].sequence, 
+                       pos + queue->mask + 1, __ATOMIC_RELEASE);
+   }
+   
+   queue->dequeue_pos += n_events;
+}
+
+size_t ppg_ingress_queue_drain(void *queue, size_t max_events)
+{
+   PPG_Ingress_Queue *queue__ = (PPG_Ingress_Queue *)queue;
+   
+   size_t fill = __atomic_load_n(&queue__->enqueue_pos, __ATOMIC_RELAXED)
+                     - queue__->dequeue_pos;
+                     
+   if(fill > queue__->max_fill) {
+      queue__->max_fill = fill;
+   }
+   
+   // Events stay queued while pattern matching work is pending.
+   // Thus, producers see the queue fill up and their events rejected
+   // instead of the events being deferred or dropped by the context.
+   //
+   if(ppg_event_process_pending()) { return 0; }
+   
+   PPG_Event events[PPG_INGRESS_QUEUE_BATCH_SIZE];
+   
+   size_t n_processed = 0;
+   
+   while(n_processed < max_events) {
+      
+      size_t n_events = 0;
+      
+      while(   (n_events < PPG_INGRESS_QUEUE_BATCH_SIZE)
+            && (n_processed + n_events < max_events)
+            && ppg_ingress_queue_peek(queue__, n_events, &events[n_events])) {
+         ++n_events;
+      }
+      
+      if(n_events == 0) { break; }
+      
+      size_t n_consumed = ppg_event_process_until_busy(events, n_events);
+      
+      ppg_ingress_queue_release(queue__, n_consumed);
+      
+      n_processed += n_consumed;
+      
+      if(n_consumed < n_events) { break; }
+   }
+   
+   ppg_timer_wheel_on_events_processed();
+   
+   return n_processed;
+}
+
+void ppg_ingress_queue_get_statistics(void *queue, 
+                                      PPG_Ingress_Queue_Statistics *statistics)
+{
+   PPG_Ingress_Queue *queue__ = (PPG_Ingress_Queue *)queue;
+   
+   size_t n_events_pushed 
+      = __atomic_load_n(&queue__->enqueue_pos, __ATOMIC_RELAXED);
+   
+   statistics->n_events_pushed = n_events_pushed;
+   statistics->n_events_rejected 
+      = __atomic_load_n(&queue__->n_events_rejected, __ATOMIC_RELAXED);
+   statistics->n_events_drained = queue__->dequeue_pos;
+   statistics->max_fill = queue__->max_fill;
+}
+
+#endif
@@ -0,0 +1,109 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_INGRESS_QUEUE_H
+#define PPG_INGRESS_QUEUE_H
+
+/** @file */
+
+#include "ppg_event.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief This macro is defined non-zero if the ingress queue is available. 
+ * 
+ * The queue relies on the atomic builtins of GCC and clang.
+ */
+#ifndef PPG_HAVE_INGRESS_QUEUE
+#if defined(__GNUC__) && !defined(__AVR__)
+#define PPG_HAVE_INGRESS_QUEUE 1
+#else
+#define PPG_HAVE_INGRESS_QUEUE 0
+#endif
+#endif
+
+#if PPG_HAVE_INGRESS_QUEUE
+
+/* An ingress queue is a bounded lock-free queue that allows 
+ * several producer threads to pass events to a single 
+ * consumer thread that runs pattern matching. 
+ */
+
+/** @brief Statistics about the usage of an ingress queue
+ */
+typedef struct {
+   size_t n_events_pushed; ///< The number of events that were pushed successfully
+   size_t n_events_rejected; ///< The number of events that were rejected because the queue was full
+   size_t n_events_drained; ///< The number of events that were passed to pattern matching
+   size_t max_fill; ///< The maximum number of queued events encountered when draining
+} PPG_Ingress_Queue_Statistics;
+
+/** @brief Creates a new ingress queue
+ * 
+ * @param capacity The maximum number of queued events. It is rounded up
+ *                 to the next power of two.
+ * @returns The newly created queue
+ */
+void* ppg_ingress_queue_create(size_t capacity);
+
+/** @brief Destroys an ingress queue
+ * 
+ * Events that are still queued are dropped.
+ * 
+ * @param queue The queue to destroy
+ */
+void ppg_ingress_queue_destroy(void *queue);
+
+/** @brief Pushes an event to an ingress queue
+ * 
+ * This function may be called concurrently by any number of threads.
+ * As events are processed in batches, the time of arrival is taken
+ * from the time member of the event, see ppg_event_process_batch.
+ * 
+ * @param queue The queue
+ * @param event The event to push. It is copied.
+ * @returns false if the queue is full and the event was dropped, true else
+ */
+bool ppg_ingress_queue_push(void *queue, PPG_Event *event);
+
+/** @brief Passes queued events to pattern matching
+ * 
+ * The events are processed by the current context of the calling 
+ * thread. Only a single thread at a time may drain a queue.
+ * 
+ * Work that is pending because the work budget was exhausted
+ * (see ppg_global_set_work_budget) is resumed first. Draining stops 
+ * as soon as the work budget is exhausted. The remaining events stay
+ * queued until the next call, so producers see the queue fill up.
+ * 
+ * @param queue The queue
+ * @param max_events The maximum number of events to process
+ * @returns The number of events processed
+ */
+size_t ppg_ingress_queue_drain(void *queue, size_t max_events);
+
+/** @brief Retreives statistics about the usage of an ingress queue
+ * 
+ * @param queue The queue
+ * @param statistics Pointer to the statistics struct to fill
+ */
+void ppg_ingress_queue_get_statistics(void *queue, 
+                                      PPG_Ingress_Queue_Statistics *statistics);
+
+#endif
+
+#endif
@@ -24,43 +24,48 @@
 
 #define S_AGGREGATE sequence->aggregate
 
-static bool ppg_sequence_match_event(  
+bool ppg_sequence_match_event(  
                                  PPG_Sequence *sequence,
                                  PPG_Event *event,
                                  bool modify_only_if_consuming) 
 {
    PPG_LOG("Ch. sequence\n");
    
-   PPG_LOG("++++++++++++++Sequence 0x%" PRIXPTR " %d/%d, flags: %d, state: %d\n", (uintptr_t)sequence, sequence->next_member, S_AGGREGATE.n_members,S_AGGREGATE.super.misc.flags, S_AGGREGATE.super.misc.state);
+   PPG_Aggregate_State *aggregate_state = ppg_aggregate_get_state(&S_AGGREGATE);
+   
+   PPG_Bitfield member_active 
+      = ppg_aggregate_get_bitfield(&S_AGGREGATE, PPG_Aggregate_Member_Active);
+   
+   PPG_LOG("++++++++++++++Sequence 0x%" PRIXPTR " %d/%d, flags: %d, state: %d\n", (uintptr_t)sequence, aggregate_state->next_member, S_AGGREGATE.n_members,PPG_TOKEN_MISC(sequence).flags, PPG_TOKEN_MISC(sequence).state);
    
    bool input_part_of_sequence = false;
    
    PPG_ASSERT(S_AGGREGATE.n_members != 0);
    
    if(event->flags & PPG_Event_Active) {
-      if(S_AGGREGATE.inputs[sequence->next_member] == event->input) {
-         ppg_bitfield_set_bit(&S_AGGREGATE.member_active, sequence->next_member, true);
-         ++sequence->next_member;
-         ++S_AGGREGATE.n_inputs_active;
+      if(S_AGGREGATE.inputs[aggregate_state->next_member] == event->input) {
+         ppg_bitfield_set_bit(&member_active, aggregate_state->next_member, true);
+         ++aggregate_state->next_member;
+         ++aggregate_state->n_inputs_active;
          input_part_of_sequence = true;
       }
       else {
          
          if(!modify_only_if_consuming) {
-            S_AGGREGATE.super.misc.state = PPG_Token_Invalid;
+            PPG_TOKEN_MISC(sequence).state = PPG_Token_Invalid;
          }
                
          return false;
       }
    }
    else {
-      for(PPG_Count i = 0; i < sequence->next_member; ++i) {
+      for(PPG_Count i = 0; i < aggregate_state->next_member; ++i) {
          
          if(S_AGGREGATE.inputs[i] == event->input) {
             
-            if(ppg_bitfield_get_bit(&S_AGGREGATE.member_active, i)) {
-               ppg_bitfield_set_bit(&S_AGGREGATE.member_active, i, false);
-               --S_AGGREGATE.n_inputs_active;
+            if(ppg_bitfield_get_bit(&member_active, i)) {
+               ppg_bitfield_set_bit(&member_active, i, false);
+               --aggregate_state->n_inputs_active;
                input_part_of_sequence = true;
                break;
             }
@@ -69,12 +74,12 @@ static bool ppg_sequence_match_event(
    }
    
 #if PPG_HAVE_LOGGING
-   PPG_LOG("inputs active: %d\n", S_AGGREGATE.n_inputs_active);
+   PPG_LOG("inputs active: %d\n", aggregate_state->n_inputs_active);
    for(PPG_Count i = 0; i < S_AGGREGATE.n_members; ++i) {
       PPG_LOG("%d: 0x%d = %d\n", 
               i, 
               S_AGGREGATE.inputs[i],
-              ppg_bitfield_get_bit(&S_AGGREGATE.member_active, i)
+              ppg_bitfield_get_bit(&member_active, i)
       );
    }
 #endif
@@ -83,7 +88,7 @@ static bool ppg_sequence_match_event(
          
       if(event->flags & PPG_Event_Active) {
          if(!modify_only_if_consuming) {
-            S_AGGREGATE.super.misc.state = PPG_Token_Invalid;
+            PPG_TOKEN_MISC(sequence).state = PPG_Token_Invalid;
          }
       }
       
@@ -93,42 +98,42 @@ static bool ppg_sequence_match_event(
       return false;
    }
    
-   S_AGGREGATE.super.misc.state = PPG_Token_Activation_In_Progress;
+   PPG_TOKEN_MISC(sequence).state = PPG_Token_Activation_In_Progress;
    
-   if(   (sequence->next_member >= S_AGGREGATE.n_members) 
+   if(   (aggregate_state->next_member >= S_AGGREGATE.n_members) 
       // Only enter this clause once when the last input of the sequence activated
-      && !(S_AGGREGATE.super.misc.flags & PPG_Aggregate_All_Active)) {
+      && !(PPG_TOKEN_MISC(sequence).flags & PPG_Aggregate_All_Active)) {
       
-      S_AGGREGATE.super.misc.flags |= PPG_Aggregate_All_Active;
+      PPG_TOKEN_MISC(sequence).flags |= PPG_Aggregate_All_Active;
       
-      if(!(S_AGGREGATE.super.misc.flags & PPG_Token_Flags_Pedantic)) {
+      if(!(PPG_TOKEN_MISC(sequence).flags & PPG_Token_Flags_Pedantic)) {
          /* Sequence matches
          */
-         S_AGGREGATE.super.misc.state = PPG_Token_Matches;
+         PPG_TOKEN_MISC(sequence).state = PPG_Token_Matches;
       }
    }
-   else if(S_AGGREGATE.n_inputs_active == 0) {
+   else if(aggregate_state->n_inputs_active == 0) {
       
-      if(S_AGGREGATE.super.misc.flags & PPG_Aggregate_All_Active) {
+      if(PPG_TOKEN_MISC(sequence).flags & PPG_Aggregate_All_Active) {
       
-         if(S_AGGREGATE.super.misc.flags & PPG_Token_Flags_Pedantic) {
+         if(PPG_TOKEN_MISC(sequence).flags & PPG_Token_Flags_Pedantic) {
             /* Sequence matches
             */
-            S_AGGREGATE.super.misc.state = PPG_Token_Matches;
+            PPG_TOKEN_MISC(sequence).state = PPG_Token_Matches;
          }
          else {
-            S_AGGREGATE.super.misc.state = PPG_Token_Finalized;
+            PPG_TOKEN_MISC(sequence).state = PPG_Token_Finalized;
          }
       }
    }
    else {
-      if(S_AGGREGATE.super.misc.flags & PPG_Aggregate_All_Active) {
-         S_AGGREGATE.super.misc.state = PPG_Token_Deactivation_In_Progress;
+      if(PPG_TOKEN_MISC(sequence).flags & PPG_Aggregate_All_Active) {
+         PPG_TOKEN_MISC(sequence).state = PPG_Token_Deactivation_In_Progress;
       }
    }
    
    PPG_LOG("================Sequence 0x%" PRIXPTR " %d/%d, flags: %d, state: %d\n", 
-          (uintptr_t)sequence, sequence->next_member, S_AGGREGATE.n_members,S_AGGREGATE.super.misc.flags, S_AGGREGATE.super.misc.state);
+          (uintptr_t)sequence, aggregate_state->next_member, S_AGGREGATE.n_members,PPG_TOKEN_MISC(sequence).flags, PPG_TOKEN_MISC(sequence).state);
    
    return true;
 }
@@ -139,6 +144,16 @@ static PPG_Count ppg_sequence_token_precedence(PPG_Token__ *token)
    return PPG_Token_Precedence_Sequence;
 }
 
+static PPG_Input_Id *ppg_sequence_entry_inputs(PPG_Sequence *sequence, 
+                                               PPG_Count *n_inputs)
+{
+   // A sequence must always be entered through its first member
+   //
+   *n_inputs = 1;
+   
+   return sequence->aggregate.inputs;
+}
+
 static size_t ppg_sequence_dynamic_member_size(PPG_Token *token)
 {
    return   sizeof(PPG_Sequence)
@@ -160,9 +175,9 @@ static char *ppg_sequence_placement_clone(PPG_Token__ *token, char *buffer)
    return ppg_aggregate_copy_dynamic_members(token, clone, buffer + sizeof(PPG_Sequence));
 }
 
-static void ppg_sequence_reset(PPG_Sequence *sequence) 
+void ppg_sequence_reset(PPG_Sequence *sequence) 
 {
-   sequence->next_member = 0;
+   ppg_aggregate_get_state(&S_AGGREGATE)->next_member = 0;
    ppg_aggregate_reset((PPG_Aggregate*)sequence);
 }
 
@@ -171,7 +186,8 @@ static void ppg_sequence_print_self(PPG_Sequence *c, PPG_Count indent, bool recu
 {
    PPG_I PPG_LOG("<*** seq (0x%" PRIXPTR ") ***>\n", (uintptr_t)c);
    ppg_token_print_self_start((PPG_Token__*)c, indent);
-   PPG_I PPG_LOG("\tnext member: %d\n", c->next_member);
+   PPG_I PPG_LOG("\tnext member: %d\n", 
+                 ppg_aggregate_get_state(&c->aggregate)->next_member);
    ppg_token_print_self_end((PPG_Token__*)c, indent, recurse);
 }
 #endif
@@ -188,6 +204,10 @@ PPG_Token_Vtable ppg_sequence_vtable =
       = (PPG_Token_Equals_Fun) ppg_aggregates_equal,
    .token_precedence
       = (PPG_Token_Precedence_Fun)ppg_sequence_token_precedence,
+   .entry_inputs
+      = (PPG_Token_Entry_Inputs_Fun)ppg_sequence_entry_inputs,
+   .inputs
+      = (PPG_Token_Inputs_Fun)ppg_aggregate_inputs,
    .dynamic_size
       = (PPG_Token_Dynamic_Size_Requirement_Fun)ppg_sequence_dynamic_member_size,
    .placement_clone
@@ -197,7 +217,9 @@ PPG_Token_Vtable ppg_sequence_vtable =
    .addresses_to_relative
       = (PPG_Token_Addresses_To_Relative)ppg_aggregate_addresses_to_relative,
    .addresses_to_absolute
-      = (PPG_Token_Addresses_To_Absolute)ppg_aggregate_addresses_to_absolute
+      = (PPG_Token_Addresses_To_Absolute)ppg_aggregate_addresses_to_absolute,
+   .layout_state
+      = (PPG_Token_Layout_State_Fun)ppg_aggregate_layout_state
       
    #if PPG_PRINT_SELF_ENABLED
    ,
@@ -220,8 +242,6 @@ PPG_Token ppg_sequence_create(
    
    S_AGGREGATE.super.vtable = &ppg_sequence_vtable;
    
-   sequence->next_member = 0;
-   
 //    PPG_LOG("in def: 0x%" PRIXPTR "\n", (uintptr_t)ppg_sequence_match_event);
    
    return ppg_global_initialize_aggregate((PPG_Aggregate*)sequence, n_inputs, inputs);
@@ -36,7 +36,8 @@ enum PPG_Signals {
    PPG_On_Match_Failed,
    PPG_On_Flush_Events,
    PPG_On_Initialization,
-   PPG_Before_Action
+   PPG_Before_Action,
+   PPG_On_Event_Dropped ///< An event was dropped as the ring of deferred events or the event buffer of a context with fixed capacity was full
 };
 
 #endif
@@ -0,0 +1,195 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg_stream_set.h"
+#include "ppg_context.h"
+#include "ppg_debug.h"
+#include "detail/ppg_context_detail.h"
+#include "detail/ppg_malloc_detail.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+#ifndef PPG_STREAM_SET_SLAB_SIZE
+#define PPG_STREAM_SET_SLAB_SIZE 32
+#endif
+
+typedef struct {
+   
+   PPG_Context *source;
+   
+   // Every slab stores PPG_STREAM_SET_SLAB_SIZE stream contexts. 
+   // Slabs are allocated on demand, unused entries of the 
+   // table are NULL.
+   //
+   PPG_Context **slabs;
+   size_t n_slabs;
+   
+} PPG_Stream_Set;
+
+// Stream contexts are zero initialized as long as they are unused
+//
+static bool ppg_stream_set_stream_in_use(PPG_Context *stream)
+{
+   return stream->pattern_root != NULL;
+}
+
+void* ppg_stream_set_create(void *context)
+{
+   PPG_Stream_Set *stream_set 
+      = (PPG_Stream_Set *)PPG_MALLOC(sizeof(PPG_Stream_Set));
+   
+   stream_set->source = (PPG_Context *)context;
+   stream_set->slabs = NULL;
+   stream_set->n_slabs = 0;
+   
+   return stream_set;
+}
+
+void ppg_stream_set_destroy(void *stream_set)
+{
+   PPG_Stream_Set *stream_set__ = (PPG_Stream_Set *)stream_set;
+   
+   for(size_t s = 0; s < stream_set__->n_slabs; ++s) {
+      
+      PPG_Context *slab = stream_set__->slabs[s];
+      
+      if(!slab) { continue; }
+      
+      for(size_t i = 0; i < PPG_STREAM_SET_SLAB_SIZE; ++i) {
+         if(ppg_stream_set_stream_in_use(&slab[i])) {
+            ppg_context_finalize_shared(&slab[i]);
+         }
+      }
+      
+      free(slab);
+   }
+   
+   if(stream_set__->slabs) {
+      free(stream_set__->slabs);
+   }
+   
+   free(stream_set__);
+}
+
+static void ppg_stream_set_grow(PPG_Stream_Set *stream_set, size_t n_slabs)
+{
+   if(n_slabs <= stream_set->n_slabs) { return; }
+   
+   PPG_Context **new_slabs 
+      = (PPG_Context **)PPG_MALLOC(n_slabs*sizeof(PPG_Context *));
+      
+   for(size_t s = 0; s < n_slabs; ++s) {
+      new_slabs[s] = (s < stream_set->n_slabs) ? stream_set->slabs[s] : NULL;
+   }
+   
+   if(stream_set->slabs) {
+      free(stream_set->slabs);
+   }
+   
+   stream_set->slabs = new_slabs;
+   stream_set->n_slabs = n_slabs;
+}
+
+static PPG_Context *ppg_stream_set_get_stream(PPG_Stream_Set *stream_set, 
+                                              size_t stream_id)
+{
+   size_t slab_id = stream_id/PPG_STREAM_SET_SLAB_SIZE;
+   
+   ppg_stream_set_grow(stream_set, slab_id + 1);
+   
+   PPG_Context *slab = stream_set->slabs[slab_id];
+   
+   if(!slab) {
+      
+      size_t n_bytes = PPG_STREAM_SET_SLAB_SIZE*sizeof(PPG_Context);
+      
+      slab = (PPG_Context *)PPG_MALLOC(n_bytes);
+      
+      memset(slab, 0, n_bytes);
+      
+      stream_set->slabs[slab_id] = slab;
+   }
+   
+   PPG_Context *stream = &slab[stream_id%PPG_STREAM_SET_SLAB_SIZE];
+   
+   if(!ppg_stream_set_stream_in_use(stream)) {
+      ppg_context_initialize_shared(stream, stream_set->source);
+   }
+   
+   return stream;
+}
+
+void ppg_stream_set_event_process(void *stream_set, 
+                                  size_t stream_id, 
+                                  PPG_Event *event)
+{
+   ppg_ctx_event_process(
+      ppg_stream_set_get_stream((PPG_Stream_Set *)stream_set, stream_id),
+      event);
+}
+
+bool ppg_stream_set_timeout_check(void *stream_set)
+{
+   PPG_Stream_Set *stream_set__ = (PPG_Stream_Set *)stream_set;
+   
+   bool timeout_hit = false;
+   
+   for(size_t s = 0; s < stream_set__->n_slabs; ++s) {
+      
+      PPG_Context *slab = stream_set__->slabs[s];
+      
+      if(!slab) { continue; }
+      
+      for(size_t i = 0; i < PPG_STREAM_SET_SLAB_SIZE; ++i) {
+         if(ppg_stream_set_stream_in_use(&slab[i])) {
+            timeout_hit |= ppg_ctx_timeout_check(&slab[i]);
+         }
+      }
+   }
+   
+   return timeout_hit;
+}
+
+void* ppg_stream_set_get_context(void *stream_set, size_t stream_id)
+{
+   return ppg_stream_set_get_stream((PPG_Stream_Set *)stream_set, stream_id);
+}
+
+void ppg_stream_set_release_stream(void *stream_set, size_t stream_id)
+{
+   PPG_Stream_Set *stream_set__ = (PPG_Stream_Set *)stream_set;
+   
+   size_t slab_id = stream_id/PPG_STREAM_SET_SLAB_SIZE;
+   
+   if(   (slab_id >= stream_set__->n_slabs)
+      || !stream_set__->slabs[slab_id]) {
+      return;
+   }
+   
+   PPG_Context *stream 
+      = &stream_set__->slabs[slab_id][stream_id%PPG_STREAM_SET_SLAB_SIZE];
+   
+   if(!ppg_stream_set_stream_in_use(stream)) { return; }
+   
+   ppg_context_finalize_shared(stream);
+   
+   memset(stream, 0, sizeof(PPG_Context));
+}
+
+#endif
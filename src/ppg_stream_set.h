@@ -0,0 +1,98 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_STREAM_SET_H
+#define PPG_STREAM_SET_H
+
+/** @file */
+
+#include "ppg_event.h"
+#include "ppg_settings.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+/* A stream set matches many independent input streams, e.g. one per 
+ * user, against the pattern tree of a single context. Every stream 
+ * keeps its own matching state. Streams are created on demand when
+ * they are first used and are allocated in slabs of 
+ * PPG_STREAM_SET_SLAB_SIZE streams.
+ */
+
+/** @brief Creates a new stream set
+ * 
+ * The pattern tree of the given context must have been compiled. 
+ * All streams inherit the settings of the context at the time 
+ * they are created. The context must neither be destroyed nor have 
+ * its pattern tree modified as long as the stream set exists.
+ * 
+ * @param context The context whose pattern tree is shared by all streams
+ * @returns The newly created stream set
+ */
+void* ppg_stream_set_create(void *context);
+
+/** @brief Destroys a stream set and all of its streams
+ * 
+ * @param stream_set The stream set to destroy
+ */
+void ppg_stream_set_destroy(void *stream_set);
+
+/** @brief Processes an input event of a given stream
+ * 
+ * See ppg_event_process for further information.
+ * 
+ * @param stream_set The stream set
+ * @param stream_id The id of the stream the event belongs to
+ * @param event A pointer to an input event
+ */
+void ppg_stream_set_event_process(void *stream_set, 
+                                  size_t stream_id, 
+                                  PPG_Event *event);
+
+/** @brief Checks all streams of a stream set for timeouts
+ * 
+ * @param stream_set The stream set
+ * @returns true if a timeout happened for any stream, false else
+ */
+bool ppg_stream_set_timeout_check(void *stream_set);
+
+/** @brief Retreives the context of a given stream
+ * 
+ * The stream is created if necessary. The context may be passed to the
+ * ppg_ctx_... functions, e.g. to set the layer of an individual stream.
+ * It must not be destroyed by the caller.
+ * 
+ * @param stream_set The stream set
+ * @param stream_id The id of the stream
+ * @returns The context of the stream
+ */
+void* ppg_stream_set_get_context(void *stream_set, size_t stream_id);
+
+/** @brief Releases a stream and frees its matching state
+ * 
+ * Events that are stored by the stream are dropped. The stream id 
+ * may be reused afterwards.
+ * 
+ * @param stream_set The stream set
+ * @param stream_id The id of the stream
+ */
+void ppg_stream_set_release_stream(void *stream_set, size_t stream_id);
+
+#endif
+
+#endif
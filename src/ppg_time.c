@@ -19,6 +19,10 @@
 #include "detail/ppg_context_detail.h"
 #include "detail/ppg_time_detail.h"
 
+#if defined(__linux__) && !defined(PPG_DISABLE_MONOTONIC_TIME)
+#include <time.h>
+#endif
+
 void ppg_time_manager_init(PPG_Time_Manager *time_manager)
 {
    time_manager->time = ppg_default_time;
@@ -26,6 +30,66 @@ void ppg_time_manager_init(PPG_Time_Manager *time_manager)
    time_manager->compare_times = ppg_default_time_comparison;
 }
 
+void ppg_monotonic_time_difference(PPG_Time time1, 
+                                   PPG_Time time2, 
+                                   PPG_Time *delta)
+{
+   *delta = ppg_time_integer_difference(time1, time2);
+}
+
+PPG_Time_Comparison_Result_Type ppg_monotonic_time_comparison(
+                        PPG_Time time1,
+                        PPG_Time time2)
+{
+   return ppg_time_integer_comparison(time1, time2);
+}
+
+#if defined(__linux__) && !defined(PPG_DISABLE_MONOTONIC_TIME)
+
+// CLOCK_MONOTONIC_COARSE is Linux specific and might be 
+// unavailable with old C libraries
+//
+#ifdef CLOCK_MONOTONIC_COARSE
+#define PPG_CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC_COARSE
+#else
+#define PPG_CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC
+#endif
+
+static void ppg_monotonic_clock_time(clockid_t clock, PPG_Time *time)
+{
+   struct timespec ts;
+   
+   clock_gettime(clock, &ts);
+   
+   #if PPG_TIME_NS
+   *time = (PPG_Time)ts.tv_sec*1000000000 + (PPG_Time)ts.tv_nsec;
+   #else
+   *time = (PPG_Time)ts.tv_sec*1000 + (PPG_Time)(ts.tv_nsec/1000000);
+   #endif
+}
+
+void ppg_monotonic_time(PPG_Time *time)
+{
+   ppg_monotonic_clock_time(CLOCK_MONOTONIC, time);
+}
+
+void ppg_monotonic_coarse_time(PPG_Time *time)
+{
+   ppg_monotonic_clock_time(PPG_CLOCK_MONOTONIC_COARSE, time);
+}
+
+void ppg_time_manager_init_monotonic(PPG_Time_Manager *time_manager,
+                                     PPG_Monotonic_Clock clock)
+{
+   time_manager->time 
+      = (clock == PPG_Monotonic_Clock_Coarse) ? ppg_monotonic_coarse_time
+                                              : ppg_monotonic_time;
+   time_manager->time_difference = ppg_monotonic_time_difference;
+   time_manager->compare_times = ppg_monotonic_time_comparison;
+}
+
+#endif
+
 PPG_Time_Manager ppg_global_set_time_manager(PPG_Time_Manager time_manager)
 {
    PPG_Time_Manager old_time_manager = ppg_context->time_manager;
@@ -58,10 +58,121 @@ typedef struct {
    PPG_Time_Comparison_Fun compare_times; ///< Compares time values
 } PPG_Time_Manager;
 
+/** @brief The number of time units per second that are used 
+ *         by the built-in time managers
+ */
+#if PPG_TIME_NS
+#define PPG_TIME_UNITS_PER_SECOND 1000000000LL
+#else
+#define PPG_TIME_UNITS_PER_SECOND 1000LL
+#endif
+
+/** @brief Computes the difference time2 - time1 of monotonic integer time values
+ * 
+ * The difference is computed with unsigned wrap-around. 
+ * This function can be inlined. 
+ * 
+ * @param time1 The first time value
+ * @param time2 The second time value
+ * @returns The difference
+ */
+inline
+static PPG_Time ppg_time_integer_difference(PPG_Time time1, 
+                                            PPG_Time time2)
+{
+   return (PPG_Time)(time2 - time1);
+}
+
+/** @brief Compares monotonic integer time values
+ * 
+ * The comparison is based on the sign of the wrapped difference 
+ * time1 - time2. It thus remains correct when the time values 
+ * wrap around, as long as they are less than half the range of 
+ * PPG_Time apart. This function can be inlined. 
+ * 
+ * @param time1 The first time value
+ * @param time2 The second time value
+ * @returns A positive value if time1 is greater than time2, a negative value
+ *          if it is less and zero if both are equal
+ */
+inline
+static PPG_Time_Comparison_Result_Type ppg_time_integer_comparison(
+                        PPG_Time time1,
+                        PPG_Time time2)
+{
+   PPG_Time delta = (PPG_Time)(time1 - time2);
+   
+   if(delta == 0) { return 0; }
+   
+   // The upper half of the range represents negative differences.
+   // Testing this explicitly is independent of the width of PPG_Time.
+   //
+   return (delta <= ((PPG_Time)-1)/2) ? 1 : -1;
+}
+
+/** @brief A time difference function for monotonic integer time values
+ * 
+ * This function can be used as time_difference member of a time manager.
+ * The engine recognizes it and inlines the computation.
+ */
+void ppg_monotonic_time_difference(PPG_Time time1, 
+                                   PPG_Time time2, 
+                                   PPG_Time *delta);
+
+/** @brief A time comparison function for monotonic integer time values
+ * 
+ * This function can be used as compare_times member of a time manager.
+ * The engine recognizes it and inlines the computation.
+ */
+PPG_Time_Comparison_Result_Type ppg_monotonic_time_comparison(
+                        PPG_Time time1,
+                        PPG_Time time2);
+
 /** @brief Initializes a time manager
  */
 void ppg_time_manager_init(PPG_Time_Manager *time_manager);
 
+#if defined(__linux__) && !defined(PPG_DISABLE_MONOTONIC_TIME)
+
+/** @brief The clocks that the built-in Linux time manager can use
+ */
+typedef enum {
+   PPG_Monotonic_Clock_Precise = 0, ///< CLOCK_MONOTONIC
+   PPG_Monotonic_Clock_Coarse ///< CLOCK_MONOTONIC_COARSE, faster to read but with a resolution of one scheduler tick
+} PPG_Monotonic_Clock;
+
+/** @brief Retreives the current time from CLOCK_MONOTONIC
+ * 
+ * The unit is nanoseconds if PPG_TIME_NS is set 
+ * and milliseconds otherwise.
+ * 
+ * @param time The pointer to the time value to receive current time
+ */
+void ppg_monotonic_time(PPG_Time *time);
+
+/** @brief Retreives the current time from CLOCK_MONOTONIC_COARSE
+ * 
+ * The unit is the same as for ppg_monotonic_time.
+ * 
+ * @param time The pointer to the time value to receive current time
+ */
+void ppg_monotonic_coarse_time(PPG_Time *time);
+
+/** @brief Initializes a time manager that is based on a Linux monotonic clock
+ * 
+ * The timeout set by ppg_global_set_timeout must be specified in 
+ * the same unit, see PPG_TIME_UNITS_PER_SECOND. To arm a timerfd, 
+ * pass 1000000000/PPG_TIME_UNITS_PER_SECOND as the number of nanoseconds
+ * per time unit to ppg_timeout_update_timerfd.
+ * 
+ * @param time_manager The time manager to initialize
+ * @param clock The clock to read
+ */
+void ppg_time_manager_init_monotonic(PPG_Time_Manager *time_manager,
+                                     PPG_Monotonic_Clock clock);
+
+#endif
+
 /** @brief Sets a new global time manager
  * 
  * @param time_manager The new time manager
@@ -21,6 +21,59 @@
 #include "detail/ppg_signal_detail.h"
 #include "detail/ppg_event_buffer_detail.h"
 #include "detail/ppg_pattern_matching_detail.h"
+#include "detail/ppg_timeout_detail.h"
+#include "detail/ppg_time_detail.h"
+
+#if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+#include <sys/timerfd.h>
+#include <time.h>
+#endif
+
+// In event time mode or if the time manager uses monotonic integer 
+// arithmetic, time arithmetic is inlined. Otherwise it is delegated 
+// to the time manager.
+//
+static PPG_Time ppg_timeout_time_difference(PPG_Time time1, PPG_Time time2)
+{
+   if(   ppg_context->properties.event_time_enabled
+      || (  ppg_context->time_manager.time_difference 
+         == ppg_monotonic_time_difference)) {
+      return ppg_time_integer_difference(time1, time2);
+   }
+   
+   PPG_ASSERT(ppg_context->time_manager.time_difference);
+   
+   PPG_Time delta;
+   ppg_context->time_manager.time_difference(time1, time2, &delta);
+   
+   return delta;
+}
+
+static PPG_Time_Comparison_Result_Type ppg_timeout_compare_times(
+                                             PPG_Time time1,
+                                             PPG_Time time2)
+{
+   if(   ppg_context->properties.event_time_enabled
+      || (  ppg_context->time_manager.compare_times 
+         == ppg_monotonic_time_comparison)) {
+      return ppg_time_integer_comparison(time1, time2);
+   }
+   
+   PPG_ASSERT(ppg_context->time_manager.compare_times);
+   
+   return ppg_context->time_manager.compare_times(time1, time2);
+}
+
+static void ppg_timeout_conclude(void)
+{
+   PPG_LOG("Signaling timeout\n")
+   
+   ppg_signal(PPG_On_Timeout);
+   
+   ppg_delete_stored_events();
+   
+   ppg_reset_pattern_matching_engine();
+}
 
 static void ppg_on_timeout(void)
 {
@@ -28,6 +81,8 @@ static void ppg_on_timeout(void)
    
    PPG_LOG("Processing actions on timeout\n")
    
+   ppg_pattern_matching_synchronize();
+   
    // Check if fallback is possible
    //
    bool action_processed 
@@ -66,15 +121,31 @@ static void ppg_on_timeout(void)
       // branches of the search tree for a pattern match.
       //
       ppg_pattern_matching_process_remaining_branch_options();
+      
+      // If the work budget is exhausted, the timeout is concluded 
+      // when the remaining branch options have been processed
+      // (see ppg_timeout_resume)
+      //
+      if(ppg_context->work_budget.pending) {
+         ppg_context->work_budget.timeout_pending = true;
+         return;
+      }
    }
    
-   PPG_LOG("Signaling timeout\n")
+   ppg_timeout_conclude();
+}
+
+void ppg_timeout_resume(void)
+{
+   if(!ppg_context->work_budget.timeout_pending) { return; }
    
-   ppg_signal(PPG_On_Timeout);
+   ppg_pattern_matching_process_remaining_branch_options();
    
-   ppg_delete_stored_events();
+   if(ppg_context->work_budget.pending) { return; }
    
-   ppg_reset_pattern_matching_engine();
+   ppg_context->work_budget.timeout_pending = false;
+   
+   ppg_timeout_conclude();
 }
 
 bool ppg_timeout_check(void)
@@ -92,31 +163,49 @@ bool ppg_timeout_check(void)
       return false; 
    }
    
-//    PPG_LOG("Chk t.out\n");
-   
    PPG_ASSERT(ppg_context->time_manager.time);
-   PPG_ASSERT(ppg_context->time_manager.time_difference);
-   PPG_ASSERT(ppg_context->time_manager.compare_times);
    
    PPG_Time cur_time;
    
    ppg_context->time_manager.time(&cur_time);
    
-   PPG_Time delta;
-   ppg_context->time_manager.time_difference(
-               ppg_context->time_last_event, 
-               cur_time, 
-               &delta);
+   ppg_work_budget_refill(&ppg_context->work_budget);
+   
+   return ppg_timeout_check_at(cur_time);
+}
+
+bool ppg_timeout_check_at(PPG_Time cur_time)
+{
+   if(!ppg_context->properties.timeout_enabled) { 
+      return false;
+   }
+   
+   // Timeouts are only checked when all previous work has been done
+   //
+   if(ppg_context->work_budget.pending) {
+      return false;
+   }
+   
+   if(ppg_event_buffer_size() == 0) {
+      return false; 
+   }
+   
+//    PPG_LOG("Chk t.out\n");
+   
+   PPG_Time delta 
+      = ppg_timeout_time_difference(ppg_context->time_last_event, 
+                                    cur_time);
    
    bool timeout_hit = false;
    
 //    PPG_LOG("\tdelta: %ld\n", delta);
    
+   // The delta is a duration, not a time stamp. Wrap-aware comparison 
+   // would mistake gaps beyond half the range of PPG_Time for 
+   // negative ones.
+   //
    if(   (ppg_event_buffer_size() != 0)
-      && (ppg_context->time_manager.compare_times(
-               delta,
-               ppg_context->event_timeout
-         ) > 0)
+      && (delta > ppg_context->event_timeout)
      ) {
       
       PPG_LOG("T.out hit\n");
@@ -143,3 +232,77 @@ bool ppg_timeout_set_state(bool state)
    return old_state;
 }
 
+
+bool ppg_timeout_get_deadline_of(PPG_Context *context, PPG_Time *deadline)
+{
+   if(   !context->properties.timeout_enabled
+      || (context->event_buffer.size == 0)) {
+      return false;
+   }
+   
+   // Timeouts are not checked while work is pending. The host must
+   // call ppg_event_process_pending instead of waiting for a deadline
+   // that might already have expired.
+   //
+   if(ppg_work_budget_busy(&context->work_budget)) {
+      return false;
+   }
+   
+   // A timeout is hit when the time since the last event
+   // exceeds the timeout value. Like all time values, the deadline
+   // wraps around and must be compared wrap-aware, see
+   // ppg_time_integer_comparison.
+   //
+   *deadline = (PPG_Time)(  context->time_last_event 
+                          + context->event_timeout + 1);
+   
+   return true;
+}
+
+bool ppg_timeout_get_deadline(PPG_Time *deadline)
+{
+   return ppg_timeout_get_deadline_of(ppg_context, deadline);
+}
+
+#if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+
+int ppg_timeout_update_timerfd(int timerfd, long ns_per_time_unit)
+{
+   struct itimerspec timer_spec = {
+      .it_interval = { .tv_sec = 0, .tv_nsec = 0 },
+      .it_value = { .tv_sec = 0, .tv_nsec = 0 }
+   };
+   
+   PPG_Time deadline;
+   
+   if(ppg_timeout_get_deadline(&deadline)) {
+      
+      PPG_ASSERT(ppg_context->time_manager.time);
+   
+      PPG_Time cur_time;
+      ppg_context->time_manager.time(&cur_time);
+      
+      long long remaining_ns = 0;
+      
+      if(ppg_timeout_compare_times(deadline, cur_time) > 0) {
+         
+         PPG_Time delta = ppg_timeout_time_difference(cur_time, deadline);
+         
+         remaining_ns = (long long)delta*ns_per_time_unit;
+      }
+      
+      // An it_value of zero would disarm the timer. An expired
+      // deadline lets the timer fire immediately.
+      //
+      if(remaining_ns <= 0) {
+         remaining_ns = 1;
+      }
+      
+      timer_spec.it_value.tv_sec = (time_t)(remaining_ns/1000000000LL);
+      timer_spec.it_value.tv_nsec = (long)(remaining_ns%1000000000LL);
+   }
+   
+   return timerfd_settime(timerfd, 0, &timer_spec, NULL);
+}
+
+#endif
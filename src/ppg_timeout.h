@@ -18,6 +18,8 @@
 #define PPG_TIMEOUT_H
 
 /** @file */
+#include "ppg_settings.h"
+
 #include <stdbool.h>
 
 /** @brief Check if timeout happened
@@ -32,4 +34,47 @@ bool ppg_timeout_check(void);
  */
 bool ppg_timeout_set_state(bool state);
 
+/** @brief Retreives the time at which the events that are currently 
+ * stored will time out
+ * 
+ * This allows hosts to sleep until the deadline instead of 
+ * regularly calling ppg_timeout_check. A call to ppg_timeout_check 
+ * at or after the deadline will hit the timeout. 
+ * The deadline is computed as the sum of the time of the last event,
+ * the timeout value and one time unit. The sum wraps around like
+ * the time values do. Compare it with the time manager's compare_times
+ * function rather than with relational operators.
+ * 
+ * While pattern matching work is pending because the work budget
+ * was exhausted (see ppg_event_work_pending), no deadline is reported. 
+ * The host must then call ppg_event_process_pending until no more
+ * work is pending and query the deadline again afterwards.
+ * 
+ * @param deadline Pointer to the time value to receive the deadline
+ * @returns true if a timeout is pending, false if there are
+ *          no stored events, timeout is disabled or work is pending
+ */
+bool ppg_timeout_get_deadline(PPG_Time *deadline);
+
+#if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+
+/** @brief Arms a timerfd to expire at the timeout deadline
+ * 
+ * The timer is disarmed if no timeout is pending or if pattern matching
+ * work is pending (see ppg_timeout_get_deadline). The timerfd
+ * should be created with timerfd_create(CLOCK_MONOTONIC, ...)
+ * and can be waited for with poll or epoll. Call this function
+ * after every call to ppg_event_process and ppg_timeout_check.
+ * The remaining time is computed with respect to the 
+ * current time reported by the time manager.
+ * 
+ * @param timerfd The file descriptor of the timer
+ * @param ns_per_time_unit The number of nanoseconds per time unit
+ * @returns The result of timerfd_settime, i.e. 0 on success and 
+ *          -1 on failure with errno being set
+ */
+int ppg_timeout_update_timerfd(int timerfd, long ns_per_time_unit);
+
+#endif
+
 #endif
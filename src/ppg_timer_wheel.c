@@ -0,0 +1,417 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg_timer_wheel.h"
+#include "ppg_debug.h"
+#include "detail/ppg_timer_wheel_detail.h"
+#include "detail/ppg_context_detail.h"
+#include "detail/ppg_timeout_detail.h"
+#include "detail/ppg_event_detail.h"
+#include "detail/ppg_malloc_detail.h"
+
+#include <stdlib.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+// Every level of the wheel covers PPG_TIMER_WHEEL_N_SLOTS times the
+// range of the level below. Deadlines that are beyond the range
+// of the top level are clamped. The respective contexts are checked
+// and rescheduled when the clamped deadline is reached.
+//
+#define PPG_TIMER_WHEEL_SLOT_BITS 6
+#define PPG_TIMER_WHEEL_N_SLOTS (1 << PPG_TIMER_WHEEL_SLOT_BITS)
+#define PPG_TIMER_WHEEL_SLOT_MASK (PPG_TIMER_WHEEL_N_SLOTS - 1)
+#define PPG_TIMER_WHEEL_N_LEVELS 4
+
+typedef struct PPG_Timer_Wheel_Struct {
+   
+   PPG_Timer_Wheel_Entry *slots[PPG_TIMER_WHEEL_N_LEVELS]
+                               [PPG_TIMER_WHEEL_N_SLOTS];
+   
+   PPG_Time tick_length;
+   
+   // The last tick that was processed
+   //
+   PPG_Time current_tick;
+   
+   size_t n_scheduled;
+   
+   PPG_Timer_Wheel_Entry *registered;
+   
+} PPG_Timer_Wheel;
+
+static bool ppg_timer_wheel_entry_scheduled(PPG_Timer_Wheel_Entry *entry)
+{
+   return entry->prev_next != NULL;
+}
+
+static void ppg_timer_wheel_insert(PPG_Timer_Wheel *timer_wheel,
+                                   PPG_Timer_Wheel_Entry *entry)
+{
+   PPG_ASSERT(entry->expiry >= timer_wheel->current_tick);
+   
+   PPG_Time delta = entry->expiry - timer_wheel->current_tick;
+   
+   int level = 0;
+   
+   while(   (level < PPG_TIMER_WHEEL_N_LEVELS - 1)
+         && (   (delta >> (PPG_TIMER_WHEEL_SLOT_BITS*(level + 1))) 
+             != 0)) {
+      ++level;
+   }
+   
+   // Clamp deadlines that are out of range
+   //
+   if((delta >> (PPG_TIMER_WHEEL_SLOT_BITS*(level + 1))) != 0) {
+      entry->expiry = timer_wheel->current_tick
+         + ((PPG_Time)1 << (PPG_TIMER_WHEEL_SLOT_BITS*(level + 1))) - 1;
+   }
+   
+   PPG_Timer_Wheel_Entry **slot 
+      = &timer_wheel->slots[level]
+               [(entry->expiry >> (PPG_TIMER_WHEEL_SLOT_BITS*level))
+                     & PPG_TIMER_WHEEL_SLOT_MASK];
+   
+   entry->next = *slot;
+   entry->prev_next = slot;
+   
+   if(*slot) {
+      (*slot)->prev_next = &entry->next;
+   }
+   
+   *slot = entry;
+   
+   ++timer_wheel->n_scheduled;
+}
+
+static void ppg_timer_wheel_remove(PPG_Timer_Wheel_Entry *entry)
+{
+   if(!ppg_timer_wheel_entry_scheduled(entry)) { return; }
+   
+   *entry->prev_next = entry->next;
+   
+   if(entry->next) {
+      entry->next->prev_next = entry->prev_next;
+   }
+   
+   entry->next = NULL;
+   entry->prev_next = NULL;
+   
+   --entry->timer_wheel->n_scheduled;
+}
+
+// Moves all entries of a slot to a list whose head is owned by 
+// the caller. The entries remain scheduled. Thus, actions that are 
+// triggered while the list is processed neither reinsert them 
+// elsewhere nor break the list when unregistering them.
+// The caller removes every entry before processing it.
+//
+static void ppg_timer_wheel_move_slot(PPG_Timer_Wheel *timer_wheel,
+                                      int level,
+                                      int slot_id,
+                                      PPG_Timer_Wheel_Entry **list)
+{
+   *list = timer_wheel->slots[level][slot_id];
+   
+   timer_wheel->slots[level][slot_id] = NULL;
+   
+   if(*list) {
+      (*list)->prev_next = list;
+   }
+}
+
+// Moves the entries of the current slot of a level to 
+// the levels below
+//
+static void ppg_timer_wheel_cascade(PPG_Timer_Wheel *timer_wheel, int level)
+{
+   int slot_id = (timer_wheel->current_tick 
+                     >> (PPG_TIMER_WHEEL_SLOT_BITS*level))
+                        & PPG_TIMER_WHEEL_SLOT_MASK;
+   
+   PPG_Timer_Wheel_Entry *list;
+   
+   ppg_timer_wheel_move_slot(timer_wheel, level, slot_id, &list);
+   
+   while(list) {
+      PPG_Timer_Wheel_Entry *entry = list;
+      ppg_timer_wheel_remove(entry);
+      ppg_timer_wheel_insert(timer_wheel, entry);
+   }
+}
+
+void ppg_timer_wheel_schedule(PPG_Timer_Wheel_Entry *entry)
+{
+   if(ppg_timer_wheel_entry_scheduled(entry)) {
+      
+      // The deadline of the context can only have moved on since
+      // the entry was scheduled. The entry is rescheduled
+      // when it fires.
+      //
+      return;
+   }
+   
+   PPG_Timer_Wheel *timer_wheel = entry->timer_wheel;
+   
+   if(ppg_work_budget_busy(&entry->context->work_budget)) {
+      
+      // Pending work is resumed when the next tick fires
+      //
+      entry->expiry = timer_wheel->current_tick + 1;
+   }
+   else {
+      
+      PPG_Time deadline;
+      
+      if(!ppg_timeout_get_deadline_of(entry->context, &deadline)) {
+         return;
+      }
+      
+      entry->expiry = (deadline + timer_wheel->tick_length - 1)
+                           /timer_wheel->tick_length;
+      
+      // The current tick has already been processed
+      //
+      if(entry->expiry <= timer_wheel->current_tick) {
+         entry->expiry = timer_wheel->current_tick + 1;
+      }
+   }
+   
+   ppg_timer_wheel_insert(timer_wheel, entry);
+}
+
+void* ppg_timer_wheel_create(PPG_Time tick_length, PPG_Time now)
+{
+   PPG_ASSERT(tick_length > 0);
+   
+   PPG_Timer_Wheel *timer_wheel 
+      = (PPG_Timer_Wheel *)PPG_MALLOC(sizeof(PPG_Timer_Wheel));
+      
+   for(int level = 0; level < PPG_TIMER_WHEEL_N_LEVELS; ++level) {
+      for(int slot_id = 0; slot_id < PPG_TIMER_WHEEL_N_SLOTS; ++slot_id) {
+         timer_wheel->slots[level][slot_id] = NULL;
+      }
+   }
+   
+   timer_wheel->tick_length = tick_length;
+   timer_wheel->current_tick = now/tick_length;
+   timer_wheel->n_scheduled = 0;
+   timer_wheel->registered = NULL;
+   
+   return timer_wheel;
+}
+
+void ppg_timer_wheel_register_context(void *timer_wheel, void *context)
+{
+   PPG_Timer_Wheel *timer_wheel__ = (PPG_Timer_Wheel *)timer_wheel;
+   PPG_Context *context__ = (PPG_Context *)context;
+   
+   PPG_ASSERT(!context__->timer_wheel_entry);
+   
+   PPG_Timer_Wheel_Entry *entry 
+      = (PPG_Timer_Wheel_Entry *)PPG_MALLOC(sizeof(PPG_Timer_Wheel_Entry));
+   
+   entry->next = NULL;
+   entry->prev_next = NULL;
+   
+   entry->next_registered = timer_wheel__->registered;
+   entry->prev_next_registered = &timer_wheel__->registered;
+   
+   if(timer_wheel__->registered) {
+      timer_wheel__->registered->prev_next_registered 
+         = &entry->next_registered;
+   }
+   
+   timer_wheel__->registered = entry;
+   
+   entry->timer_wheel = timer_wheel__;
+   entry->context = context__;
+   entry->expiry = 0;
+   
+   context__->timer_wheel_entry = entry;
+   
+   // The context might already have stored events
+   //
+   ppg_timer_wheel_schedule(entry);
+}
+
+void ppg_timer_wheel_unregister_context(void *context)
+{
+   PPG_Context *context__ = (PPG_Context *)context;
+   
+   PPG_Timer_Wheel_Entry *entry = context__->timer_wheel_entry;
+   
+   if(!entry) { return; }
+   
+   ppg_timer_wheel_remove(entry);
+   
+   *entry->prev_next_registered = entry->next_registered;
+   
+   if(entry->next_registered) {
+      entry->next_registered->prev_next_registered 
+         = entry->prev_next_registered;
+   }
+   
+   context__->timer_wheel_entry = NULL;
+   
+   free(entry);
+}
+
+void ppg_timer_wheel_destroy(void *timer_wheel)
+{
+   PPG_Timer_Wheel *timer_wheel__ = (PPG_Timer_Wheel *)timer_wheel;
+   
+   while(timer_wheel__->registered) {
+      ppg_timer_wheel_unregister_context(
+            timer_wheel__->registered->context);
+   }
+   
+   free(timer_wheel__);
+}
+
+// Checks the timeout of the context of a fired entry 
+// and reschedules it if it still has stored events
+//
+static bool ppg_timer_wheel_fire(PPG_Timer_Wheel_Entry *entry, PPG_Time now)
+{
+   PPG_Context *old_context = ppg_context;
+   
+   ppg_context = entry->context;
+   
+   // Like ppg_event_process_pending, a fired entry grants a fresh 
+   // budget. Timeouts are only checked after pending work is done.
+   //
+   ppg_work_budget_refill(&ppg_context->work_budget);
+   
+   ppg_event_resume_work();
+   
+   bool timeout_hit = ppg_timeout_check_at(now);
+   
+   ppg_timer_wheel_schedule(entry);
+   
+   ppg_context = old_context;
+   
+   return timeout_hit;
+}
+
+// Determines the next tick at which either an occupied slot of 
+// the lowest level fires or an occupied slot of a higher level 
+// is cascaded. Every level is searched for one revolution.
+//
+static PPG_Time ppg_timer_wheel_next_tick(PPG_Timer_Wheel *timer_wheel)
+{
+   PPG_Time next_tick = 0;
+   bool found = false;
+   
+   for(int level = 0; level < PPG_TIMER_WHEEL_N_LEVELS; ++level) {
+      
+      int shift = PPG_TIMER_WHEEL_SLOT_BITS*level;
+      
+      // The slots of a level are processed at multiples of 
+      // the level's tick range
+      //
+      PPG_Time tick = (timer_wheel->current_tick >> shift) << shift;
+      
+      for(int i = 0; i < PPG_TIMER_WHEEL_N_SLOTS; ++i) {
+         
+         tick += (PPG_Time)1 << shift;
+         
+         if(found && (tick >= next_tick)) { break; }
+         
+         if(timer_wheel->slots[level]
+                  [(tick >> shift) & PPG_TIMER_WHEEL_SLOT_MASK]) {
+            next_tick = tick;
+            found = true;
+            break;
+         }
+      }
+   }
+   
+   PPG_ASSERT(found);
+   
+   return next_tick;
+}
+
+size_t ppg_timer_wheel_advance(void *timer_wheel, PPG_Time now)
+{
+   PPG_Timer_Wheel *timer_wheel__ = (PPG_Timer_Wheel *)timer_wheel;
+   
+   PPG_Time now_tick = now/timer_wheel__->tick_length;
+   
+   size_t n_timeouts = 0;
+   
+   while(timer_wheel__->current_tick < now_tick) {
+      
+      // Nothing to do for an empty wheel
+      //
+      if(timer_wheel__->n_scheduled == 0) {
+         timer_wheel__->current_tick = now_tick;
+         break;
+      }
+      
+      // Skip all ticks without work
+      //
+      PPG_Time next_tick = ppg_timer_wheel_next_tick(timer_wheel__);
+      
+      if(next_tick > now_tick) {
+         timer_wheel__->current_tick = now_tick;
+         break;
+      }
+      
+      timer_wheel__->current_tick = next_tick;
+      
+      // Whenever a level wraps around, the next slot 
+      // of the level above is distributed to the levels below
+      //
+      for(int level = 1; level < PPG_TIMER_WHEEL_N_LEVELS; ++level) {
+         
+         if(((timer_wheel__->current_tick 
+                  >> (PPG_TIMER_WHEEL_SLOT_BITS*(level - 1)))
+                     & PPG_TIMER_WHEEL_SLOT_MASK) != 0) {
+            break;
+         }
+         
+         ppg_timer_wheel_cascade(timer_wheel__, level);
+      }
+      
+      PPG_Timer_Wheel_Entry *list;
+      
+      ppg_timer_wheel_move_slot(
+               timer_wheel__, 
+               0, 
+               timer_wheel__->current_tick & PPG_TIMER_WHEEL_SLOT_MASK,
+               &list);
+      
+      // Every entry is unlinked before it fires. Actions may 
+      // schedule or unregister any entry, including those that 
+      // are still in the list.
+      //
+      while(list) {
+         
+         PPG_Timer_Wheel_Entry *entry = list;
+         
+         ppg_timer_wheel_remove(entry);
+         
+         if(ppg_timer_wheel_fire(entry, now)) {
+            ++n_timeouts;
+         }
+      }
+   }
+   
+   return n_timeouts;
+}
+
+#endif
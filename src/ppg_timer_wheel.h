@@ -0,0 +1,87 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_TIMER_WHEEL_H
+#define PPG_TIMER_WHEEL_H
+
+/** @file */
+
+#include "ppg_settings.h"
+
+#include <stddef.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+
+/* A timer wheel keeps track of the timeouts of many contexts. 
+ * Instead of calling ppg_timeout_check for every context, the host 
+ * regularly advances the timer wheel that only checks those contexts 
+ * whose timeout deadline has passed.
+ * 
+ * The timer wheel requires time values to be integral with 
+ * time differences computed by plain subtraction.
+ * All registered contexts and the host must use the same time base.
+ */
+
+/** @brief Creates a new timer wheel
+ * 
+ * @param tick_length The resolution of the timer wheel in time units
+ * @param now The current time
+ * @returns The newly created timer wheel
+ */
+void* ppg_timer_wheel_create(PPG_Time tick_length, PPG_Time now);
+
+/** @brief Destroys a timer wheel
+ * 
+ * All contexts that are still registered are unregistered.
+ * 
+ * @param timer_wheel The timer wheel to destroy
+ */
+void ppg_timer_wheel_destroy(void *timer_wheel);
+
+/** @brief Registers a context with a timer wheel
+ * 
+ * From now on the timeout of the context is checked by the
+ * timer wheel. A context can only be registered with a single timer wheel.
+ * Destroying a context automatically unregisters it.
+ * 
+ * @param timer_wheel The timer wheel
+ * @param context The context to register
+ */
+void ppg_timer_wheel_register_context(void *timer_wheel, void *context);
+
+/** @brief Unregisters a context from its timer wheel
+ * 
+ * @param context The context to unregister
+ */
+void ppg_timer_wheel_unregister_context(void *context);
+
+/** @brief Advances a timer wheel to the given time
+ * 
+ * Timeout processing is triggered for all registered contexts
+ * whose timeout deadline has passed. Contexts with pending
+ * work (see ppg_event_process_pending) are resumed with a fresh 
+ * work budget at every tick until their work is done.
+ * Ticks without scheduled contexts are skipped.
+ * 
+ * @param timer_wheel The timer wheel
+ * @param now The current time
+ * @returns The number of contexts that hit a timeout
+ */
+size_t ppg_timer_wheel_advance(void *timer_wheel, PPG_Time now);
+
+#endif
+
+#endif
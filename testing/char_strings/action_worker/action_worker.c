@@ -0,0 +1,113 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+
+#if PPG_HAVE_ACTION_WORKER
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// Passes a string of events to the current context without 
+// checking the results
+//
+static void ppg_cs_feed(char *event_string)
+{
+   for(int i = 0; event_string[i] != '\0'; ++i) {
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+         .time = 0,
+         .flags = isupper(event_string[i]) ? 
+                        PPG_Event_Active : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ppg_event_process(&event);
+   }
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord_1)
+   PPG_CS_REGISTER_ACTION(Chord_2)
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord_1),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b')
+      )
+   );
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord_2),
+      PPG_INPUTS(
+         PPG_CS_CHAR('c'),
+         PPG_CS_CHAR('d')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   // A small queue makes pattern matching wait for the worker
+   //
+   void *worker = ppg_action_worker_create(1);
+   
+   PPG_CS_CHECK(worker);
+   
+   PPG_Action_Dispatcher previous_dispatcher 
+      = ppg_global_set_action_dispatcher(
+                     ppg_action_worker_get_dispatcher(worker));
+   
+   ppg_cs_feed("ABbaCDdcABba");
+   
+   ppg_action_worker_flush(worker);
+   
+   // Actions are executed in order
+   //
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord_1),
+                              PPG_CS_A(Chord_2),
+                              PPG_CS_A(Chord_1)
+                           )
+   );
+   
+   ppg_global_set_action_dispatcher(previous_dispatcher);
+   
+   ppg_action_worker_destroy(worker);
+   
+   // Actions are called directly again
+   //
+   PPG_CS_PROCESS_STRING(  "C D d c",
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord_2)
+                           )
+   );
+   
+PPG_CS_END_TEST
+
+#endif
@@ -0,0 +1,167 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+#include <stdlib.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+typedef struct {
+   int n_allocations;
+   int n_frees;
+} PPG_CS_Heap_Counts;
+
+static void *ppg_cs_heap_alloc(size_t n_bytes, void *user_data)
+{
+   ++((PPG_CS_Heap_Counts *)user_data)->n_allocations;
+   return malloc(n_bytes);
+}
+
+static void *ppg_cs_heap_realloc(void *memory, size_t n_bytes, void *user_data)
+{
+   if(!memory) {
+      ++((PPG_CS_Heap_Counts *)user_data)->n_allocations;
+   }
+   return realloc(memory, n_bytes);
+}
+
+static void ppg_cs_heap_free(void *memory, void *user_data)
+{
+   ++((PPG_CS_Heap_Counts *)user_data)->n_frees;
+   free(memory);
+}
+
+#define PPG_CS_ADD_CHORD \
+   ppg_chord( \
+      ppg_cs_layer_0, \
+      PPG_CS_ACTION(Chord), \
+      PPG_INPUTS( \
+         PPG_CS_CHAR('a'), \
+         PPG_CS_CHAR('b'), \
+         PPG_CS_CHAR('c') \
+      ) \
+   );
+
+static long long ppg_cs_fixed_buffer[16384];
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   
+   void *context_1 = ppg_global_get_current_context();
+   
+   //***********************************************
+   // Pool allocator
+   //***********************************************
+   
+   PPG_CS_Heap_Counts counts = { .n_allocations = 0, .n_frees = 0 };
+   
+   void *pool = ppg_pool_allocator_create(
+      (PPG_Allocator) {
+         .alloc = ppg_cs_heap_alloc,
+         .realloc = ppg_cs_heap_realloc,
+         .free = ppg_cs_heap_free,
+         .user_data = (void*)&counts
+      },
+      65536
+   );
+   
+   void *context_2 
+      = ppg_context_create_with_allocator(ppg_pool_allocator_get_allocator(pool));
+      
+   ppg_global_set_current_context(context_2);
+   
+   PPG_CS_PREPARE_CONTEXT
+   
+   PPG_CS_CHECK(ppg_global_get_allocator().user_data == pool);
+   
+   PPG_CS_ADD_CHORD
+   
+   ppg_cs_compile();
+   
+   PPG_CS_PROCESS_STRING(  "A B C c b a",
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   // The reserved memory suffices, so the backing allocator
+   // is not called during pattern matching
+   //
+   int n_allocations = counts.n_allocations;
+   
+   PPG_CS_PROCESS_STRING(  "A B C c b a",
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   PPG_CS_CHECK(counts.n_allocations == n_allocations);
+   
+   ppg_global_set_current_context(context_1);
+   
+   ppg_context_destroy(context_2);
+   
+   ppg_pool_allocator_destroy(pool);
+   
+   PPG_CS_CHECK(counts.n_frees == counts.n_allocations);
+   
+   //***********************************************
+   // Fixed buffer allocator
+   //***********************************************
+   
+   void *context_3 
+      = ppg_context_create_with_allocator(
+            ppg_fixed_buffer_allocator((void*)ppg_cs_fixed_buffer, 
+                                       sizeof(ppg_cs_fixed_buffer)));
+   
+   ppg_global_set_current_context(context_3);
+   
+   PPG_CS_PREPARE_CONTEXT
+   
+   PPG_CS_ADD_CHORD
+   
+   ppg_cs_compile();
+   
+   size_t n_used = ppg_fixed_buffer_allocator_get_n_used(
+                                          (void*)ppg_cs_fixed_buffer);
+   PPG_CS_CHECK(n_used > 0);
+   PPG_CS_CHECK(n_used <= sizeof(ppg_cs_fixed_buffer));
+   
+   PPG_CS_PROCESS_STRING(  "A B C c b a",
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   ppg_global_set_current_context(context_1);
+   
+   ppg_context_destroy(context_3);
+   
+PPG_CS_END_TEST
+
+#endif
@@ -16,12 +16,33 @@
 
 #include "papageno_char_strings.h"
 
+#include <ctype.h>
+
 #if !PPG_DISABLE_CONTEXT_SWITCHING
    
 enum {
    ppg_cs_layer_0 = 0
 };
 
+// Passes a string of events to a context that is not necessarily 
+// the current context
+//
+static void ppg_cs_feed_context(void *context, char *event_string)
+{
+   for(int i = 0; event_string[i] != '\0'; ++i) {
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+         .time = 0,
+         .flags = isupper(event_string[i]) ? 
+                        PPG_Event_Active : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ppg_ctx_event_process(context, &event);
+   }
+}
+
 // To check context switching, we register the same chord with
 // different actions on two contexts.
 
@@ -108,13 +129,65 @@ PPG_CS_START_TEST
    );
    
 
+   //***********************************************
+   // Feed context 2 while context 1 is current
+   //***********************************************
+   
+   ppg_cs_feed_context(context_2, "ABCcba");
+   
+   PPG_CS_CHECK(ppg_global_get_current_context() == context_1);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord_2)
+                           )
+   );
+
+   //***********************************************
+   // Share the pattern tree of context 1
+   //***********************************************
+   
+   void *shared_context = ppg_context_create_shared(context_1);
+   
+   // Start a chord in the shared context and complete
+   // the same chord in context 1 in between. Both
+   // contexts must keep track of their matching state
+   // independently.
+   //
+   ppg_cs_feed_context(shared_context, "AB");
+   ppg_cs_feed_context(context_1, "ABCcba");
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord_1)
+                           )
+   );
+   
+   ppg_cs_feed_context(shared_context, "Ccba");
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord_1)
+                           )
+   );
+
    //***********************************************
    // Cleanup
    //***********************************************
    
-   // Context 2 is currently inactive, so we can safely destroy it
+   // Context 2 and the shared context are currently inactive, 
+   // so we can safely destroy them. The shared context 
+   // must be destroyed before the context that owns 
+   // the pattern tree.
    //
    ppg_context_destroy(context_2); 
+   ppg_context_destroy(shared_context); 
    
    // Note: Context 1 is still active and will be destroyed during 
    //       an automatic call to ppg_global_finalize
@@ -0,0 +1,227 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING && PPG_HAVE_ACTION_WORKER
+
+#include <pthread.h>
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+typedef struct {
+   void *context;
+   void *current_context_before;
+   void *current_context_after;
+} PPG_CS_Thread_Data;
+
+// Feeds a context from a second thread and records the
+// current context as seen by that thread
+//
+static void *ppg_cs_thread_main(void *user_data)
+{
+   PPG_CS_Thread_Data *data = (PPG_CS_Thread_Data *)user_data;
+   
+   data->current_context_before = ppg_global_get_current_context();
+   
+   char *event_string = "ABCcba";
+   
+   for(int i = 0; event_string[i] != '\0'; ++i) {
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+         .time = 0,
+         .flags = isupper(event_string[i]) ? 
+                        PPG_Event_Active : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ppg_ctx_event_process(data->context, &event);
+   }
+   
+   data->current_context_after = ppg_global_get_current_context();
+   
+   return NULL;
+}
+
+typedef struct {
+   void *context;
+   int n_iterations;
+   int n_context_changes;
+} PPG_CS_Concurrent_Data;
+
+static void ppg_cs_count_match(bool activation, void *user_data)
+{
+   if(activation) {
+      __atomic_fetch_add((int *)user_data, 1, __ATOMIC_SEQ_CST);
+   }
+}
+
+// Feeds a context repeatedly and counts how often the 
+// current context of the thread changed in between
+//
+static void *ppg_cs_concurrent_main(void *user_data)
+{
+   PPG_CS_Concurrent_Data *data = (PPG_CS_Concurrent_Data *)user_data;
+   
+   void *current_context = ppg_global_get_current_context();
+   
+   char *event_string = "ABCcba";
+   
+   for(int n = 0; n < data->n_iterations; ++n) {
+      for(int i = 0; event_string[i] != '\0'; ++i) {
+         
+         PPG_Event event = {
+            .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+            .time = 0,
+            .flags = isupper(event_string[i]) ? 
+                           PPG_Event_Active : PPG_Event_Flags_Empty,
+            .groupId = 0
+         };
+         
+         ppg_ctx_event_process(data->context, &event);
+         
+         if(ppg_global_get_current_context() != current_context) {
+            ++data->n_context_changes;
+         }
+      }
+   }
+   
+   return NULL;
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord_2)
+   
+   void* context_2 = ppg_context_create();
+   void* context_1 = ppg_global_set_current_context(context_2);
+   
+   PPG_CS_PREPARE_CONTEXT
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord_2),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   ppg_global_set_current_context(context_1);
+   
+   PPG_CS_Thread_Data data = {
+      .context = context_2,
+      .current_context_before = NULL,
+      .current_context_after = NULL
+   };
+   
+   pthread_t thread;
+   
+   int result = pthread_create(&thread, NULL, ppg_cs_thread_main, &data);
+   PPG_CS_CHECK(result == 0);
+   
+   pthread_join(thread, NULL);
+   
+   // With thread local contexts, a new thread starts 
+   // without current context. Otherwise, all threads share 
+   // the current context.
+   //
+   if(ppg_global_is_context_thread_local()) {
+      PPG_CS_CHECK(data.current_context_before == NULL);
+      PPG_CS_CHECK(data.current_context_after == NULL);
+   }
+   else {
+      PPG_CS_CHECK(data.current_context_before == context_1);
+      PPG_CS_CHECK(data.current_context_after == context_1);
+   }
+   
+   PPG_CS_CHECK(ppg_global_get_current_context() == context_1);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord_2)
+                           )
+   );
+   
+   ppg_context_destroy(context_2);
+   
+   // Two threads concurrently feed two contexts that share a pattern tree
+   //
+   if(ppg_global_is_context_thread_local()) {
+      
+      int n_matches = 0;
+      
+      void *context_3 = ppg_context_create();
+      ppg_global_set_current_context(context_3);
+      
+      ppg_chord(
+         ppg_cs_layer_0,
+         PPG_CS_ACTION_CALLBACK(ppg_cs_count_match, &n_matches),
+         PPG_INPUTS(
+            PPG_CS_CHAR('a'),
+            PPG_CS_CHAR('b'),
+            PPG_CS_CHAR('c')
+         )
+      );
+      
+      ppg_global_compile();
+      
+      void *context_4 = ppg_context_create_shared(context_3);
+      
+      ppg_global_set_current_context(context_1);
+      
+      PPG_CS_Concurrent_Data data_3 = {
+         .context = context_3, .n_iterations = 1000, .n_context_changes = 0
+      };
+      PPG_CS_Concurrent_Data data_4 = {
+         .context = context_4, .n_iterations = 1000, .n_context_changes = 0
+      };
+      
+      pthread_t thread_3, thread_4;
+      
+      result = pthread_create(&thread_3, NULL, ppg_cs_concurrent_main, &data_3);
+      PPG_CS_CHECK(result == 0);
+      
+      result = pthread_create(&thread_4, NULL, ppg_cs_concurrent_main, &data_4);
+      PPG_CS_CHECK(result == 0);
+      
+      pthread_join(thread_3, NULL);
+      pthread_join(thread_4, NULL);
+      
+      PPG_CS_CHECK(data_3.n_context_changes == 0);
+      PPG_CS_CHECK(data_4.n_context_changes == 0);
+      PPG_CS_CHECK(n_matches == 2000);
+      
+      PPG_CS_CHECK(ppg_global_get_current_context() == context_1);
+      
+      ppg_context_destroy(context_4);
+      ppg_context_destroy(context_3);
+   }
+   
+PPG_CS_END_TEST
+
+#endif
@@ -0,0 +1,208 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+   
+#include <string.h>
+   
+enum {
+   ppg_cs_layer_0 = 0,
+   ppg_cs_layer_1 = 1
+};
+
+// The leader sequence that follows the leader e on layer 1
+//
+static int ppg_cs_sequence_action = 0;
+
+static void ppg_cs_retreive_string(uint8_t sequence_id,
+                                   char *buffer, 
+                                   uint8_t max_chars)
+{
+   PPG_UNUSED(sequence_id);
+   PPG_UNUSED(max_chars);
+   
+   strcpy(buffer, "f");
+}
+
+static PPG_Action ppg_cs_retreive_action(uint8_t sequence_id)
+{
+   PPG_UNUSED(sequence_id);
+   
+   return (PPG_Action) {
+      .callback = (PPG_Action_Callback) {
+         .func = (PPG_Action_Callback_Fun)ppg_cs_process_action,
+         .user_data = (void*)(uintptr_t)ppg_cs_sequence_action
+      }
+   };
+}
+
+static PPG_Input_Id ppg_cs_input_from_char(char c)
+{
+   return PPG_CS_CHAR(c);
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Short_Action)
+   PPG_CS_REGISTER_ACTION(Long_Action_1)
+   PPG_CS_REGISTER_ACTION(Long_Action_2)
+   PPG_CS_REGISTER_ACTION(Other_Action)
+   PPG_CS_REGISTER_ACTION(Leader_Action)
+   PPG_CS_REGISTER_ACTION(Sequence_Action)
+   
+   // The pattern a is a strict prefix of the patterns a b and a c. 
+   // All patterns are defined on the active layer.
+   //
+   ppg_pattern(
+      ppg_cs_layer_0, /* Layer id */
+      PPG_TOKENS(
+         ppg_token_set_action(
+            PPG_CS_N('a'),
+            PPG_CS_ACTION(Short_Action)
+         ),
+         ppg_token_set_action(
+            PPG_CS_N('b'),
+            PPG_CS_ACTION(Long_Action_1)
+         )
+      )
+   );
+   
+   ppg_pattern(
+      ppg_cs_layer_0, /* Layer id */
+      PPG_TOKENS(
+         ppg_token_set_action(
+            PPG_CS_N('a'),
+            PPG_CS_ACTION(Short_Action)
+         ),
+         ppg_token_set_action(
+            PPG_CS_N('c'),
+            PPG_CS_ACTION(Long_Action_2)
+         )
+      )
+   );
+   
+   // A pattern that does not share a prefix with the others
+   //
+   ppg_pattern(
+      ppg_cs_layer_0, /* Layer id */
+      PPG_TOKENS(
+         ppg_token_set_action(
+            PPG_CS_N('d'),
+            PPG_CS_ACTION(Other_Action)
+         )
+      )
+   );
+   
+   // The leader e carries an action on layer 0. Its only 
+   // continuation is defined for layer 1.
+   //
+   PPG_Token leader_token
+      = ppg_pattern(
+         ppg_cs_layer_0, /* Layer id */
+         PPG_TOKENS(
+            ppg_token_set_action(
+               PPG_CS_N('e'),
+               PPG_CS_ACTION(Leader_Action)
+            )
+         )
+      );
+   
+   ppg_cs_sequence_action = PPG_CS_ACTION_VAR(Sequence_Action);
+   
+   ppg_alphabetic_leader_sequences(
+      ppg_cs_layer_1, /* Layer id */
+      leader_token,
+      1,
+      (PPG_Leader_Functions) {
+         .retreive_string = ppg_cs_retreive_string,
+         .retreive_action = ppg_cs_retreive_action,
+         .input_from_char = ppg_cs_input_from_char
+      },
+      false /* no fallback */
+   );
+   
+   ppg_cs_compile();
+   
+   ppg_global_set_layer(ppg_cs_layer_0);
+   
+   // While the longer patterns can continue the match, 
+   // it must wait for further events
+   //
+   PPG_CS_PROCESS_STRING(  "A a", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // A longer pattern is committed as soon as its last input
+   // is activated. The action of the prefix is not triggered.
+   //
+   PPG_CS_PROCESS_STRING(  "C", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_ACTION_EXPECTATION(Long_Action_2, true)
+                           )
+   );
+   
+   PPG_CS_PROCESS_STRING(  "c", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_ACTION_EXPECTATION(Long_Action_2, false)
+                           )
+   );
+   
+   // Without further events, the prefix is committed on timeout
+   //
+   PPG_CS_PROCESS_STRING(  "A a |", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Short_Action)
+                           )
+   );
+   
+   // The continuation of the leader cannot be entered on layer 0. 
+   // Thus, the leader is committed without waiting for a timeout.
+   //
+   PPG_CS_PROCESS_STRING(  "E e", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Leader_Action)
+                           )
+   );
+   
+   // On layer 1, the leader must wait for its continuation
+   //
+   ppg_global_set_layer(ppg_cs_layer_1);
+   
+   PPG_CS_PROCESS_STRING(  "E e", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_PROCESS_STRING(  "F f", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Sequence_Action)
+                           )
+   );
+   
+PPG_CS_END_TEST
@@ -0,0 +1,160 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+#include <string.h>
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// The number of notes of the long pattern. Every note
+// causes two events. Thus, the pattern exceeds the initial 
+// capacity of the event buffer.
+//
+#define PPG_CS_N_LONG_NOTES PPG_MAX_EVENTS
+
+// Writes the on-off string of the first n_notes notes 
+// of the long pattern
+//
+static void ppg_cs_long_pattern_string(int n_notes, char *string)
+{
+   for(int i = 0; i < n_notes; ++i) {
+      char c = (i % 2 == 0) ? 'a' : 'b';
+      string[2*i] = (char)toupper(c);
+      string[2*i + 1] = c;
+   }
+   string[2*n_notes] = '\0';
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Short)
+   PPG_CS_REGISTER_ACTION(Long)
+   
+   ppg_pattern(
+      ppg_cs_layer_0,
+      PPG_TOKENS(
+         PPG_CS_N('x'),
+         ppg_token_set_action(
+            PPG_CS_N('y'),
+            PPG_CS_ACTION(Short)
+         )
+      )
+   );
+   
+   PPG_Token long_tokens[PPG_CS_N_LONG_NOTES];
+   
+   for(int i = 0; i < PPG_CS_N_LONG_NOTES; ++i) {
+      long_tokens[i] = PPG_CS_N((i % 2 == 0) ? 'a' : 'b');
+   }
+   
+   ppg_token_set_action(long_tokens[PPG_CS_N_LONG_NOTES - 1],
+                        PPG_CS_ACTION(Long));
+   
+   ppg_pattern(ppg_cs_layer_0, PPG_CS_N_LONG_NOTES, long_tokens);
+   
+   ppg_cs_compile();
+   
+   size_t initial_capacity = ppg_global_get_event_buffer_capacity();
+   
+   PPG_CS_CHECK(initial_capacity >= PPG_MAX_EVENTS - 1);
+   PPG_CS_CHECK(initial_capacity < 2*PPG_CS_N_LONG_NOTES);
+   
+   // Move the ring positions away from the start of the storage
+   //
+   PPG_CS_PROCESS_STRING(  "XxYy XxYy XxYy", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Short),
+                              PPG_CS_A(Short),
+                              PPG_CS_A(Short)
+                           )
+   );
+   
+   char string[2*PPG_CS_N_LONG_NOTES + 3];
+   
+   // The event buffer grows while the long pattern is matched
+   //
+   ppg_cs_long_pattern_string(PPG_CS_N_LONG_NOTES, string);
+   
+   PPG_CS_PROCESS_STRING(  string, 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Long)
+                           )
+   );
+   
+   size_t grown_capacity = ppg_global_get_event_buffer_capacity();
+   
+   PPG_CS_CHECK(grown_capacity >= 2*PPG_CS_N_LONG_NOTES);
+   
+   // When the long pattern fails, all events are flushed in 
+   // the order of their arrival
+   //
+   ppg_cs_long_pattern_string(PPG_CS_N_LONG_NOTES - 1, string);
+   strcat(string, "Cc");
+   
+   PPG_CS_PROCESS_STRING(  string, 
+                           PPG_CS_EXPECT_FLUSH(string)
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EMF)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_PROCESS_STRING(  "XxYy", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Short)
+                           )
+   );
+   
+   //***********************************************
+   // Reserving space
+   //***********************************************
+   
+   PPG_CS_CHECK(ppg_global_set_event_buffer_capacity(10) == grown_capacity);
+   PPG_CS_CHECK(ppg_global_get_event_buffer_capacity() == grown_capacity);
+   
+   PPG_CS_CHECK(   ppg_global_set_event_buffer_capacity(4*PPG_CS_N_LONG_NOTES) 
+          == grown_capacity);
+   
+   size_t reserved_capacity = ppg_global_get_event_buffer_capacity();
+   
+   PPG_CS_CHECK(reserved_capacity >= 4*PPG_CS_N_LONG_NOTES);
+   
+   // Power of two minus the free slot
+   //
+   PPG_CS_CHECK(((reserved_capacity + 1) & reserved_capacity) == 0);
+   
+   ppg_cs_long_pattern_string(PPG_CS_N_LONG_NOTES, string);
+   
+   PPG_CS_PROCESS_STRING(  string, 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Long)
+                           )
+   );
+   
+   PPG_CS_CHECK(ppg_global_get_event_buffer_capacity() == reserved_capacity);
+   
+PPG_CS_END_TEST
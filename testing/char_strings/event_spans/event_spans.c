@@ -0,0 +1,286 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+#include <string.h>
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+#define PPG_CS_N_X_NOTES 64
+#define PPG_CS_N_LONG_NOTES 20
+
+static char ppg_cs_span_string[256];
+static uint8_t ppg_cs_n_spans = 0;
+
+static void ppg_cs_event_to_string(PPG_Event *event, char *string)
+{
+   char the_char = (char)(uintptr_t)event->input;
+   
+   if(event->flags & PPG_Event_Active) {
+      the_char = (char)toupper(the_char);
+   }
+   
+   size_t length = strlen(string);
+   string[length] = the_char;
+   string[length + 1] = '\0';
+}
+
+static void ppg_cs_process_spans(PPG_Event_Span *spans,
+                                 uint8_t n_spans,
+                                 void *user_data)
+{
+   PPG_UNUSED(user_data);
+   
+   ppg_cs_n_spans = n_spans;
+   
+   for(uint8_t s = 0; s < n_spans; ++s) {
+      
+      size_t n_considered = 0;
+      
+      for(size_t i = 0; i < spans[s].n_events; ++i) {
+         
+         if(spans[s].events[i].flags & PPG_Event_Considered) { 
+            ++n_considered;
+            continue; 
+         }
+         
+         ppg_cs_event_to_string(&spans[s].events[i], ppg_cs_span_string);
+      }
+      
+      PPG_CS_CHECK(n_considered == spans[s].n_considered);
+   }
+}
+
+static int ppg_cs_n_span_calls = 0;
+static size_t ppg_cs_n_span_events = 0;
+
+// Counts the calls and events and passes the events on
+// to the default input processor of the testing system
+//
+static void ppg_cs_forward_spans(PPG_Event_Span *spans,
+                                 uint8_t n_spans,
+                                 void *user_data)
+{
+   ++ppg_cs_n_span_calls;
+   
+   for(uint8_t s = 0; s < n_spans; ++s) {
+      
+      ppg_cs_n_span_events += spans[s].n_events;
+      
+      for(size_t i = 0; i < spans[s].n_events; ++i) {
+         ppg_cs_process_event_callback(&spans[s].events[i], user_data);
+      }
+   }
+}
+
+static void ppg_cs_process_single_event(PPG_Event *event,
+                                        void *user_data)
+{
+   if(event->flags & PPG_Event_Considered) { return; }
+   
+   ppg_cs_event_to_string(event, (char*)user_data);
+}
+
+// Checks that the spans yield the same events as 
+// the event by event iteration
+//
+static void ppg_cs_check_spans(char *expected, uint8_t n_spans_expected)
+{
+   char single_string[256] = "";
+   
+   ppg_cs_span_string[0] = '\0';
+   ppg_cs_n_spans = 0;
+   
+   size_t n_events = ppg_event_buffer_iterate_spans(ppg_cs_process_spans, 
+                                                    NULL);
+   
+   ppg_event_buffer_iterate(ppg_cs_process_single_event, single_string);
+   
+   PPG_CS_CHECK(n_events == strlen(expected));
+   PPG_CS_CHECK(ppg_cs_n_spans == n_spans_expected);
+   PPG_CS_CHECK(strcmp(ppg_cs_span_string, expected) == 0);
+   PPG_CS_CHECK(strcmp(single_string, expected) == 0);
+}
+
+// Writes an on-off string of alternating notes
+//
+static void ppg_cs_on_off_string(char *notes, int n_notes, char *string)
+{
+   size_t n_chars = strlen(notes);
+   
+   for(int i = 0; i < n_notes; ++i) {
+      char c = notes[i % n_chars];
+      string[2*i] = (char)toupper(c);
+      string[2*i + 1] = c;
+   }
+   string[2*n_notes] = '\0';
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(X)
+   PPG_CS_REGISTER_ACTION(Long)
+   
+   PPG_Token x_tokens[PPG_CS_N_X_NOTES];
+   
+   for(int i = 0; i < PPG_CS_N_X_NOTES; ++i) {
+      x_tokens[i] = PPG_CS_N('x');
+   }
+   
+   ppg_token_set_action(x_tokens[PPG_CS_N_X_NOTES - 1],
+                        PPG_CS_ACTION(X));
+   
+   ppg_pattern(ppg_cs_layer_0, PPG_CS_N_X_NOTES, x_tokens);
+   
+   PPG_Token long_tokens[PPG_CS_N_LONG_NOTES];
+   
+   for(int i = 0; i < PPG_CS_N_LONG_NOTES; ++i) {
+      long_tokens[i] = PPG_CS_N((i % 2 == 0) ? 'a' : 'b');
+   }
+   
+   ppg_token_set_action(long_tokens[PPG_CS_N_LONG_NOTES - 1],
+                        PPG_CS_ACTION(Long));
+   
+   ppg_pattern(ppg_cs_layer_0, PPG_CS_N_LONG_NOTES, long_tokens);
+   
+   ppg_cs_compile();
+   
+   char string[256];
+   char expected[256];
+   
+   // Without cached events, the span processor is not called
+   //
+   ppg_cs_check_spans("", 0);
+   
+   //***********************************************
+   // A single span
+   //***********************************************
+   
+   PPG_CS_PROCESS_STRING(  "AaBbAa", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   ppg_cs_check_spans("AaBbAa", 1);
+   
+   ppg_cs_on_off_string("ba", PPG_CS_N_LONG_NOTES - 3, string);
+   
+   PPG_CS_PROCESS_STRING(  string, 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Long)
+                           )
+   );
+   
+   //***********************************************
+   // Two spans
+   //***********************************************
+   
+   // A failing prefix moves the start of the event buffer
+   // close to the end of the storage
+   //
+   size_t capacity = ppg_global_get_event_buffer_capacity() + 1;
+   
+   int n_prefix_notes = (int)(capacity - PPG_CS_N_LONG_NOTES)/2;
+   
+   PPG_CS_CHECK(n_prefix_notes < PPG_CS_N_X_NOTES);
+   
+   ppg_cs_on_off_string("x", n_prefix_notes, string);
+   
+   PPG_CS_PROCESS_STRING(  string, 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_PROCESS_STRING(  "A", 
+                           PPG_CS_EXPECT_FLUSH(string)
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EMF)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // The remaining events of the long pattern wrap around
+   //
+   ppg_cs_on_off_string("ba", PPG_CS_N_LONG_NOTES - 2, string);
+   
+   PPG_CS_PROCESS_STRING(  string, 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   strcpy(expected, "A");
+   strcat(expected, string);
+   
+   ppg_cs_check_spans(expected, 2);
+   
+   PPG_CS_PROCESS_STRING(  "aBb", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Long)
+                           )
+   );
+   
+   //***********************************************
+   // Failed matches
+   //***********************************************
+   
+   // The first event of a failed match and the deactivation events 
+   // that follow it are passed to the span processor with a single call
+   //
+   PPG_CS_CHECK(ppg_global_set_default_event_span_processor(
+                                          ppg_cs_forward_spans) == NULL);
+   
+   PPG_CS_PROCESS_STRING(  "Xx", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_PROCESS_STRING(  "A", 
+                           PPG_CS_EXPECT_FLUSH("Xx")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EMF)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_CHECK(ppg_cs_n_span_calls == 1);
+   PPG_CS_CHECK(ppg_cs_n_span_events == 2);
+   
+   ppg_cs_on_off_string("ba", PPG_CS_N_LONG_NOTES - 1, string);
+   
+   strcpy(expected, "a");
+   strcat(expected, string);
+   
+   PPG_CS_PROCESS_STRING(  expected, 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Long)
+                           )
+   );
+   
+   PPG_CS_CHECK(ppg_global_set_default_event_span_processor(NULL) 
+                                          == ppg_cs_forward_spans);
+   
+PPG_CS_END_TEST
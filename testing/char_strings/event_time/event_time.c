@@ -0,0 +1,200 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+static int ppg_cs_n_time_manager_calls = 0;
+
+static void ppg_cs_counting_time(PPG_Time *time)
+{
+   ++ppg_cs_n_time_manager_calls;
+   ppg_cs_time(time);
+}
+
+static void ppg_cs_counting_time_difference(PPG_Time time1, 
+                                            PPG_Time time2, 
+                                            PPG_Time *delta)
+{
+   ++ppg_cs_n_time_manager_calls;
+   ppg_cs_time_difference(time1, time2, delta);
+}
+
+static PPG_Time_Comparison_Result_Type ppg_cs_counting_time_comparison(
+                                             PPG_Time time1,
+                                             PPG_Time time2)
+{
+   ++ppg_cs_n_time_manager_calls;
+   return ppg_cs_time_comparison(time1, time2);
+}
+
+// Passes the events of a string of on-off characters one by one. 
+// The events arrive one time unit after another, 
+// starting at the given time.
+//
+static void ppg_cs_process_timed(char *string, PPG_Time time)
+{
+   for(int i = 0; string[i] != '\0'; ++i) {
+      
+      if(string[i] == ' ') { continue; }
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(string[i]),
+         .time = time,
+         .flags = isupper(string[i]) ? PPG_Event_Active 
+                                     : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ppg_event_process(&event);
+      
+      ++time;
+   }
+}
+
+static void ppg_cs_record_time(PPG_Event *event, void *user_data)
+{
+   *(PPG_Time*)user_data = event->time;
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Pattern)
+   
+   ppg_pattern(
+      ppg_cs_layer_0,
+      PPG_TOKENS(
+         PPG_CS_N('a'),
+         ppg_token_set_action(
+            PPG_CS_N('b'),
+            PPG_CS_ACTION(Pattern)
+         )
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   ppg_global_set_time_manager(
+      (PPG_Time_Manager) {
+         .time = ppg_cs_counting_time,
+         .time_difference = ppg_cs_counting_time_difference,
+         .compare_times = ppg_cs_counting_time_comparison
+      }
+   );
+   
+   PPG_CS_CHECK(!ppg_global_get_event_time_enabled());
+   PPG_CS_CHECK(!ppg_global_set_event_time_enabled(true));
+   PPG_CS_CHECK(ppg_global_get_event_time_enabled());
+   
+   //***********************************************
+   // The time manager is not used
+   //***********************************************
+   
+   ppg_cs_process_timed("A a B b", 1000);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   // Timeouts are detected based on the time stamps
+   //
+   ppg_cs_process_timed("A", 2000);
+   ppg_cs_process_timed("a", 2000 + 2*PPG_CS_Timeout_MS);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("Aa")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // Gaps longer than half the range of time values are timeouts
+   // as well
+   //
+   ppg_cs_process_timed("A", 3000);
+   ppg_cs_process_timed("a", 3000 + ((PPG_Time)-1)/2 + 2*PPG_CS_Timeout_MS);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("Aa")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // Time stamps may wrap around
+   //
+   ppg_cs_process_timed("A a B b", (PPG_Time)-2);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   PPG_CS_CHECK(ppg_cs_n_time_manager_calls == 0);
+   
+   //***********************************************
+   // Without event time mode, the time manager
+   // determines the time of arrival
+   //***********************************************
+   
+   PPG_CS_CHECK(ppg_global_set_event_time_enabled(false));
+   
+   ppg_cs_process_timed("A a B b", 0);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   PPG_CS_CHECK(ppg_cs_n_time_manager_calls > 0);
+   
+   // Stored events carry their registered time of arrival instead of 
+   // the time passed by the caller
+   //
+   PPG_Time time_before, time_after, time_stored = 0;
+   
+   ppg_cs_time(&time_before);
+   ppg_cs_process_timed("A", time_before + 12345);
+   ppg_cs_time(&time_after);
+   
+   ppg_event_buffer_iterate(ppg_cs_record_time, &time_stored);
+   
+   PPG_CS_CHECK(time_stored >= time_before);
+   PPG_CS_CHECK(time_stored <= time_after);
+   
+   ppg_global_abort_pattern_matching();
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("A")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EA)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+PPG_CS_END_TEST
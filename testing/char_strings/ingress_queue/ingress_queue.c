@@ -0,0 +1,173 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+
+#if PPG_HAVE_INGRESS_QUEUE
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// Pushes a string of events to an ingress queue
+//
+static size_t ppg_cs_push_string(void *queue, char *event_string)
+{
+   size_t n_pushed = 0;
+   
+   for(int i = 0; event_string[i] != '\0'; ++i) {
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+         .time = 0,
+         .flags = isupper(event_string[i]) ? 
+                        PPG_Event_Active : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      if(ppg_ingress_queue_push(queue, &event)) {
+         ++n_pushed;
+      }
+   }
+   
+   return n_pushed;
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   // The capacity is rounded up to 8
+   //
+   void *queue = ppg_ingress_queue_create(5);
+   
+   PPG_CS_CHECK(ppg_cs_push_string(queue, "ABCcba") == 6);
+   
+   // Events are processed in bounded portions
+   //
+   PPG_CS_CHECK(ppg_ingress_queue_drain(queue, 4) == 4);
+   PPG_CS_CHECK(ppg_ingress_queue_drain(queue, 100) == 2);
+   PPG_CS_CHECK(ppg_ingress_queue_drain(queue, 100) == 0);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   // A full queue rejects further events. The cells are reused 
+   // after wrapping around.
+   //
+   PPG_CS_CHECK(ppg_cs_push_string(queue, "ABCcbaAB") == 8);
+   PPG_CS_CHECK(ppg_cs_push_string(queue, "C") == 0);
+   
+   PPG_CS_CHECK(ppg_ingress_queue_drain(queue, 100) == 8);
+   
+   PPG_CS_CHECK(ppg_cs_push_string(queue, "Ccba") == 4);
+   PPG_CS_CHECK(ppg_ingress_queue_drain(queue, 100) == 4);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord),
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   PPG_Ingress_Queue_Statistics statistics;
+   ppg_ingress_queue_get_statistics(queue, &statistics);
+   
+   PPG_CS_CHECK(statistics.n_events_pushed == 18);
+   PPG_CS_CHECK(statistics.n_events_rejected == 1);
+   PPG_CS_CHECK(statistics.n_events_drained == 18);
+   PPG_CS_CHECK(statistics.max_fill == 8);
+   
+   // While work is pending, draining stops and the events stay queued.
+   // The producer sees its events rejected and retries.
+   //
+   ppg_global_set_work_budget(1);
+   
+   char *stream = "ABCcbaABCcbaABCcba";
+   
+   size_t n_rejected = 0;
+   bool events_kept = false;
+   
+   for(int i = 0; stream[i] != '\0'; ) {
+      
+      char event_string[2] = { stream[i], '\0' };
+      
+      if(ppg_cs_push_string(queue, event_string) == 1) {
+         ++i;
+         continue;
+      }
+      
+      ++n_rejected;
+      
+      PPG_CS_CHECK(n_rejected < 1000);
+      
+      ppg_ingress_queue_drain(queue, 100);
+      
+      ppg_ingress_queue_get_statistics(queue, &statistics);
+      
+      if(   ppg_event_work_pending()
+         && (statistics.n_events_pushed > statistics.n_events_drained)) {
+         events_kept = true;
+      }
+   }
+   
+   while(   ppg_ingress_queue_drain(queue, 100) 
+         || ppg_event_work_pending()) {}
+   
+   ppg_ingress_queue_get_statistics(queue, &statistics);
+   
+   PPG_CS_CHECK(n_rejected > 0);
+   PPG_CS_CHECK(events_kept);
+   PPG_CS_CHECK(statistics.n_events_drained == 18 + 18);
+   
+   ppg_global_set_work_budget(0);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord),
+                              PPG_CS_A(Chord),
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   ppg_ingress_queue_destroy(queue);
+   
+PPG_CS_END_TEST
+
+#endif
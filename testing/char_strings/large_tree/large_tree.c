@@ -0,0 +1,105 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <assert.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// Three note sequences over this number of inputs result in
+// a pattern tree with more tokens than a 16 bit signed integer 
+// can index
+//
+#define PPG_CS_N_LARGE_TREE_INPUTS 33
+
+static char ppg_cs_large_tree_char(int i)
+{
+   return (i < 26) ? (char)('a' + i) : (char)('0' + i - 26);
+}
+
+static void ppg_cs_add_large_tree(PPG_Action action)
+{
+   for(int i1 = 0; i1 < PPG_CS_N_LARGE_TREE_INPUTS; ++i1) {
+      for(int i2 = 0; i2 < PPG_CS_N_LARGE_TREE_INPUTS; ++i2) {
+         for(int i3 = 0; i3 < PPG_CS_N_LARGE_TREE_INPUTS; ++i3) {
+            
+            char c1 = ppg_cs_large_tree_char(i1);
+            char c2 = ppg_cs_large_tree_char(i2);
+            char c3 = ppg_cs_large_tree_char(i3);
+            
+            // The sequence that is checked below
+            //
+            bool checked = (c1 == 'x') && (c2 == 'y') && (c3 == 'z');
+            
+            ppg_sequence(
+               ppg_cs_layer_0,
+               checked ? action : PPG_ACTION_NOOP,
+               PPG_INPUTS(
+                  PPG_CS_CHAR(c1),
+                  PPG_CS_CHAR(c2),
+                  PPG_CS_CHAR(c3)
+               )
+            );
+         }
+      }
+   }
+}
+
+#define PPG_CS_CHECK_ENGINE(ENGINE) \
+   { \
+      void *context = ppg_context_create(); \
+      \
+      ppg_global_set_current_context(context); \
+      \
+      PPG_CS_PREPARE_CONTEXT \
+      \
+      ppg_global_set_engine(ENGINE); \
+      \
+      ppg_cs_add_large_tree(PPG_CS_ACTION(Sequence)); \
+      \
+      ppg_cs_compile(); \
+      \
+      PPG_CS_PROCESS_STRING(  "X x Y y Z z", \
+                              PPG_CS_EXPECT_EMPTY_FLUSH \
+                              PPG_CS_EXPECT_NO_EXCEPTIONS \
+                              PPG_CS_EXPECT_ACTION_SERIES( \
+                                 PPG_CS_A(Sequence) \
+                              ) \
+      ); \
+      \
+      ppg_global_set_current_context(context_1); \
+      ppg_context_destroy(context); \
+   }
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Sequence)
+   
+   void *context_1 = ppg_global_get_current_context();
+   
+   PPG_CS_CHECK_ENGINE(PPG_Engine_Tree)
+   PPG_CS_CHECK_ENGINE(PPG_Engine_Indexed)
+   PPG_CS_CHECK_ENGINE(PPG_Engine_Parallel)
+   
+PPG_CS_END_TEST
+
+#endif
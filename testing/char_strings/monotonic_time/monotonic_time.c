@@ -0,0 +1,122 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+PPG_CS_START_TEST
+
+#if defined(__linux__) && !defined(PPG_DISABLE_MONOTONIC_TIME)
+
+   PPG_CS_REGISTER_ACTION(Pattern)
+   
+   ppg_pattern(
+      ppg_cs_layer_0,
+      PPG_TOKENS(
+         PPG_CS_N('a'),
+         ppg_token_set_action(
+            PPG_CS_N('b'),
+            PPG_CS_ACTION(Pattern)
+         )
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   //***********************************************
+   // Integer time arithmetic
+   //***********************************************
+   
+   PPG_CS_CHECK(ppg_time_integer_difference(10, 25) == 15);
+   PPG_CS_CHECK(ppg_time_integer_difference((PPG_Time)-5, 5) == 10);
+   PPG_CS_CHECK(ppg_time_integer_comparison(10, 25) < 0);
+   PPG_CS_CHECK(ppg_time_integer_comparison(25, 10) > 0);
+   PPG_CS_CHECK(ppg_time_integer_comparison(25, 25) == 0);
+   
+   // Time values that wrapped around compare greater
+   //
+   PPG_CS_CHECK(ppg_time_integer_comparison(5, (PPG_Time)-5) > 0);
+   PPG_CS_CHECK(ppg_time_integer_comparison((PPG_Time)-5, 5) < 0);
+   
+   //***********************************************
+   // The clocks are monotonic
+   //***********************************************
+   
+   PPG_Time_Manager coarse_time_manager;
+   ppg_time_manager_init_monotonic(&coarse_time_manager, 
+                                   PPG_Monotonic_Clock_Coarse);
+   
+   PPG_Time_Manager time_manager;
+   ppg_time_manager_init_monotonic(&time_manager, 
+                                   PPG_Monotonic_Clock_Precise);
+   
+   PPG_Time_Manager managers[] = { coarse_time_manager, time_manager };
+   
+   for(int i = 0; i < 2; ++i) {
+      
+      PPG_Time time1, time2;
+      
+      managers[i].time(&time1);
+      
+      // Sleep for one millisecond
+      //
+      usleep(1000);
+      
+      managers[i].time(&time2);
+      
+      PPG_CS_CHECK(managers[i].compare_times(time2, time1) >= 0);
+      
+      PPG_Time delta;
+      managers[i].time_difference(time1, time2, &delta);
+      
+      PPG_CS_CHECK(delta < PPG_TIME_UNITS_PER_SECOND);
+   }
+   
+   //***********************************************
+   // Timeouts based on the clock
+   //***********************************************
+   
+   ppg_global_set_time_manager(time_manager);
+   
+   ppg_global_set_timeout(
+      (PPG_Time)(PPG_CS_Timeout_MS*PPG_TIME_UNITS_PER_SECOND/1000));
+   
+   PPG_CS_PROCESS_STRING(  "AaBb", 
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   PPG_CS_PROCESS_STRING(  "A|a", 
+                           PPG_CS_EXPECT_FLUSH("Aa")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+#endif
+   
+PPG_CS_END_TEST
@@ -56,4 +56,36 @@ PPG_CS_PROCESS_ON_OFF(  "a a a a a |",
                         PPG_CS_EXPECT_ACTION_SERIES(
                            PPG_CS_A(5_Taps)
                         )
-);
\ No newline at end of file
+);
+//***********************************************
+// Inputs that are not used by any pattern
+// are flushed right away
+//***********************************************
+
+PPG_CS_PROCESS_STRING(  "A X a x",  
+                        PPG_CS_EXPECT_FLUSH("AXax")
+                        PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EMF)
+                        PPG_CS_EXPECT_NO_ACTIONS
+);
+
+//***********************************************
+// Batches of events are processed based on
+// the time stamps of the events
+//***********************************************
+
+PPG_CS_PROCESS_BATCH(   "A a B b C c",  
+                        PPG_CS_EXPECT_EMPTY_FLUSH
+                        PPG_CS_EXPECT_NO_EXCEPTIONS
+                        PPG_CS_EXPECT_ACTION_SERIES(
+                           PPG_CS_A(Pattern_1)
+                        )
+);
+
+PPG_CS_PROCESS_BATCH(   "A a A a A a | A a B b D d",  
+                        PPG_CS_EXPECT_EMPTY_FLUSH
+                        PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                        PPG_CS_EXPECT_ACTION_SERIES(
+                           PPG_CS_A(3_Taps),
+                           PPG_CS_A(Pattern_3)
+                        )
+);
@@ -70,7 +70,7 @@
   }
 #else
 
-#include <sys/timeb.h> 
+#include <sys/time.h> 
 #include <unistd.h>
 #endif
 
@@ -138,12 +138,12 @@ static void ppg_cs_store_start_time(void)
    #ifdef __AVR__
    ppg_cs_start_time_ms = timer_read32();
    #else
-   struct timeb a_timeb;
+   struct timeval a_timeval;
    
-   ftime(&a_timeb);
+   gettimeofday(&a_timeval, NULL);
    
-   ppg_cs_start_time_s = a_timeb.time;
-   ppg_cs_start_time_ms = a_timeb.millitm;
+   ppg_cs_start_time_s = a_timeval.tv_sec;
+   ppg_cs_start_time_ms = a_timeval.tv_usec/1000;
    #endif
 }
 
@@ -152,11 +152,11 @@ static long unsigned ppg_cs_run_time_ms(void)
    #ifdef __AVR__
    return timer_read32() - ppg_cs_start_time_ms;
    #else
-   struct timeb a_timeb;
+   struct timeval a_timeval;
    
-   ftime(&a_timeb);
+   gettimeofday(&a_timeval, NULL);
  
-   return (a_timeb.time - ppg_cs_start_time_s)*1000 + a_timeb.millitm - ppg_cs_start_time_ms;
+   return (a_timeval.tv_sec - ppg_cs_start_time_s)*1000 + a_timeval.tv_usec/1000 - ppg_cs_start_time_ms;
    #endif
 }
 
@@ -330,6 +330,65 @@ void ppg_cs_process_on_off(char *string)
    }
 }
 
+void ppg_cs_process_batch(char *string)
+{
+   ppg_cs_break();
+   ppg_cs_separator();
+   PPG_LOG("Sending control string \"%s\" as batch\n", string);
+   ppg_cs_separator();
+   
+   PPG_Event events[strlen(string) + 1];
+   size_t n_events = 0;
+   
+   // Delays do not block but advance the time stamps of 
+   // the events that follow
+   //
+   long unsigned time = ppg_cs_run_time_ms();
+   
+   int i = 0;
+   while(string[i] != '\0') {
+      
+      char the_char = string[i];
+      
+      switch(the_char) {
+         case PPG_CS_CC_Short_Delay:
+            time += ppg_cs_timeout_ms*3/10;
+            break;
+         case PPG_CS_CC_Long_Delay:
+            time += ppg_cs_timeout_ms*3;
+            break;
+         default:
+            if(isalpha(the_char)) {
+               events[n_events] = (PPG_Event) {
+                  .input = (PPG_Input_Id)(uintptr_t)tolower(the_char),
+                  .time = (PPG_Time)time,
+                  .flags = (my_isalpha_upper(the_char)) ? 
+                                 PPG_Event_Active : PPG_Event_Flags_Empty,
+                  .groupId = 0
+               };
+               ++n_events;
+            }
+            break;
+      }
+      ++i;
+   }
+   
+   ppg_event_process_batch(events, n_events);
+   
+   // Wait until the time of the last delay has passed to let
+   // subsequent timeout checks see the same time line
+   //
+   long unsigned now = ppg_cs_run_time_ms();
+   
+   if(time > now) {
+      #ifdef __AVR__
+      wait_ms(time - now);
+      #else
+      usleep((time - now)*1000);
+      #endif
+   }
+}
+
 void ppg_cs_time(PPG_Time *time)
 {
    *time = ppg_cs_run_time_ms();
@@ -477,6 +536,22 @@ void ppg_cs_check_test_success(char *file, int line)
    }
 }
 
+void ppg_cs_check_condition(bool condition, 
+                            char *condition_string, 
+                            char *file, 
+                            int line)
+{
+   if(condition) { return; }
+   
+   PPG_LOG("! %s: %d: Check failed: %s\n", file, line, condition_string);
+   PPG_LOG("Test failed. Aborting.\n");
+   
+   #ifdef __AVR__
+   printf("__PAPAGENO_TEST_FAILED__\n");
+   #endif
+   abort();
+}
+
 void ppg_cs_check_action_series(int n_actions, 
                                 PPG_CS_Action_Expectation* expected)
 {
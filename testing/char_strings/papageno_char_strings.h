@@ -238,6 +238,17 @@ __NL__   ppg_cs_output_test_info(__FILE__, __LINE__); \
 __NL__   ppg_cs_process_on_off(STRING); \
 __NL__   PPG_CS_CHECK_NO_PROCESS(__VA_ARGS__)   
    
+// Processes all events of a string by means of a single call
+// to ppg_event_process_batch
+//
+void ppg_cs_process_batch(char *string);
+
+#define PPG_CS_PROCESS_BATCH(STRING, ...) \
+__NL__   PPG_CS_CHECK_CONSISTENCY \
+__NL__   ppg_cs_output_test_info(__FILE__, __LINE__); \
+__NL__   ppg_cs_process_batch(STRING); \
+__NL__   PPG_CS_CHECK_NO_PROCESS(__VA_ARGS__)
+   
 void ppg_cs_time(         PPG_Time *time);
 
 void ppg_cs_time_difference(
@@ -270,6 +281,16 @@ uint16_t ppg_cs_input_id_from_keypos(uint8_t row, uint8_t col);
 void ppg_cs_check_test_success(char *file, int line);
 void ppg_cs_output_test_info(char *file, int line);
 
+void ppg_cs_check_condition(bool condition, 
+                            char *condition_string, 
+                            char *file, 
+                            int line);
+
+// Unlike assert, this check is never compiled out
+//
+#define PPG_CS_CHECK(CONDITION) \
+   ppg_cs_check_condition((CONDITION), #CONDITION, __FILE__, __LINE__);
+
 void ppg_cs_separator(void);
    
 #define PPG_CS_CHAR(CHAR) \
@@ -291,8 +312,16 @@ __NL__         .user_data = (void*)USER_DATA \
 __NL__      } \
 __NL__   }
    
+#ifdef PPG_CS_ENGINE
+#define PPG_CS_SELECT_ENGINE ppg_global_set_engine(PPG_CS_ENGINE);
+#else
+#define PPG_CS_SELECT_ENGINE
+#endif
+   
 #define PPG_CS_PREPARE_CONTEXT \
    \
+__NL__   PPG_CS_SELECT_ENGINE \
+__NL__   \
 __NL__   /*ppg_global_set_number_of_inputs(255); */\
 __NL__   \
 __NL__   ppg_global_set_default_event_processor((PPG_Event_Processor_Fun)ppg_cs_process_event_callback); \
@@ -0,0 +1,143 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+static int ppg_cs_n_signals = 0;
+
+// Counts signals and forwards them to the default signal handler
+//
+static void ppg_cs_count_signals(PPG_Signal_Id signal_id, void *user_data)
+{
+   ++ppg_cs_n_signals;
+   
+   ppg_cs_on_signal(signal_id, user_data);
+}
+
+static void ppg_cs_count_event(PPG_Event *event, void *user_data)
+{
+   ++*(int*)user_data;
+}
+
+static int ppg_cs_n_stored_while_passed = 0;
+
+// Counts the events that are stored while an event is passed on 
+// and forwards the event to the default event processor
+//
+static void ppg_cs_count_stored(PPG_Event *event, void *user_data)
+{
+   ppg_event_buffer_iterate(ppg_cs_count_event, 
+                            &ppg_cs_n_stored_while_passed);
+   
+   ppg_cs_process_event_callback(event, user_data);
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Pattern)
+   
+   ppg_pattern(
+      ppg_cs_layer_0,
+      PPG_TOKENS(
+         PPG_CS_N('a'),
+         ppg_token_set_action(
+            PPG_CS_N('b'),
+            PPG_CS_ACTION(Pattern)
+         )
+      )
+   );
+   
+   ppg_global_set_abort_trigger(PPG_CS_CHAR('q'));
+   
+   ppg_cs_compile();
+   
+   #if PPG_HAVE_STATISTICS
+   PPG_Statistics before, after;
+   ppg_statistics_get(&before);
+   #endif
+   
+   // Inputs that are not used by any pattern are passed on 
+   // without being matched
+   //
+   PPG_CS_PROCESS_STRING(  "Zz Yy", 
+                           PPG_CS_EXPECT_FLUSH("ZzYy")
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   #if PPG_HAVE_STATISTICS
+   ppg_statistics_get(&after);
+   PPG_CS_CHECK(after.n_token_checks == before.n_token_checks);
+   #endif
+   
+   // Passed through events are neither stored nor matched. They 
+   // are handed to the event processor directly.
+   //
+   PPG_Signal_Callback old_callback
+      = ppg_global_set_signal_callback(
+            (PPG_Signal_Callback) {
+               .func = ppg_cs_count_signals,
+               .user_data = NULL
+            }
+      );
+   
+   PPG_Event_Processor_Fun old_processor 
+      = ppg_global_set_default_event_processor(ppg_cs_count_stored);
+   
+   PPG_CS_PROCESS_STRING(  "Zz Yy", 
+                           PPG_CS_EXPECT_FLUSH("ZzYy")
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_CHECK(ppg_cs_n_signals == 0);
+   PPG_CS_CHECK(ppg_cs_n_stored_while_passed == 0);
+   
+   ppg_global_set_default_event_processor(old_processor);
+   ppg_global_set_signal_callback(old_callback);
+   
+   PPG_CS_PROCESS_STRING(  "Zz AaBb Yy", 
+                           PPG_CS_EXPECT_FLUSH("ZzYy")
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   // While a match is in progress, such inputs make it fail 
+   // and are flushed in the order of arrival
+   //
+   PPG_CS_PROCESS_STRING(  "Aa Zz", 
+                           PPG_CS_EXPECT_FLUSH("AaZz")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EMF)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // The abort trigger is not passed on even though no pattern uses it
+   //
+   PPG_CS_PROCESS_STRING(  "Aa Qq", 
+                           PPG_CS_EXPECT_FLUSH("Aaq")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_EA)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+PPG_CS_END_TEST
@@ -0,0 +1,283 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+static long long ppg_cs_dry_run_buffer[16384];
+static long long ppg_cs_buffer[16384];
+
+#define PPG_CS_ADD_PATTERN \
+   ppg_pattern( \
+      ppg_cs_layer_0, \
+      PPG_TOKENS( \
+         PPG_CS_N('a'), \
+         PPG_CS_N('b'), \
+         ppg_token_set_action( \
+            PPG_CS_N('d'), \
+            PPG_CS_ACTION(Pattern) \
+         ) \
+      ) \
+   );
+   
+// The parameters of ppg_cs_setup_context
+//
+typedef struct {
+   PPG_Count engine;
+   int chord_action;
+   int pattern_action;
+} PPG_CS_Setup;
+
+// Defines and compiles the patterns in the current context
+//
+static void ppg_cs_setup_context(PPG_CS_Setup *setup)
+{
+   int PPG_CS_ACTION_VAR(Chord) = setup->chord_action;
+   int PPG_CS_ACTION_VAR(Pattern) = setup->pattern_action;
+   
+   PPG_CS_PREPARE_CONTEXT
+   
+   ppg_global_set_engine(setup->engine);
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   PPG_CS_ADD_PATTERN
+   
+   ppg_cs_compile();
+}
+
+// Creates a context in a buffer, defines the patterns and compiles them.
+// The context is left current.
+//
+#define PPG_CS_SETUP_CONTEXT(CONTEXT, BUFFER, N_BYTES, SETUP) \
+   CONTEXT = ppg_context_create_in_buffer((void*)BUFFER, N_BYTES); \
+   \
+   ppg_global_set_current_context(CONTEXT); \
+   \
+   ppg_cs_setup_context(&SETUP);
+   
+// The number of notes of the long pattern. Every note
+// causes two events. Thus, the pattern exceeds the 
+// capacity of the event buffer.
+//
+#define PPG_CS_N_LONG_NOTES PPG_MAX_EVENTS
+
+static int ppg_cs_n_dropped = 0;
+
+// Counts dropped events and forwards all signals to 
+// the default signal handler
+//
+static void ppg_cs_count_dropped(PPG_Signal_Id signal_id, void *user_data)
+{
+   if(signal_id == PPG_On_Event_Dropped) {
+      ++ppg_cs_n_dropped;
+   }
+   
+   ppg_cs_on_signal(signal_id, user_data);
+}
+
+// Defines and compiles a pattern that is too long to be stored
+// in the event buffer
+//
+static void ppg_cs_setup_long_pattern(int *long_action)
+{
+   int PPG_CS_ACTION_VAR(Long) = *long_action;
+   
+   PPG_CS_PREPARE_CONTEXT
+   
+   ppg_global_set_signal_callback(
+      (PPG_Signal_Callback) {
+         .func = (PPG_Signal_Callback_Fun)ppg_cs_count_dropped,
+         .user_data = NULL
+      }
+   );
+   
+   PPG_Token long_tokens[PPG_CS_N_LONG_NOTES];
+   
+   for(int i = 0; i < PPG_CS_N_LONG_NOTES; ++i) {
+      long_tokens[i] = PPG_CS_N((i % 2 == 0) ? 'a' : 'b');
+   }
+   
+   ppg_token_set_action(long_tokens[PPG_CS_N_LONG_NOTES - 1],
+                        PPG_CS_ACTION(Long));
+   
+   ppg_pattern(ppg_cs_layer_0, PPG_CS_N_LONG_NOTES, long_tokens);
+   
+   ppg_cs_compile();
+}
+
+#define PPG_CS_MATCH \
+   PPG_CS_PROCESS_STRING(  "A B C c b a", \
+                           PPG_CS_EXPECT_EMPTY_FLUSH \
+                           PPG_CS_EXPECT_NO_EXCEPTIONS \
+                           PPG_CS_EXPECT_ACTION_SERIES( \
+                              PPG_CS_A(Chord) \
+                           ) \
+   ); \
+   \
+   PPG_CS_PROCESS_STRING(  "A a B b D d", \
+                           PPG_CS_EXPECT_EMPTY_FLUSH \
+                           PPG_CS_EXPECT_NO_EXCEPTIONS \
+                           PPG_CS_EXPECT_ACTION_SERIES( \
+                              PPG_CS_A(Pattern) \
+                           ) \
+   );
+   
+#define PPG_CS_CHECK_ENGINE(ENGINE) \
+   { \
+      PPG_CS_Setup setup = { \
+         .engine = ENGINE, \
+         .chord_action = PPG_CS_ACTION_VAR(Chord), \
+         .pattern_action = PPG_CS_ACTION_VAR(Pattern) \
+      }; \
+      \
+      size_t n_required \
+         = ppg_context_required_bytes( \
+                  (PPG_Context_Setup_Fun)ppg_cs_setup_context, \
+                  (void*)&setup); \
+      \
+      PPG_CS_CHECK(n_required > 0); \
+      PPG_CS_CHECK(n_required <= sizeof(ppg_cs_dry_run_buffer)); \
+      \
+      PPG_CS_CHECK(ppg_global_get_current_context() == context_1); \
+      \
+      void *dry_run_context = NULL; \
+      \
+      PPG_CS_SETUP_CONTEXT(dry_run_context, \
+                           ppg_cs_dry_run_buffer, \
+                           sizeof(ppg_cs_dry_run_buffer), \
+                           setup) \
+      \
+      /* The computed size matches the usage of a dry run \
+       */ \
+      PPG_CS_CHECK(ppg_context_get_buffer_usage(dry_run_context) \
+                                                   == n_required); \
+      \
+      PPG_CS_MATCH \
+      \
+      /* No engine allocates memory while matching \
+       */ \
+      PPG_CS_CHECK(ppg_context_get_buffer_usage(dry_run_context) \
+                                                   == n_required); \
+      \
+      ppg_global_set_current_context(context_1); \
+      ppg_context_destroy(dry_run_context); \
+      \
+      /* A buffer of exactly the computed size suffices \
+       */ \
+      void *context = NULL; \
+      \
+      PPG_CS_SETUP_CONTEXT(context, ppg_cs_buffer, n_required, setup) \
+      \
+      PPG_CS_MATCH \
+      \
+      PPG_CS_CHECK(ppg_context_get_buffer_usage(context) == n_required); \
+      \
+      /* Matching the same input again does not require any memory \
+       */ \
+      PPG_CS_MATCH \
+      \
+      PPG_CS_CHECK(ppg_context_get_buffer_usage(context) == n_required); \
+      \
+      ppg_global_set_current_context(context_1); \
+      ppg_context_destroy(context); \
+   }
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   PPG_CS_REGISTER_ACTION(Pattern)
+   
+   void *context_1 = ppg_global_get_current_context();
+   
+   // Contexts that are not created in a buffer report no usage
+   //
+   PPG_CS_CHECK(ppg_context_get_buffer_usage(context_1) == 0);
+   
+   PPG_CS_CHECK_ENGINE(PPG_Engine_Tree)
+   PPG_CS_CHECK_ENGINE(PPG_Engine_Indexed)
+   PPG_CS_CHECK_ENGINE(PPG_Engine_Parallel)
+   
+   //***********************************************
+   // Event buffer overflow
+   //***********************************************
+   
+   PPG_CS_REGISTER_ACTION(Long)
+   
+   int long_action = PPG_CS_ACTION_VAR(Long);
+   
+   size_t n_required 
+      = ppg_context_required_bytes(
+               (PPG_Context_Setup_Fun)ppg_cs_setup_long_pattern,
+               (void*)&long_action);
+   
+   void *context = ppg_context_create_in_buffer((void*)ppg_cs_buffer, 
+                                                n_required);
+   ppg_global_set_current_context(context);
+   
+   ppg_cs_setup_long_pattern(&long_action);
+   
+   size_t capacity = ppg_global_get_event_buffer_capacity();
+   
+   PPG_CS_CHECK(capacity < 2*PPG_CS_N_LONG_NOTES);
+   
+   char string[2*PPG_CS_N_LONG_NOTES + 1];
+   
+   for(int i = 0; i < PPG_CS_N_LONG_NOTES; ++i) {
+      char c = (i % 2 == 0) ? 'a' : 'b';
+      string[2*i] = (char)toupper(c);
+      string[2*i + 1] = c;
+   }
+   string[2*PPG_CS_N_LONG_NOTES] = '\0';
+   
+   // The event buffer does not grow. Events that do not fit 
+   // are dropped instead.
+   //
+   PPG_CS_PROCESS_STRING(  string,
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   PPG_CS_CHECK(   ppg_cs_n_dropped 
+                == (int)(2*PPG_CS_N_LONG_NOTES - capacity));
+   
+   PPG_CS_CHECK(ppg_global_get_event_buffer_capacity() == capacity);
+   PPG_CS_CHECK(ppg_context_get_buffer_usage(context) == n_required);
+   
+   ppg_global_abort_pattern_matching();
+   
+   ppg_global_set_current_context(context_1);
+   ppg_context_destroy(context);
+   
+PPG_CS_END_TEST
+
+#endif
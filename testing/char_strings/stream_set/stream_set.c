@@ -0,0 +1,106 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// Passes a string of events to a stream of a stream set
+//
+static void ppg_cs_feed_stream(void *stream_set, 
+                               size_t stream_id, 
+                               char *event_string)
+{
+   for(int i = 0; event_string[i] != '\0'; ++i) {
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+         .time = 0,
+         .flags = isupper(event_string[i]) ? 
+                        PPG_Event_Active : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ppg_stream_set_event_process(stream_set, stream_id, &event);
+   }
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   void *stream_set = ppg_stream_set_create(ppg_global_get_current_context());
+   
+   // Start a chord on one stream and complete the same chord on 
+   // another stream that lives in a different slab. The streams 
+   // must keep track of their matching state independently.
+   //
+   ppg_cs_feed_stream(stream_set, 0, "AB");
+   ppg_cs_feed_stream(stream_set, 1000, "ABCcba");
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   ppg_cs_feed_stream(stream_set, 0, "Ccba");
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   // A released stream starts from scratch when it is reused
+   //
+   ppg_cs_feed_stream(stream_set, 1000, "AB");
+   ppg_stream_set_release_stream(stream_set, 1000);
+   ppg_cs_feed_stream(stream_set, 1000, "Ccba");
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   ppg_stream_set_destroy(stream_set);
+   
+PPG_CS_END_TEST
+
+#endif
@@ -0,0 +1,178 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+
+#if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   PPG_Time deadline;
+   
+   // No deadline as long as no events are stored
+   //
+   PPG_CS_CHECK(!ppg_timeout_get_deadline(&deadline));
+   
+   PPG_Event event = {
+      .input = (PPG_Input_Id)(uintptr_t)'a',
+      .time = 1000,
+      .flags = PPG_Event_Active,
+      .groupId = 0
+   };
+   
+   ppg_event_process_batch(&event, 1);
+   
+   PPG_CS_CHECK(ppg_timeout_get_deadline(&deadline));
+   PPG_CS_CHECK(deadline == 1000 + PPG_CS_Timeout_MS + 1);
+   
+   #if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+   
+   int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+   PPG_CS_CHECK(timerfd >= 0);
+   
+   struct itimerspec timer_spec;
+   
+   // Time values are milliseconds
+   //
+   PPG_CS_CHECK(ppg_timeout_update_timerfd(timerfd, 1000000) == 0);
+   
+   timerfd_gettime(timerfd, &timer_spec);
+   PPG_CS_CHECK(   (timer_spec.it_value.tv_sec != 0) 
+          || (timer_spec.it_value.tv_nsec != 0));
+   
+   #endif
+   
+   // Timeout disabled means no deadline
+   //
+   ppg_timeout_set_state(false);
+   PPG_CS_CHECK(!ppg_timeout_get_deadline(&deadline));
+   ppg_timeout_set_state(true);
+   
+   // An event that arrives at the deadline causes a timeout
+   // before it is processed
+   //
+   event.time = deadline;
+   event.flags = PPG_Event_Flags_Empty;
+   
+   ppg_event_process_batch(&event, 1);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("Aa")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // No deadline after timeout
+   //
+   PPG_CS_CHECK(!ppg_timeout_get_deadline(&deadline));
+   
+   #if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+   
+   PPG_CS_CHECK(ppg_timeout_update_timerfd(timerfd, 1000000) == 0);
+   
+   timerfd_gettime(timerfd, &timer_spec);
+   PPG_CS_CHECK(   (timer_spec.it_value.tv_sec == 0) 
+          && (timer_spec.it_value.tv_nsec == 0));
+   
+   #endif
+   
+   //***********************************************
+   // Pending work
+   //***********************************************
+   
+   // A budget of one step leaves work pending after the first event
+   //
+   ppg_global_set_work_budget(1);
+   
+   PPG_Event events[] = {
+      {
+         .input = (PPG_Input_Id)(uintptr_t)'a',
+         .time = 2000,
+         .flags = PPG_Event_Active,
+         .groupId = 0
+      },
+      {
+         .input = (PPG_Input_Id)(uintptr_t)'b',
+         .time = 2001,
+         .flags = PPG_Event_Active,
+         .groupId = 0
+      }
+   };
+   
+   ppg_event_process_batch(events, 2);
+   
+   PPG_CS_CHECK(ppg_event_work_pending());
+   
+   // While work is pending, there is no deadline and the timer is
+   // disarmed. Otherwise, an expired deadline would let the timer
+   // fire over and over without any progress.
+   //
+   PPG_CS_CHECK(!ppg_timeout_get_deadline(&deadline));
+   
+   #if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+   
+   PPG_CS_CHECK(ppg_timeout_update_timerfd(timerfd, 1000000) == 0);
+   
+   timerfd_gettime(timerfd, &timer_spec);
+   PPG_CS_CHECK(   (timer_spec.it_value.tv_sec == 0) 
+          && (timer_spec.it_value.tv_nsec == 0));
+   
+   #endif
+   
+   while(ppg_event_process_pending()) {}
+   
+   // Once the work is done, the deadline refers to the last event
+   //
+   PPG_CS_CHECK(ppg_timeout_get_deadline(&deadline));
+   PPG_CS_CHECK(deadline == 2001 + PPG_CS_Timeout_MS + 1);
+   
+   #if defined(__linux__) && !defined(PPG_DISABLE_TIMERFD)
+   
+   PPG_CS_CHECK(ppg_timeout_update_timerfd(timerfd, 1000000) == 0);
+   
+   timerfd_gettime(timerfd, &timer_spec);
+   PPG_CS_CHECK(   (timer_spec.it_value.tv_sec != 0) 
+          || (timer_spec.it_value.tv_nsec != 0));
+   
+   close(timerfd);
+   
+   #endif
+   
+   ppg_global_set_work_budget(0);
+   
+PPG_CS_END_TEST
@@ -0,0 +1,326 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// Passes a string of events with a given time of arrival to a context
+//
+static void ppg_cs_feed_context_at(void *context, 
+                                   char *event_string, 
+                                   PPG_Time time)
+{
+   for(int i = 0; event_string[i] != '\0'; ++i) {
+      
+      PPG_Event event = {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(event_string[i]),
+         .time = time,
+         .flags = isupper(event_string[i]) ? 
+                        PPG_Event_Active : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ppg_ctx_event_process_batch(context, &event, 1);
+   }
+}
+
+static void *ppg_cs_contexts[3] = { NULL, NULL, NULL };
+static bool ppg_cs_feeding = false;
+static int ppg_cs_feed_choice = 0;
+static PPG_Time ppg_cs_feed_time = 0;
+
+// On the first timeout, passes an event to one of the other 
+// contexts. All contexts are scheduled in the same slot of 
+// the timer wheel.
+//
+static void ppg_cs_feed_other_context(PPG_Signal_Id signal_id, 
+                                      void *user_data)
+{
+   if((signal_id == PPG_On_Timeout) && ppg_cs_feeding) {
+      
+      ppg_cs_feeding = false;
+      
+      void *others[2];
+      int n_others = 0;
+      
+      for(int i = 0; i < 3; ++i) {
+         if(ppg_cs_contexts[i] != ppg_global_get_current_context()) {
+            others[n_others] = ppg_cs_contexts[i];
+            ++n_others;
+         }
+      }
+      
+      ppg_cs_feed_context_at(others[ppg_cs_feed_choice], "B", 
+                             ppg_cs_feed_time);
+   }
+   
+   ppg_cs_on_signal(signal_id, user_data);
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   void *context_1 = ppg_context_create_shared(ppg_global_get_current_context());
+   void *context_2 = ppg_context_create_shared(ppg_global_get_current_context());
+   
+   void *timer_wheel = ppg_timer_wheel_create(10, 0);
+   
+   ppg_timer_wheel_register_context(timer_wheel, context_1);
+   ppg_timer_wheel_register_context(timer_wheel, context_2);
+   
+   ppg_cs_feed_context_at(context_1, "A", 0);
+   ppg_cs_feed_context_at(context_2, "A", 1000);
+   
+   // Nothing must happen before the timeout of the first context
+   //
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, PPG_CS_Timeout_MS) == 0);
+   
+   // Only the first context times out
+   //
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 
+                                  PPG_CS_Timeout_MS + 10) == 1);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("A")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // The second context completes its chord before its timeout
+   //
+   ppg_cs_feed_context_at(context_2, "BCcba", 1100);
+   
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 5000) == 0);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   // Deadlines far beyond the range of the lower levels of the wheel
+   //
+   ppg_cs_feed_context_at(context_1, "A", 100000);
+   
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 
+                                  100000 + PPG_CS_Timeout_MS) == 0);
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 
+                                  100000 + PPG_CS_Timeout_MS + 10) == 1);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("A")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   // A timeout that is signaled while a slot is processed 
+   // schedules another entry of the same slot. Depending on the 
+   // choice, the entry is in the middle or at the end of the slot.
+   //
+   void *context_3 = ppg_context_create_shared(ppg_global_get_current_context());
+   
+   ppg_timer_wheel_register_context(timer_wheel, context_3);
+   
+   ppg_cs_contexts[0] = context_1;
+   ppg_cs_contexts[1] = context_2;
+   ppg_cs_contexts[2] = context_3;
+   
+   PPG_Signal_Callback feed_callback = {
+      .func = ppg_cs_feed_other_context,
+      .user_data = NULL
+   };
+   
+   PPG_Signal_Callback old_callback = ppg_global_get_signal_callback();
+   
+   void *context_main = ppg_global_get_current_context();
+   
+   for(int i = 0; i < 3; ++i) {
+      ppg_global_set_current_context(ppg_cs_contexts[i]);
+      ppg_global_set_signal_callback(feed_callback);
+   }
+   
+   ppg_global_set_current_context(context_main);
+   
+   PPG_Time time = 200000;
+   
+   for(ppg_cs_feed_choice = 0; ppg_cs_feed_choice < 2; ++ppg_cs_feed_choice) {
+      
+      for(int i = 0; i < 3; ++i) {
+         ppg_cs_feed_context_at(ppg_cs_contexts[i], "A", time);
+      }
+      
+      ppg_cs_feeding = true;
+      ppg_cs_feed_time = time + PPG_CS_Timeout_MS;
+      
+      // The context that is fed does not time out
+      //
+      PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 
+                                    time + PPG_CS_Timeout_MS + 10) == 2);
+      PPG_CS_CHECK(!ppg_cs_feeding);
+      
+      PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 
+                                    time + PPG_CS_Timeout_MS + 20) == 0);
+      PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, 
+                                    time + 2*PPG_CS_Timeout_MS + 20) == 1);
+      
+      PPG_CS_CHECK_NO_PROCESS(
+                              PPG_CS_EXPECT_FLUSH("AAAB")
+                              PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                              PPG_CS_EXPECT_NO_ACTIONS
+      );
+      
+      time += 100000;
+   }
+   
+   for(int i = 0; i < 3; ++i) {
+      ppg_global_set_current_context(ppg_cs_contexts[i]);
+      ppg_global_set_signal_callback(old_callback);
+   }
+   
+   ppg_global_set_current_context(context_main);
+   
+   ppg_context_destroy(context_3);
+   
+   // Destroying a context unregisters it
+   //
+   ppg_context_destroy(context_1);
+   
+   ppg_timer_wheel_destroy(timer_wheel);
+   
+   //***********************************************
+   // Long timeouts with a fine resolution
+   //***********************************************
+   
+   // Advancing the wheel skips all ticks without scheduled contexts.
+   // Stepping through every tick would take very long here.
+   //
+   context_main = ppg_global_set_current_context(context_2);
+   
+   PPG_Time long_timeout = (PPG_Time)1 << 30;
+   
+   PPG_Time old_timeout = ppg_global_set_timeout(long_timeout);
+   
+   ppg_global_set_current_context(context_main);
+   
+   timer_wheel = ppg_timer_wheel_create(1, 0);
+   
+   ppg_timer_wheel_register_context(timer_wheel, context_2);
+   
+   ppg_cs_feed_context_at(context_2, "A", 0);
+   
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, long_timeout) == 0);
+   PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, long_timeout + 1) == 1);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("A")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   ppg_global_set_current_context(context_2);
+   ppg_global_set_timeout(old_timeout);
+   ppg_global_set_current_context(context_main);
+   
+   //***********************************************
+   // Pending work
+   //***********************************************
+   
+   // With a budget of one step, the events of the chord cannot
+   // be processed at once. The timer wheel resumes the pending work
+   // with a fresh budget at every tick.
+   //
+   ppg_global_set_current_context(context_2);
+   ppg_global_set_work_budget(1);
+   ppg_global_set_current_context(context_main);
+   
+   PPG_Time now = long_timeout + 10;
+   
+   PPG_Event events[3];
+   
+   for(int i = 0; i < 3; ++i) {
+      events[i] = (PPG_Event) {
+         .input = (PPG_Input_Id)(uintptr_t)('a' + i),
+         .time = now,
+         .flags = PPG_Event_Active,
+         .groupId = 0
+      };
+   }
+   
+   ppg_ctx_event_process_batch(context_2, events, 3);
+   
+   ppg_global_set_current_context(context_2);
+   PPG_CS_CHECK(ppg_event_work_pending());
+   ppg_global_set_current_context(context_main);
+   
+   bool work_pending = true;
+   
+   for(int i = 0; (i < 10) && work_pending; ++i) {
+      
+      ++now;
+      
+      PPG_CS_CHECK(ppg_timer_wheel_advance(timer_wheel, now) == 0);
+      
+      ppg_global_set_current_context(context_2);
+      work_pending = ppg_event_work_pending();
+      ppg_global_set_current_context(context_main);
+   }
+   
+   PPG_CS_CHECK(!work_pending);
+   
+   ppg_cs_feed_context_at(context_2, "cba", now);
+   
+   ppg_global_set_current_context(context_2);
+   while(ppg_event_process_pending()) {}
+   ppg_global_set_work_budget(0);
+   ppg_global_set_current_context(context_main);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord)
+                           )
+   );
+   
+   ppg_timer_wheel_destroy(timer_wheel);
+   
+   ppg_context_destroy(context_2);
+   
+PPG_CS_END_TEST
+
+#endif
@@ -0,0 +1,161 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "papageno_char_strings.h"
+
+#include <stdlib.h>
+
+#if !PPG_DISABLE_CONTEXT_SWITCHING
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+typedef struct {
+   int n_allocations;
+   int n_releases;
+} PPG_CS_Storage_Counts;
+
+static void *ppg_cs_storage_allocate(size_t n_bytes, void *user_data)
+{
+   ++((PPG_CS_Storage_Counts *)user_data)->n_allocations;
+   
+   return malloc(n_bytes);
+}
+
+static void ppg_cs_storage_release(void *memory, void *user_data)
+{
+   ++((PPG_CS_Storage_Counts *)user_data)->n_releases;
+   
+   free(memory);
+}
+
+// Registers enough patterns to require several arena chunks
+//
+static void ppg_cs_add_many_patterns(void)
+{
+   for(char c1 = 'a'; c1 <= 'm'; ++c1) {
+      for(char c2 = 'a'; c2 <= 'm'; ++c2) {
+         
+         ppg_sequence(
+            ppg_cs_layer_0,
+            PPG_ACTION_NOOP,
+            PPG_INPUTS(
+               PPG_CS_CHAR(c1),
+               PPG_CS_CHAR(c2),
+               PPG_CS_CHAR('z')
+            )
+         );
+      }
+   }
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Sequence)
+   
+   PPG_CS_Storage_Counts counts_1 = { .n_allocations = 0, .n_releases = 0 };
+   
+   ppg_global_set_tree_storage(
+      (PPG_Arena_Storage) {
+         .allocate = ppg_cs_storage_allocate,
+         .release = ppg_cs_storage_release,
+         .user_data = (void*)&counts_1
+      }
+   );
+   
+   ppg_cs_add_many_patterns();
+   
+   ppg_sequence(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Sequence),
+      PPG_INPUTS(
+         PPG_CS_CHAR('x'),
+         PPG_CS_CHAR('y'),
+         PPG_CS_CHAR('z')
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   PPG_CS_CHECK(counts_1.n_allocations > 0);
+   PPG_CS_CHECK(counts_1.n_releases == 0);
+   
+   size_t n_bytes_used = 0, n_bytes_reserved = 0;
+   ppg_global_get_tree_memory_usage(&n_bytes_used, &n_bytes_reserved);
+   
+   PPG_CS_CHECK(n_bytes_used > 0);
+   PPG_CS_CHECK(n_bytes_used <= n_bytes_reserved);
+   
+   PPG_CS_PROCESS_STRING(  "X x Y y Z z",
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Sequence)
+                           )
+   );
+   
+   // Destroying a context returns all chunks to their storage
+   //
+   PPG_CS_Storage_Counts counts_2 = { .n_allocations = 0, .n_releases = 0 };
+   
+   void* context_2 = ppg_context_create();
+   void* context_1 = ppg_global_set_current_context(context_2);
+   
+   ppg_global_set_tree_storage(
+      (PPG_Arena_Storage) {
+         .allocate = ppg_cs_storage_allocate,
+         .release = ppg_cs_storage_release,
+         .user_data = (void*)&counts_2
+      }
+   );
+   
+   ppg_cs_add_many_patterns();
+   
+   // Tokens that were created while another context was current
+   // stem from the arena of that context. Those tokens that are 
+   // merged with existing ones are released while this 
+   // context is current.
+   //
+   void* context_3 = ppg_context_create();
+   
+   ppg_global_set_current_context(context_3);
+   
+   PPG_Token tokens[3] = {
+      PPG_CS_N('a'),
+      PPG_CS_N('b'),
+      ppg_token_set_action(PPG_CS_N('q'), PPG_ACTION_NOOP)
+   };
+   
+   ppg_global_set_current_context(context_2);
+   
+   ppg_pattern(ppg_cs_layer_0, 3, tokens);
+   
+   ppg_global_compile();
+   
+   ppg_global_set_current_context(context_1);
+   
+   PPG_CS_CHECK(counts_2.n_allocations > 0);
+   
+   ppg_context_destroy(context_2);
+   
+   PPG_CS_CHECK(counts_2.n_releases == counts_2.n_allocations);
+   
+   ppg_context_destroy(context_3);
+   
+PPG_CS_END_TEST
+
+#endif
@@ -0,0 +1,272 @@
+/* Copyright 2017 noseglasses <shinynoseglasses@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "papageno_char_strings.h"
+
+#include <ctype.h>
+   
+enum {
+   ppg_cs_layer_0 = 0
+};
+
+// Converts a string of on-off characters to events that arrive 
+// one time unit after another, starting at the given time
+//
+static size_t ppg_cs_string_to_events(char *string, 
+                                      PPG_Time time,
+                                      PPG_Event *events)
+{
+   size_t n_events = 0;
+   
+   for(int i = 0; string[i] != '\0'; ++i) {
+      
+      if(string[i] == ' ') { continue; }
+      
+      events[n_events] = (PPG_Event) {
+         .input = (PPG_Input_Id)(uintptr_t)tolower(string[i]),
+         .time = time + (PPG_Time)n_events,
+         .flags = isupper(string[i]) ? PPG_Event_Active 
+                                     : PPG_Event_Flags_Empty,
+         .groupId = 0
+      };
+      
+      ++n_events;
+   }
+   
+   return n_events;
+}
+
+static int ppg_cs_n_dropped = 0;
+
+// Counts dropped events and forwards all signals to 
+// the default signal handler
+//
+static void ppg_cs_count_dropped(PPG_Signal_Id signal_id, void *user_data)
+{
+   if(signal_id == PPG_On_Event_Dropped) {
+      ++ppg_cs_n_dropped;
+   }
+   
+   ppg_cs_on_signal(signal_id, user_data);
+}
+
+// Resumes pending work until all work is done and returns
+// the number of calls that were necessary
+//
+static int ppg_cs_process_pending(void)
+{
+   int n_calls = 0;
+   
+   while(ppg_event_work_pending()) {
+      
+      #if PPG_HAVE_STATISTICS
+      PPG_Statistics before, after;
+      ppg_statistics_get(&before);
+      #endif
+      
+      ppg_event_process_pending();
+      
+      #if PPG_HAVE_STATISTICS
+      ppg_statistics_get(&after);
+      PPG_CS_CHECK(   after.n_token_checks - before.n_token_checks 
+             <= ppg_global_get_work_budget());
+      #endif
+      
+      ++n_calls;
+   }
+   
+   return n_calls;
+}
+
+PPG_CS_START_TEST
+
+   PPG_CS_REGISTER_ACTION(Chord)
+   PPG_CS_REGISTER_ACTION(Pattern)
+   
+   ppg_chord(
+      ppg_cs_layer_0,
+      PPG_CS_ACTION(Chord),
+      PPG_INPUTS(
+         PPG_CS_CHAR('a'),
+         PPG_CS_CHAR('b'),
+         PPG_CS_CHAR('c')
+      )
+   );
+   
+   ppg_pattern(
+      ppg_cs_layer_0,
+      PPG_TOKENS(
+         PPG_CS_N('a'),
+         PPG_CS_N('b'),
+         ppg_token_set_action(
+            PPG_CS_N('d'),
+            PPG_CS_ACTION(Pattern)
+         )
+      )
+   );
+   
+   ppg_cs_compile();
+   
+   PPG_Event events[32];
+   
+   PPG_CS_CHECK(ppg_global_get_work_budget() == 0);
+   
+   //***********************************************
+   // Without a budget, all work is done immediately
+   //***********************************************
+   
+   size_t n_events = ppg_cs_string_to_events("A a B b D d", 1000, events);
+   
+   ppg_event_process_batch(events, n_events);
+   
+   PPG_CS_CHECK(!ppg_event_work_pending());
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   //***********************************************
+   // A budget of a single step per call yields the 
+   // same results
+   //***********************************************
+   
+   PPG_CS_CHECK(ppg_global_set_work_budget(1) == 0);
+   
+   n_events = ppg_cs_string_to_events("A a B b D d", 2000, events);
+   
+   ppg_event_process_batch(events, n_events);
+   
+   PPG_CS_CHECK(ppg_event_work_pending());
+   
+   PPG_CS_CHECK(ppg_cs_process_pending() > 0);
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   // Events that are passed while work is pending are 
+   // processed in the order of their arrival
+   //
+   n_events = ppg_cs_string_to_events("A B C c b a A a B b D d", 3000, events);
+   
+   for(size_t i = 0; i < n_events; ++i) {
+      ppg_event_process_batch(&events[i], 1);
+   }
+   
+   ppg_cs_process_pending();
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Chord),
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   //***********************************************
+   // Timeouts are concluded once all branch options 
+   // have been processed
+   //***********************************************
+   
+   n_events = ppg_cs_string_to_events("A", 4000, events);
+   
+   ppg_event_process_batch(events, n_events);
+   
+   ppg_cs_process_pending();
+   
+   // The deactivation arrives too late
+   //
+   n_events = ppg_cs_string_to_events("a", 
+                                      4000 + 2*PPG_CS_Timeout_MS, 
+                                      events);
+   
+   ppg_event_process_batch(events, n_events);
+   
+   ppg_cs_process_pending();
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_FLUSH("Aa")
+                           PPG_CS_EXPECT_EXCEPTIONS(PPG_CS_ET)
+                           PPG_CS_EXPECT_NO_ACTIONS
+   );
+   
+   //***********************************************
+   // Events that arrive while the ring of deferred 
+   // events is full are dropped and signaled
+   //***********************************************
+   
+   // Capacities are rounded up to powers of two
+   //
+   size_t old_capacity = ppg_global_set_deferred_event_capacity(3);
+   
+   PPG_CS_CHECK(old_capacity >= PPG_MAX_EVENTS);
+   PPG_CS_CHECK(ppg_global_set_deferred_event_capacity(2) == 4);
+   PPG_CS_CHECK(ppg_global_get_deferred_event_capacity() == 2);
+   
+   PPG_Signal_Callback old_callback
+      = ppg_global_set_signal_callback(
+            (PPG_Signal_Callback) {
+               .func = ppg_cs_count_dropped,
+               .user_data = NULL
+            }
+      );
+   
+   n_events = ppg_cs_string_to_events("A a B b D d", 
+                                      5000 + 2*PPG_CS_Timeout_MS, 
+                                      events);
+   
+   // With a budget of a single step, the first two events are processed 
+   // and the next two are deferred. The ring is then full and the 
+   // remaining events are dropped.
+   //
+   ppg_event_process_batch(events, n_events);
+   
+   PPG_CS_CHECK(ppg_event_work_pending());
+   PPG_CS_CHECK(ppg_cs_n_dropped == 2);
+   
+   ppg_cs_process_pending();
+   
+   // Passing the dropped events again completes the pattern
+   //
+   ppg_event_process_batch(&events[4], 2);
+   
+   ppg_cs_process_pending();
+   
+   PPG_CS_CHECK_NO_PROCESS(
+                           PPG_CS_EXPECT_EMPTY_FLUSH
+                           PPG_CS_EXPECT_NO_EXCEPTIONS
+                           PPG_CS_EXPECT_ACTION_SERIES(
+                              PPG_CS_A(Pattern)
+                           )
+   );
+   
+   ppg_global_set_signal_callback(old_callback);
+   
+   ppg_global_set_deferred_event_capacity(old_capacity);
+   
+   PPG_CS_CHECK(ppg_global_set_work_budget(0) == 1);
+   
+PPG_CS_END_TEST